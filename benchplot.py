@@ -1,40 +1,76 @@
 import argparse
+import json
 import matplotlib.pyplot as plt
 import numpy as np
 
 
+def get_columns(filename):
+    with open(filename) as f:
+        return f.readline().strip().split(',')
+
+
+def get_groups(columns):
+    # Every algorithm selected in the benchmark has a distance, expanded nodes, time,
+    # allocations and peak bytes column named after it, followed by its performance
+    # counters if they were recorded
+    return [(column[:-len('Dist')], first) for first, column in enumerate(columns)
+            if column.endswith('Dist')]
+
+
 def get_data(filename):
+    columns = get_columns(filename)
     return np.genfromtxt(filename,
                          delimiter=',',
                          skip_header=1,
-                         dtype="i8,i8,f8,i8,i8,f8,i8,i8,f8,i8,i8,f8")
+                         dtype=",".join("i8" if column.endswith('Nodes') else "f8"
+                                        for column in columns))
 
 
-def plot(data):
+def plot(data, columns):
     plt.figure()
     plt.title("Benchmark")
     plt.xlabel('Optimal distance to goal')
     plt.ylabel('Nodes expanded')
 
-    # Dijkstra
-    plt.scatter(data['f0'], data['f1'],
-                label="Dijkstra", marker='x')
-
-    # A*
-    plt.scatter(data['f0'], data['f4'],
-                label="A*", marker='x')
+    # The distances are Dijkstra's if it ran, or the ones of the first algorithm
+    distance = 'f' + str(columns.index('dijkstraDist')) if 'dijkstraDist' in columns else 'f0'
+    for name, first in get_groups(columns):
+        plt.scatter(data[distance], data['f' + str(first + 1)], label=name, marker='x')
 
     plt.legend()
     plt.show()
 
 
+def plot_report(filename):
+    # A report of the benchmark has the results of every query of each graph run
+    with open(filename) as f:
+        report = json.load(f)
+    for graph in report['graphs']:
+        algorithms = graph['algorithms']
+        reference = next((algorithm for algorithm in algorithms
+                          if algorithm['name'] == 'dijkstra'), algorithms[0])
+        plt.figure()
+        plt.title("Benchmark of {} ({}), commit {}".format(graph['file'], graph['type'],
+                                                         report['commit']))
+        plt.xlabel('Optimal distance to goal')
+        plt.ylabel('Nodes expanded')
+        for algorithm in algorithms:
+            plt.scatter(reference['distances'], algorithm['expandedNodes'],
+                        label=algorithm['name'], marker='x')
+        plt.legend()
+    plt.show()
+
+
 def main():
     parser = argparse.ArgumentParser()
     parser.add_argument('-f', type=str, help="Filename with the benchmark data", required=True)
     args = parser.parse_args()
 
+    if args.f.endswith('.json'):
+        plot_report(args.f)
+        return
     data = get_data(args.f)
-    plot(data)
+    plot(data, get_columns(args.f))
 
 
 if __name__ == "__main__":
@@ -12,6 +12,10 @@ MOC_DIR = build
 UI_DIR = build
 INCLUDEPATH += src
 
+# Recorded in the benchmark results
+GIT_COMMIT = $$system(git rev-parse --short HEAD)
+!isEmpty(GIT_COMMIT): DEFINES += GIT_COMMIT=\\\"$$GIT_COMMIT\\\"
+
 FORMS += \
     ui/mainwindow.ui \
     ui/helpdialog.ui \
@@ -28,8 +32,28 @@ HEADERS += \
     src/csvencoder.h \
     src/benchmark.h \
     src/graph.hpp \
+    src/csrgraph.hpp \
+    src/searchworkspace.hpp \
+    src/priorityqueues.hpp \
+    src/reversegraph.hpp \
+    src/bidirectional.hpp \
     src/geolocationgraph.h \
-    src/gridgraph.h
+    src/gridgraph.h \
+    src/jps.h \
+    src/jpsplus.h \
+    src/hierarchical.h \
+    src/contraction.h \
+    src/landmarks.hpp \
+    src/incremental.hpp \
+    src/deltastepping.hpp \
+    src/threadpool.h \
+    src/batchsearch.hpp \
+    src/movingai.h \
+    src/algorithmregistry.hpp \
+    src/searchengines.h \
+    src/perfcounters.h \
+    src/allocationtracker.h \
+    src/json.h
 
 
 SOURCES += \
@@ -43,7 +67,17 @@ SOURCES += \
     src/csvencoder.cpp \
     src/benchmark.cpp \
     src/gridgraph.cpp \
-    src/geolocationgraph.cpp
+    src/geolocationgraph.cpp \
+    src/jps.cpp \
+    src/jpsplus.cpp \
+    src/hierarchical.cpp \
+    src/contraction.cpp \
+    src/threadpool.cpp \
+    src/movingai.cpp \
+    src/searchengines.cpp \
+    src/perfcounters.cpp \
+    src/allocationtracker.cpp \
+    src/json.cpp
 
 RESOURCES += \
     resources.qrc
@@ -0,0 +1,216 @@
+#ifndef ALGORITHMREGISTRY_H
+#define ALGORITHMREGISTRY_H
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "priorityqueues.hpp"
+#include "utils.h"
+
+/**
+ * @brief A pathfinding algorithm, with its heuristic and preprocessing, ready to answer
+ * queries on a graph.
+ */
+template <typename Graph>
+class SearchEngine
+{
+public:
+    typedef typename Graph::Node Node;
+
+public:
+    virtual ~SearchEngine() {}
+
+    /**
+     * @brief Finds a path between two nodes.
+     * @return The number of expanded nodes.
+     */
+    virtual unsigned long search(Node start, Node goal) = 0;
+
+    /**
+     * @return The cost of the path found by the last search, or -1 if there was none.
+     */
+    virtual double getCost() const = 0;
+
+    /**
+     * @return Every node of the path found by the last search, from the start to the
+     * goal, or an empty list if there was none.
+     */
+    virtual std::vector<Node> getPath() const = 0;
+
+    /**
+     * @return The cost to reach each node the last search reached, or only the ones on
+     * its path if the algorithm doesn't keep the others.
+     */
+    virtual std::map<Node, double> getCosts() const = 0;
+
+    /**
+     * @return The stats of the queue used by the last search, or nullptr if the
+     * algorithm doesn't keep a queue of its own.
+     */
+    virtual const QueueStats *getQueueStats() const
+    {
+        return nullptr;
+    }
+
+    /**
+     * @return The bytes used by the preprocessing of the engine, if it has any.
+     */
+    virtual size_t getMemoryUsage() const
+    {
+        return 0;
+    }
+
+    /**
+     * @return Details about the engine worth reporting, like the size of its
+     * preprocessing, or an empty string.
+     */
+    virtual std::string describe()
+    {
+        return "";
+    }
+};
+
+/**
+ * @brief List of the algorithms which can run on a kind of graph, each one registered
+ * with a name and a factory building its engine.
+ *
+ * The Context is what the engines of a graph share, like the graph itself and the
+ * workspace of the searches, and must define the type of the graph as Graph. Every
+ * combination of an algorithm and a heuristic is an entry of its own, so the engines are
+ * built with the heuristic known at compile time.
+ */
+template <typename Context>
+class AlgorithmRegistry
+{
+public:
+    typedef typename Context::Graph Graph;
+    typedef SearchEngine<Graph> Engine;
+    typedef std::function<Engine*(Context&)> Factory;
+
+    typedef struct Entry
+    {
+        std::string name;  // Unique, like "astar-manhattan", used on the command line
+        std::string title;  // Shown to users, the same for every heuristic
+        std::string heuristic;  // Empty if the algorithm doesn't use one
+        bool exact;  // Finds optimal paths, given an admissible heuristic
+        bool interactive;  // Follows the changes to the graph, so it can run while editing
+        Factory create;
+    } Entry;
+
+public:
+    /**
+     * @brief Registers an algorithm, named after its title and heuristic.
+     * @throws std::invalid_argument if the name is already registered.
+     */
+    void add(const std::string &name, const std::string &title,
+             const std::string &heuristic, bool exact, bool interactive, Factory create)
+    {
+        if (find(name))
+        {
+            throw std::invalid_argument("Algorithm " + name + " is already registered");
+        }
+        entries.push_back(Entry{name, title, heuristic, exact, interactive, create});
+    }
+
+    /**
+     * @return Every registered algorithm, in the order they were registered.
+     */
+    const std::vector<Entry> &getEntries() const
+    {
+        return entries;
+    }
+
+    /**
+     * @return The algorithm with the given name, or nullptr if there's none.
+     */
+    const Entry *find(const std::string &name) const
+    {
+        for (const Entry &entry : entries)
+        {
+            if (entry.name == name)
+            {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * @return The algorithm with the given title using the given heuristic, or the
+     * one with that title if it doesn't use any, or nullptr if there's none.
+     */
+    const Entry *find(const std::string &title, const std::string &heuristic) const
+    {
+        for (const Entry &entry : entries)
+        {
+            if (entry.title == title
+                    && (entry.heuristic.empty() || entry.heuristic == heuristic))
+            {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * @return The titles of the registered algorithms, each one once, in the order they
+     * were registered.
+     * @param interactiveOnly Whether to leave out the algorithms which can't run while
+     * the graph is edited.
+     */
+    std::vector<std::string> getTitles(bool interactiveOnly) const
+    {
+        std::vector<std::string> titles;
+        for (const Entry &entry : entries)
+        {
+            if ((entry.interactive || !interactiveOnly)
+                    && std::find(titles.begin(), titles.end(), entry.title) == titles.end())
+            {
+                titles.push_back(entry.title);
+            }
+        }
+        return titles;
+    }
+
+    /**
+     * @return true if the algorithm with the given title is registered with heuristics.
+     */
+    bool usesHeuristic(const std::string &title) const
+    {
+        for (const Entry &entry : entries)
+        {
+            if (entry.title == title && !entry.heuristic.empty())
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @return The algorithms named in a comma-separated list, in its order.
+     * @throws std::invalid_argument if a name isn't registered.
+     */
+    std::vector<const Entry*> select(const std::string &names) const
+    {
+        std::vector<const Entry*> selected;
+        for (const std::string &name : splitLine(names))
+        {
+            const Entry *entry = find(name);
+            if (!entry)
+            {
+                throw std::invalid_argument("Unknown algorithm " + name);
+            }
+            selected.push_back(entry);
+        }
+        return selected;
+    }
+
+private:
+    std::vector<Entry> entries;
+};
+
+#endif // ALGORITHMREGISTRY_H
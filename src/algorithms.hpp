@@ -10,7 +10,16 @@
 #include <vector>
 #include "gridgraph.h"
 #include "geolocationgraph.h"
+#include "priorityqueues.hpp"
+#include "searchworkspace.hpp"
 
+/**
+ * Type-erased heuristic, for callers which pick the heuristic at runtime, like the GUI.
+ *
+ * aStar and greedyBestFirstSearch take any callable as their heuristic, so the functors
+ * below are preferred wherever the heuristic is known at compile time, as calls to them
+ * can be inlined into the search loop.
+ */
 template <class Node>
 using Heuristic = typename std::function<double(Node, Node)>;
 
@@ -39,27 +48,53 @@ std::vector<Node> reconstructPath(Node start,
     return path;
 }
 
+/**
+ * Reconstructs the path from start to goal found by the last search run with a workspace.
+ */
+template <typename Graph>
+std::vector<typename Graph::Node> reconstructPath(typename Graph::Node start,
+                                                  typename Graph::Node goal,
+                                                  const SearchWorkspace<Graph> &workspace)
+{
+    std::vector<typename Graph::Node> path;
+    typename Graph::Node current = goal;
+    // Follow the path backwards until we reach the starting node
+    while (current != start)
+    {
+        path.push_back(current);
+        current = workspace.getPrevious(current);
+    }
+    path.push_back(start);
+    // Reverse so that it starts with start and ends with goal
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
 /**
  * Compute the path between two nodes using Breadth-first search with early exit.
+ *
+ * The search state can be a MapSearchState or a SearchWorkspace, and is reset before
+ * starting.
  */
-template <typename Node, typename Graph>
+template <typename Node, typename Graph, typename State>
 unsigned long bfs(Graph *graph,
                   Node start,
                   Node goal,
-                  std::map<Node, Node> &previous,
-                  std::map<Node, double> &costToNode)
+                  State &state)
 {
     unsigned long expandedNodes = 0;
     std::queue<Node> nodeQueue;
     nodeQueue.push(start);
 
-    previous[start] = start;
+    state.reset();
+    state.update(start, start, 0);
 
     while (!nodeQueue.empty())
     {
         // Get next node to examine
         Node current = nodeQueue.front();
         nodeQueue.pop();
+        state.close(current);
         ++expandedNodes;
 
         // Early exit condition
@@ -69,43 +104,63 @@ unsigned long bfs(Graph *graph,
         }
 
         // Push unvisited neighbors to queue and update total cost to reach them
-        for (Node next : graph->neighbors(current))
-        {
-            if (previous.find(next) == previous.end())
+        double currentCost = state.getCost(current);
+        graph->forEachNeighbor(current, [&](Node next, double edgeCost) {
+            if (!state.isVisited(next))
             {
-                double cost = costToNode[current] + graph->getCost(next, current);
-                costToNode[next] = cost;
-                previous[next] = current;
+                state.update(next, current, currentCost + edgeCost);
                 nodeQueue.push(next);
             }
-        }
+        });
     }
     return expandedNodes;
 }
 
 /**
- * Compute the optimal path between two nodes using Dijkstra's algorithm with early exit.
+ * Compute the path between two nodes using Breadth-first search with early exit.
  */
 template <typename Node, typename Graph>
+unsigned long bfs(Graph *graph,
+                  Node start,
+                  Node goal,
+                  std::map<Node, Node> &previous,
+                  std::map<Node, double> &costToNode)
+{
+    MapSearchState<Node> state(previous, costToNode);
+    return bfs(graph, start, goal, state);
+}
+
+/**
+ * Compute the optimal path between two nodes using Dijkstra's algorithm with early exit.
+ *
+ * The search state can be a MapSearchState or a SearchWorkspace, and the queue any of the
+ * queues in priorityqueues.hpp. Both are reset before starting, and the queue's stats
+ * can be read once the search is done.
+ */
+template <typename Node, typename Graph, typename State, typename Queue>
 unsigned long dijkstra(Graph *graph,
                        Node start,
                        Node goal,
-                       std::map<Node, Node> &previous,
-                       std::map<Node, double> &costToNode)
+                       State &state,
+                       Queue &nodeQueue)
 {
-    typedef std::pair<double, Node> queuePair;
-    std::priority_queue<queuePair, std::vector<queuePair>,
-            std::greater<queuePair>> nodeQueue;
-    nodeQueue.emplace(0, start);
+    nodeQueue.clear();
+    nodeQueue.push(start, 0);
     unsigned long expandedNodes = 0;
 
-    previous[start] = start;
+    state.reset();
+    state.update(start, start, 0);
 
     while (!nodeQueue.empty())
     {
         // Get next node to examine
-        Node current = nodeQueue.top().second;
-        nodeQueue.pop();
+        Node current = nodeQueue.pop();
+        // Skip outdated queue entries of nodes that were already expanded
+        if (state.isClosed(current))
+        {
+            continue;
+        }
+        state.close(current);
         ++expandedNodes;
 
         // Early exit condition
@@ -115,22 +170,208 @@ unsigned long dijkstra(Graph *graph,
         }
 
         // Push unvisited neighbors to queue
-        for (Node next : graph->neighbors(current))
-        {
-            double cost = costToNode[current] + graph->getCost(next, current);
+        double currentCost = state.getCost(current);
+        graph->forEachNeighbor(current, [&](Node next, double edgeCost) {
+            double cost = currentCost + edgeCost;
             // Also consider visited nodes which would have a lesser cost from this new path
-            if (previous.find(next) == previous.end()
-                    || cost < costToNode[next])
+            if (!state.isVisited(next) || cost < state.getCost(next))
             {
-                costToNode[next] = cost;
-                previous[next] = current;
-                nodeQueue.emplace(cost, next);
+                state.update(next, current, cost);
+                nodeQueue.push(next, cost);
             }
+        });
+    }
+    return expandedNodes;
+}
+
+/**
+ * Compute the optimal path between two nodes using Dijkstra's algorithm with early exit,
+ * using a BinaryHeapQueue.
+ */
+template <typename Node, typename Graph, typename State>
+unsigned long dijkstra(Graph *graph,
+                       Node start,
+                       Node goal,
+                       State &state)
+{
+    BinaryHeapQueue<Node> nodeQueue;
+    return dijkstra(graph, start, goal, state, nodeQueue);
+}
+
+/**
+ * Highest tile cost for which searches on a GridGraph can use a BucketQueue, which needs
+ * a bucket for each cost.
+ */
+const int MAX_BUCKET_QUEUE_COST = 1024;
+
+/**
+ * @return true if every walkable tile of the grid has an integral cost no higher than
+ * MAX_BUCKET_QUEUE_COST, so a BucketQueue can be used to search it.
+ */
+inline bool canUseBucketQueue(const GridGraph *graph)
+{
+    return graph->hasIntegralCosts() && graph->getMaxCost() <= MAX_BUCKET_QUEUE_COST;
+}
+
+/**
+ * @return A bucket queue of the calling thread for priorities up to the highest tile cost
+ * of the grid plus extraSpread over the lowest one. It's kept between calls, like the one
+ * of GridSearchContext, so searches don't allocate its buckets every time.
+ */
+inline BucketQueue<Tile> &threadBucketQueue(const GridGraph *graph, int extraSpread)
+{
+    int maxSpread = int(graph->getMaxCost()) + extraSpread;
+    static thread_local BucketQueue<Tile> queue(maxSpread);
+    queue.reserveSpread(maxSpread);
+    return queue;
+}
+
+/**
+ * Compute the optimal path between two tiles using Dijkstra's algorithm with early exit,
+ * using a BucketQueue if the grid costs allow it and a BinaryHeapQueue otherwise.
+ */
+template <typename State>
+unsigned long dijkstra(GridGraph *graph,
+                       Tile start,
+                       Tile goal,
+                       State &state)
+{
+    if (canUseBucketQueue(graph))
+    {
+        return dijkstra(graph, start, goal, state, threadBucketQueue(graph, 0));
+    }
+    BinaryHeapQueue<Tile> nodeQueue;
+    return dijkstra(graph, start, goal, state, nodeQueue);
+}
+
+/**
+ * Compute the optimal path between two nodes using Dijkstra's algorithm with early exit.
+ */
+template <typename Node, typename Graph>
+unsigned long dijkstra(Graph *graph,
+                       Node start,
+                       Node goal,
+                       std::map<Node, Node> &previous,
+                       std::map<Node, double> &costToNode)
+{
+    MapSearchState<Node> state(previous, costToNode);
+    return dijkstra(graph, start, goal, state);
+}
+
+/**
+ * Compute the optimal paths from a node to several others using Dijkstra's algorithm,
+ * stopping once all of them have been expanded.
+ *
+ * The goals are closed in the state when the search ends, unless they can't be reached.
+ */
+template <typename Node, typename Graph, typename State, typename Queue>
+unsigned long dijkstraToMany(Graph *graph,
+                             Node start,
+                             const std::vector<Node> &goals,
+                             State &state,
+                             Queue &nodeQueue)
+{
+    // Goals can be repeated, and each one only counts once
+    std::vector<Node> pending(goals);
+    std::sort(pending.begin(), pending.end());
+    pending.erase(std::unique(pending.begin(), pending.end()), pending.end());
+    size_t remaining = pending.size();
+
+    nodeQueue.clear();
+    nodeQueue.push(start, 0);
+    unsigned long expandedNodes = 0;
+
+    state.reset();
+    state.update(start, start, 0);
+
+    while (!nodeQueue.empty() && remaining > 0)
+    {
+        Node current = nodeQueue.pop();
+        if (state.isClosed(current))
+        {
+            continue;
         }
+        state.close(current);
+        ++expandedNodes;
+
+        if (std::binary_search(pending.begin(), pending.end(), current))
+        {
+            --remaining;
+        }
+
+        double currentCost = state.getCost(current);
+        graph->forEachNeighbor(current, [&](Node next, double edgeCost) {
+            double cost = currentCost + edgeCost;
+            if (!state.isVisited(next) || cost < state.getCost(next))
+            {
+                state.update(next, current, cost);
+                nodeQueue.push(next, cost);
+            }
+        });
     }
     return expandedNodes;
 }
 
+/**
+ * Compute the optimal costs from every source to every target with a one-to-many
+ * Dijkstra search from each source.
+ *
+ * @return The costs in row-major order, with a row for each source and a column for each
+ * target, and -1 for the targets which can't be reached.
+ */
+template <typename Node, typename Graph, typename State, typename Queue>
+std::vector<double> distanceTable(Graph *graph,
+                                  const std::vector<Node> &sources,
+                                  const std::vector<Node> &targets,
+                                  State &state,
+                                  Queue &nodeQueue)
+{
+    std::vector<double> table(sources.size() * targets.size(), -1);
+    for (size_t i = 0; i < sources.size(); ++i)
+    {
+        dijkstraToMany(graph, sources[i], targets, state, nodeQueue);
+        for (size_t j = 0; j < targets.size(); ++j)
+        {
+            if (state.isClosed(targets[j]))
+            {
+                table[i * targets.size() + j] = state.getCost(targets[j]);
+            }
+        }
+    }
+    return table;
+}
+
+/**
+ * Compute the optimal costs from every source to every target, using a SearchWorkspace
+ * and an IndexedHeapQueue.
+ */
+template <typename Graph>
+std::vector<double> distanceTable(Graph *graph,
+                                  const std::vector<typename Graph::Node> &sources,
+                                  const std::vector<typename Graph::Node> &targets)
+{
+    SearchWorkspace<Graph> state(graph);
+    IndexedHeapQueue<Graph> nodeQueue(graph);
+    return distanceTable(graph, sources, targets, state, nodeQueue);
+}
+
+/**
+ * Compute the optimal costs from every source tile to every target tile, using a
+ * BucketQueue if the grid costs allow it and an IndexedHeapQueue otherwise.
+ */
+inline std::vector<double> distanceTable(GridGraph *graph,
+                                         const std::vector<Tile> &sources,
+                                         const std::vector<Tile> &targets)
+{
+    SearchWorkspace<GridGraph> state(graph);
+    if (canUseBucketQueue(graph))
+    {
+        return distanceTable(graph, sources, targets, state, threadBucketQueue(graph, 0));
+    }
+    IndexedHeapQueue<GridGraph> nodeQueue(graph);
+    return distanceTable(graph, sources, targets, state, nodeQueue);
+}
+
 /**
  * @brief Compute the Manhattan distance between two tiles.
  */
@@ -192,31 +433,123 @@ inline double haversineDistance(Geolocation a, Geolocation b)
     return 2 * a.radius * std::asin(asinArgument);
 }
 
+/**
+ * @brief Heuristic which always estimates 0, which turns A* into Dijkstra's algorithm.
+ */
+struct ZeroDistance
+{
+    template <typename Node>
+    double operator()(const Node &, const Node &) const
+    {
+        return 0;
+    }
+};
+
+/**
+ * @brief Manhattan distance between two tiles, as a functor which can be inlined.
+ */
+struct ManhattanDistance
+{
+    double operator()(Tile a, Tile b) const
+    {
+        return manhattanDistance(a, b);
+    }
+};
+
+/**
+ * @brief Euclidean distance between two tiles, as a functor which can be inlined.
+ */
+struct EuclideanDistance
+{
+    double operator()(Tile a, Tile b) const
+    {
+        return euclideanDistance(a, b);
+    }
+};
+
+/**
+ * @brief Chebyshev distance between two tiles, as a functor which can be inlined.
+ */
+struct ChebyshevDistance
+{
+    double operator()(Tile a, Tile b) const
+    {
+        return chebyshevDistance(a, b);
+    }
+};
+
+/**
+ * @brief Octile distance between two tiles, as a functor which can be inlined.
+ */
+struct OctileDistance
+{
+    double operator()(Tile a, Tile b) const
+    {
+        return octileDistance(a, b);
+    }
+};
+
+/**
+ * @brief Straight line distance between two nodes of a GeolocationGraph, looked up in the
+ * table the graph was built from.
+ */
+struct LinearDistance3D
+{
+    const GeolocationTable *table;
+
+    double operator()(int a, int b) const
+    {
+        return table->euclideanDistance3D(a, b);
+    }
+};
+
+/**
+ * @brief Distance along the Earth's surface between two nodes of a GeolocationGraph,
+ * looked up in the table the graph was built from.
+ */
+struct HaversineDistance
+{
+    const GeolocationTable *table;
+
+    double operator()(int a, int b) const
+    {
+        return table->haversineDistance(a, b);
+    }
+};
+
 /**
  * Compute the optimal path between two nodes using the A* algorithm with early exit.
+ *
+ * The search state can be a MapSearchState or a SearchWorkspace, and the queue any of the
+ * queues in priorityqueues.hpp. Both are reset before starting, and the queue's stats
+ * can be read once the search is done.
  */
-template <typename Node, typename Graph>
+template <typename Node, typename Graph, typename State, typename Queue,
+          typename HeuristicFunction>
 unsigned long aStar(Graph *graph,
                     Node start,
                     Node goal,
-                    std::map<Node, Node> &previous,
-                    std::map<Node, double> &costToNode,
-                    Heuristic<Node> heuristic)
-
+                    State &state,
+                    Queue &nodeQueue,
+                    HeuristicFunction heuristic)
 {
-    typedef std::pair<double, Node> queuePair;
-    std::priority_queue<queuePair, std::vector<queuePair>,
-            std::greater<queuePair>> nodeQueue;
-    nodeQueue.emplace(0, start);
+    nodeQueue.clear();
+    nodeQueue.push(start, heuristic(start, goal));
     unsigned long expandedNodes = 0;
 
-    previous[start] = start;
+    state.reset();
+    state.update(start, start, 0);
 
     while (!nodeQueue.empty())
     {
         // Get next node to examine
-        Node current = nodeQueue.top().second;
-        nodeQueue.pop();
+        Node current = nodeQueue.pop();
+        // Skip outdated queue entries of nodes that were already expanded
+        if (state.isClosed(current))
+        {
+            continue;
+        }
+        state.close(current);
         ++expandedNodes;
 
         // Early exit condition
@@ -226,33 +559,86 @@ unsigned long aStar(Graph *graph,
         }
 
         // Push unvisited neighbors to queue
-        for (Node next : graph->neighbors(current))
-        {
-            double cost = costToNode[current] + graph->getCost(next, current);
+        double currentCost = state.getCost(current);
+        graph->forEachNeighbor(current, [&](Node next, double edgeCost) {
+            double cost = currentCost + edgeCost;
             // Also consider visited nodes which would have a lesser cost from this new path
-            if (previous.find(next) == previous.end()
-                    || cost < costToNode[next])
+            if (!state.isVisited(next) || cost < state.getCost(next))
             {
-                costToNode[next] = cost;
+                state.update(next, current, cost);
                 double priority = cost + heuristic(next, goal);
-                previous[next] = current;
-                nodeQueue.emplace(priority, next);
+                nodeQueue.push(next, priority);
             }
-        }
+        });
     }
     return expandedNodes;
 }
 
+/**
+ * Compute the optimal path between two nodes using the A* algorithm with early exit,
+ * using a BinaryHeapQueue.
+ */
+template <typename Node, typename Graph, typename State, typename HeuristicFunction>
+unsigned long aStar(Graph *graph,
+                    Node start,
+                    Node goal,
+                    State &state,
+                    HeuristicFunction heuristic)
+{
+    BinaryHeapQueue<Node> nodeQueue;
+    return aStar(graph, start, goal, state, nodeQueue, heuristic);
+}
+
+/**
+ * Compute the optimal path between two tiles using the A* algorithm with the Manhattan
+ * distance and early exit, using a BucketQueue if the grid is 4-connected and its costs
+ * allow it, and a BinaryHeapQueue otherwise.
+ */
+template <typename State>
+unsigned long aStar(GridGraph *graph,
+                    Tile start,
+                    Tile goal,
+                    State &state,
+                    ManhattanDistance heuristic)
+{
+    // The Manhattan distance changes by one on every straight move, so priorities can
+    // exceed the lowest one in the queue by one more than the highest tile cost
+    if (canUseBucketQueue(graph) && !graph->isDiagonalAllowed())
+    {
+        return aStar(graph, start, goal, state, threadBucketQueue(graph, 1), heuristic);
+    }
+    BinaryHeapQueue<Tile> nodeQueue;
+    return aStar(graph, start, goal, state, nodeQueue, heuristic);
+}
+
+/**
+ * Compute the optimal path between two nodes using the A* algorithm with early exit.
+ */
+template <typename Node, typename Graph, typename HeuristicFunction>
+unsigned long aStar(Graph *graph,
+                    Node start,
+                    Node goal,
+                    std::map<Node, Node> &previous,
+                    std::map<Node, double> &costToNode,
+                    HeuristicFunction heuristic)
+
+{
+    MapSearchState<Node> state(previous, costToNode);
+    return aStar(graph, start, goal, state, heuristic);
+}
+
 /**
  * Compute the path between two nodes using the greedy best-first search algorithm with early exit.
+ *
+ * The search state can be a MapSearchState or a SearchWorkspace, and is reset before
+ * starting.
  */
-template <typename Node, typename Graph>
+template <typename Node, typename Graph, typename State, typename HeuristicFunction>
 unsigned long greedyBestFirstSearch(Graph *graph,
                                     Node start,
                                     Node goal,
-                                    std::map<Node, Node> &previous,
-                                    std::map<Node, double> &costToNode,
-                                    Heuristic<Node> heuristic)
+                                    State &state,
+                                    HeuristicFunction heuristic)
 {
     typedef std::pair<double, Node> queuePair;
     std::priority_queue<queuePair, std::vector<queuePair>,
@@ -260,13 +646,15 @@ unsigned long greedyBestFirstSearch(Graph *graph,
     nodeQueue.emplace(0, start);
     unsigned long expandedNodes = 0;
 
-    previous[start] = start;
+    state.reset();
+    state.update(start, start, 0);
 
     while (!nodeQueue.empty())
     {
         // Get next node to examine
         Node current = nodeQueue.top().second;
         nodeQueue.pop();
+        state.close(current);
         ++expandedNodes;
 
         // Early exit condition
@@ -276,20 +664,32 @@ unsigned long greedyBestFirstSearch(Graph *graph,
         }
 
         // Push unvisited neighbors to queue
-        for (Node next : graph->neighbors(current))
-        {
-            double cost = costToNode[current] + graph->getCost(next, current);
-            // Also consider visited nodes which would have a lesser cost from this new path
-            if (previous.find(next) == previous.end())
+        double currentCost = state.getCost(current);
+        graph->forEachNeighbor(current, [&](Node next, double edgeCost) {
+            if (!state.isVisited(next))
             {
-                costToNode[next] = cost;
+                state.update(next, current, currentCost + edgeCost);
                 double priority = heuristic(next, goal);
-                previous[next] = current;
                 nodeQueue.emplace(priority, next);
             }
-        }
+        });
     }
     return expandedNodes;
 }
 
+/**
+ * Compute the path between two nodes using the greedy best-first search algorithm with early exit.
+ */
+template <typename Node, typename Graph, typename HeuristicFunction>
+unsigned long greedyBestFirstSearch(Graph *graph,
+                                    Node start,
+                                    Node goal,
+                                    std::map<Node, Node> &previous,
+                                    std::map<Node, double> &costToNode,
+                                    HeuristicFunction heuristic)
+{
+    MapSearchState<Node> state(previous, costToNode);
+    return greedyBestFirstSearch(graph, start, goal, state, heuristic);
+}
+
 #endif // ALGORITMS_H
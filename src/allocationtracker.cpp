@@ -0,0 +1,150 @@
+#include "allocationtracker.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Every block starts with its size, padded so the memory after it stays aligned for any
+// type
+static const size_t HEADER_SIZE = alignof(std::max_align_t);
+static_assert(HEADER_SIZE >= sizeof(size_t), "The header must hold the size of the block");
+
+// Counts of the open scope. Relaxed ordering is enough, as they're only read once the
+// searches are done. Live bytes can go below zero when blocks allocated before the scope
+// are freed.
+static std::atomic<bool> tracking(false);
+static std::atomic<unsigned long> allocationCount(0);
+static std::atomic<size_t> allocatedBytes(0);
+static std::atomic<long long> liveBytes(0);
+static std::atomic<long long> peakBytes(0);
+
+/**
+ * @return A block of the given size, counted if a scope is open, or nullptr if there's no
+ * memory left.
+ */
+static void *allocate(size_t size)
+{
+    // Blocks always keep their size, as they may be freed while a scope is open
+    char *block = static_cast<char*>(std::malloc(HEADER_SIZE + size));
+    if (!block)
+    {
+        return nullptr;
+    }
+    *reinterpret_cast<size_t*>(block) = size;
+    if (tracking.load(std::memory_order_relaxed))
+    {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+        long long live = liveBytes.fetch_add((long long)size, std::memory_order_relaxed)
+                + (long long)size;
+        long long peak = peakBytes.load(std::memory_order_relaxed);
+        while (live > peak && !peakBytes.compare_exchange_weak(peak, live,
+                                                               std::memory_order_relaxed))
+        {
+        }
+    }
+    return block + HEADER_SIZE;
+}
+
+/**
+ * @brief Calls the new handler until the block can be allocated, like the standard
+ * operator new does.
+ * @throws std::bad_alloc if there's no memory left and no new handler.
+ */
+static void *allocateOrThrow(size_t size)
+{
+    void *block;
+    while (!(block = allocate(size)))
+    {
+        std::new_handler handler = std::get_new_handler();
+        if (!handler)
+        {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+    return block;
+}
+
+static void release(void *pointer)
+{
+    if (!pointer)
+    {
+        return;
+    }
+    char *block = static_cast<char*>(pointer) - HEADER_SIZE;
+    if (tracking.load(std::memory_order_relaxed))
+    {
+        liveBytes.fetch_sub((long long)*reinterpret_cast<size_t*>(block),
+                            std::memory_order_relaxed);
+    }
+    std::free(block);
+}
+
+void *operator new(size_t size)
+{
+    return allocateOrThrow(size);
+}
+
+void *operator new[](size_t size)
+{
+    return allocateOrThrow(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return allocateOrThrow(size);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return nullptr;
+    }
+}
+
+void *operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void *pointer) noexcept
+{
+    release(pointer);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+    release(pointer);
+}
+
+void operator delete(void *pointer, const std::nothrow_t&) noexcept
+{
+    release(pointer);
+}
+
+void operator delete[](void *pointer, const std::nothrow_t&) noexcept
+{
+    release(pointer);
+}
+
+AllocationScope::AllocationScope()
+{
+    allocationCount.store(0, std::memory_order_relaxed);
+    allocatedBytes.store(0, std::memory_order_relaxed);
+    liveBytes.store(0, std::memory_order_relaxed);
+    peakBytes.store(0, std::memory_order_relaxed);
+    tracking.store(true, std::memory_order_relaxed);
+}
+
+AllocationScope::~AllocationScope()
+{
+    tracking.store(false, std::memory_order_relaxed);
+}
+
+AllocationStats AllocationScope::getStats() const
+{
+    return AllocationStats{allocationCount.load(std::memory_order_relaxed),
+                           allocatedBytes.load(std::memory_order_relaxed),
+                           size_t(peakBytes.load(std::memory_order_relaxed)),
+                           liveBytes.load(std::memory_order_relaxed)};
+}
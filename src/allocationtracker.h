@@ -0,0 +1,38 @@
+#ifndef ALLOCATIONTRACKER_H
+#define ALLOCATIONTRACKER_H
+
+#include <cstddef>
+
+/**
+ * @brief What was allocated with operator new while an AllocationScope was open.
+ */
+typedef struct AllocationStats
+{
+    unsigned long allocations;
+    size_t allocatedBytes;  // Total of every allocation, even the ones freed since
+    size_t peakBytes;  // Most bytes live at once, over the ones live when the scope opened
+    long long liveBytes;  // Bytes still live, over the ones live when the scope opened
+} AllocationStats;
+
+/**
+ * @brief Counts the allocations made with operator new, on every thread, while the scope
+ * is open.
+ *
+ * The global operator new and delete are replaced to keep the counts. Outside of a scope
+ * they only check a flag, so the rest of the program, like the batches run on the thread
+ * pool, doesn't pay for the counting. Scopes share the counts, so only one of them can be
+ * open at a time.
+ */
+class AllocationScope
+{
+public:
+    AllocationScope();
+    ~AllocationScope();
+
+    /**
+     * @return What was allocated since the scope was created.
+     */
+    AllocationStats getStats() const;
+};
+
+#endif // ALLOCATIONTRACKER_H
@@ -0,0 +1,134 @@
+#ifndef BATCHSEARCH_H
+#define BATCHSEARCH_H
+
+#include <algorithm>
+#include <vector>
+#include "algorithms.hpp"
+#include "priorityqueues.hpp"
+#include "searchworkspace.hpp"
+#include "threadpool.h"
+
+/**
+ * @brief Runs batches of independent queries on a shared graph over a ThreadPool.
+ *
+ * The graph is only read, so every thread searches it at once, each with its own
+ * workspace and queue, which are allocated once and reused by every batch. Results come
+ * back in the order of the queries.
+ */
+template <typename Graph, typename HeuristicFunction>
+class BatchSearch
+{
+public:
+    typedef typename Graph::Node Node;
+
+    enum eAlgorithm {DIJKSTRA, A_STAR, GREEDY_BEST_FIRST};
+
+    typedef struct Query
+    {
+        Node start, goal;
+        eAlgorithm algorithm;
+    } Query;
+
+    typedef struct Result
+    {
+        double cost;  // -1 if the goal can't be reached
+        unsigned long expandedNodes;
+        std::vector<Node> path;  // Only if paths are kept
+    } Result;
+
+public:
+    /**
+     * @brief Prepares batches on the given graph and pool, which must outlive it, using
+     * the given heuristic for A* and greedy best-first search.
+     */
+    BatchSearch(const Graph *graph, HeuristicFunction heuristic, ThreadPool *pool)
+        : graph(graph),
+          heuristic(heuristic),
+          pool(pool),
+          keepPaths(false)
+    {
+        for (int i = 0; i < pool->getThreadCount(); ++i)
+        {
+            workspaces.push_back(new SearchWorkspace<Graph>(graph));
+            queues.push_back(new IndexedHeapQueue<Graph>(graph));
+        }
+    }
+
+    ~BatchSearch()
+    {
+        for (SearchWorkspace<Graph> *workspace : workspaces)
+        {
+            delete workspace;
+        }
+        for (IndexedHeapQueue<Graph> *queue : queues)
+        {
+            delete queue;
+        }
+    }
+
+    /**
+     * @brief Sets whether the results include the paths found, which are left out by
+     * default.
+     */
+    void setKeepPaths(bool enabled)
+    {
+        keepPaths = enabled;
+    }
+
+    /**
+     * @brief Runs every query, spread over the threads of the pool.
+     * @return The result of each query, in the same order.
+     */
+    std::vector<Result> run(const std::vector<Query> &batch)
+    {
+        std::vector<Result> results(batch.size());
+        pool->run(int(batch.size()), [&](int item, int thread) {
+            results[item] = runQuery(batch[item], *workspaces[thread], *queues[thread]);
+        });
+        return results;
+    }
+
+private:
+    Result runQuery(const Query &query, SearchWorkspace<Graph> &workspace,
+                    IndexedHeapQueue<Graph> &queue) const
+    {
+        Result result;
+        switch (query.algorithm)
+        {
+        case DIJKSTRA:
+            result.expandedNodes = dijkstra(graph, query.start, query.goal, workspace, queue);
+            break;
+        case A_STAR:
+            result.expandedNodes = aStar(graph, query.start, query.goal, workspace, queue,
+                                         heuristic);
+            break;
+        case GREEDY_BEST_FIRST:
+            result.expandedNodes = greedyBestFirstSearch(graph, query.start, query.goal,
+                                                         workspace, heuristic);
+            break;
+        }
+        bool found = workspace.isVisited(query.goal);
+        result.cost = found ? workspace.getCost(query.goal) : -1;
+        if (keepPaths && found)
+        {
+            for (Node node = query.goal; !(node == query.start);
+                 node = workspace.getPrevious(node))
+            {
+                result.path.push_back(node);
+            }
+            result.path.push_back(query.start);
+            std::reverse(result.path.begin(), result.path.end());
+        }
+        return result;
+    }
+
+private:
+    const Graph *graph;
+    HeuristicFunction heuristic;
+    ThreadPool *pool;
+    bool keepPaths;
+    std::vector<SearchWorkspace<Graph>*> workspaces;  // One for each thread of the pool
+    std::vector<IndexedHeapQueue<Graph>*> queues;
+};
+
+#endif // BATCHSEARCH_H
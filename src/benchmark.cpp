@@ -1,62 +1,666 @@
 #include "benchmark.h"
+#include <algorithm>
 #include <iostream>
 #include <cstdlib>
 #include <fstream>
 #include <sstream>
 #include <cassert>
+#include <chrono>
 #include <cmath>
 #include <ctime>
+#include <limits>
+#include <numeric>
+#include <thread>
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
 #include "algorithms.hpp"
 #include "csvencoder.h"
+#include "deltastepping.hpp"
+
+// Algorithms run when none are selected
+static const std::string DEFAULT_GRID_ALGORITHMS =
+        "dijkstra,astar-manhattan,astar-euclidean,greedy-manhattan,bidijkstra,"
+        "biastar-manhattan,jps-manhattan,jpsplus-manhattan,hpa-manhattan,alt";
+static const std::string DEFAULT_SCENARIO_ALGORITHMS =
+        "dijkstra,astar-octile,astar-euclidean,greedy-octile,bidijkstra,biastar-octile,"
+        "jps-octile,jpsplus-octile,hpa-octile,alt";
+static const std::string DEFAULT_ROAD_ALGORITHMS =
+        "dijkstra,astar-linear,astar-haversine,greedy-linear,bidijkstra,biastar-haversine,"
+        "ch,alt";
+
+// Sources and targets of the distance table timed after the road benchmark
+static const int DISTANCE_TABLE_SIZE = 100;
+
+// Set by the build from the repository, if it's built from one
+#ifndef GIT_COMMIT
+#define GIT_COMMIT "unknown"
+#endif
+
+// Version of the layout of benchmark.json, to be raised when it changes
+static const int REPORT_VERSION = 1;
+// A difference with the baseline is only flagged if the chance of getting one as large
+// from runs with the same distribution is below this, and the median changes by more
+// than the given fraction
+static const double SIGNIFICANCE_LEVEL = 0.01;
+static const double MIN_RELATIVE_CHANGE = 0.05;
+// Fewer queries than this can't show a significant difference
+static const size_t MIN_COMPARED_QUERIES = 8;
+
+/**
+ * @return The value below which the given fraction of the sorted values fall, picking
+ * the nearest one.
+ */
+static double percentile(const std::vector<double> &sorted, double fraction)
+{
+    size_t rank = size_t(std::ceil(fraction * sorted.size()));
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+/**
+ * @brief The total of some values and how they're distributed.
+ */
+typedef struct Distribution
+{
+    double total, mean, min, median, p90, p99, stddev;
+} Distribution;
+
+/**
+ * @return The distribution of a non-empty list of values.
+ */
+static Distribution getDistribution(const std::vector<double> &values)
+{
+    std::vector<double> sorted(values);
+    std::sort(sorted.begin(), sorted.end());
+    double total = std::accumulate(values.begin(), values.end(), 0.);
+    double mean = total / values.size();
+    double variance = 0;
+    for (double value : values)
+    {
+        variance += (value - mean) * (value - mean);
+    }
+    variance /= values.size();
+    return Distribution{total, mean, sorted.front(), percentile(sorted, 0.5),
+                        percentile(sorted, 0.9), percentile(sorted, 0.99),
+                        std::sqrt(variance)};
+}
+
+/**
+ * @brief Prints the totals of an algorithm and the distribution of its running times.
+ */
+static void printSummaryRow(const std::string &name,
+                            const std::vector<unsigned long> &nodes,
+                            const std::vector<double> &times)
+{
+    if (times.empty())
+    {
+        return;
+    }
+    Distribution distribution = getDistribution(times);
+    std::cout << name << "\t\t" << std::accumulate(nodes.begin(), nodes.end(), 0UL)
+              << "\t\t" << distribution.total
+              << "\t\t" << distribution.min
+              << "\t\t" << distribution.median
+              << "\t\t" << distribution.p90
+              << "\t\t" << distribution.p99
+              << "\t\t" << distribution.stddev << std::endl;
+}
+
+/**
+ * @return The two-sided p-value of a Mann-Whitney U test of whether two samples come from
+ * the same distribution, using the normal approximation with the correction for ties, or
+ * 1 if every value is the same.
+ *
+ * Unlike a t-test, it doesn't assume the values are normally distributed, which the
+ * running times of searches over random queries aren't.
+ */
+static double mannWhitneyPValue(const std::vector<double> &a, const std::vector<double> &b)
+{
+    // Rank both samples together, giving tied values the average of their ranks
+    std::vector<std::pair<double, bool>> values;
+    for (double value : a)
+    {
+        values.push_back(std::make_pair(value, true));
+    }
+    for (double value : b)
+    {
+        values.push_back(std::make_pair(value, false));
+    }
+    std::sort(values.begin(), values.end());
+    double rankSumA = 0, tieTerm = 0;
+    for (size_t first = 0; first < values.size();)
+    {
+        size_t last = first;
+        while (last + 1 < values.size() && values[last + 1].first == values[first].first)
+        {
+            ++last;
+        }
+        double rank = (first + last) / 2. + 1;
+        for (size_t i = first; i <= last; ++i)
+        {
+            rankSumA += values[i].second ? rank : 0;
+        }
+        double ties = double(last - first + 1);
+        tieTerm += ties * ties * ties - ties;
+        first = last + 1;
+    }
+
+    double n1 = double(a.size()), n2 = double(b.size()), n = n1 + n2;
+    double u = rankSumA - n1 * (n1 + 1) / 2;
+    double variance = n1 * n2 / 12 * ((n + 1) - tieTerm / (n * (n - 1)));
+    if (variance <= 0)
+    {
+        return 1;
+    }
+    // With a continuity correction, as U only takes whole or half values
+    double z = std::max(0., std::abs(u - n1 * n2 / 2) - 0.5) / std::sqrt(variance);
+    return std::erfc(z / std::sqrt(2.));
+}
+
+/**
+ * @return Whether two lists of queries from benchmark reports have the same starts and
+ * goals in the same order.
+ */
+static bool sameQueries(const JsonValue &a, const JsonValue &b)
+{
+    if (a.size() != b.size())
+    {
+        return false;
+    }
+    for (size_t query = 0; query < a.size(); ++query)
+    {
+        if (a[query].size() != b[query].size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < a[query].size(); ++i)
+        {
+            if (a[query][i].asNumber() != b[query][i].asNumber())
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @return The numbers of an array of a benchmark report.
+ */
+static std::vector<double> getNumbers(const JsonValue &array)
+{
+    std::vector<double> numbers;
+    for (size_t i = 0; i < array.size(); ++i)
+    {
+        numbers.push_back(array[i].asNumber());
+    }
+    return numbers;
+}
+
+/**
+ * @return The name of the machine, its processor, the threads it runs at once and the
+ * compiler the benchmark was built with, as far as they can be found.
+ */
+static JsonValue describeMachine()
+{
+    std::string hostname = "unknown";
+#if defined(__unix__) || defined(__APPLE__)
+    char name[256];
+    if (gethostname(name, sizeof(name)) == 0)
+    {
+        name[sizeof(name) - 1] = '\0';
+        hostname = name;
+    }
+#endif
+    // Only Linux lists the model of the processor in a file
+    std::string cpu = "unknown";
+    std::ifstream cpuInfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuInfo, line))
+    {
+        if (line.compare(0, 10, "model name") == 0 && line.find(':') != std::string::npos)
+        {
+            cpu = line.substr(std::min(line.size(), line.find(':') + 2));
+            break;
+        }
+    }
+#if defined(__VERSION__)
+    std::string compiler = __VERSION__;
+#elif defined(_MSC_VER)
+    std::string compiler = "MSVC " + std::to_string(_MSC_VER);
+#else
+    std::string compiler = "unknown";
+#endif
+
+    JsonValue machine = JsonValue::object();
+    machine.set("hostname", hostname);
+    machine.set("cpu", cpu);
+    machine.set("hardwareThreads", std::thread::hardware_concurrency());
+    machine.set("compiler", compiler);
+#ifdef NDEBUG
+    machine.set("build", "release");
+#else
+    machine.set("build", "debug");
+#endif
+    return machine;
+}
+
+/**
+ * @return The size of a grid and the memory it takes, for the report.
+ */
+static JsonValue describeGrid(const std::string &type, const std::string &file,
+                              const GridGraph *grid)
+{
+    JsonValue graph = JsonValue::object();
+    graph.set("type", type);
+    graph.set("file", file);
+    graph.set("width", grid->getWidth());
+    graph.set("height", grid->getHeight());
+    graph.set("nodes", grid->getNodeCount());
+    graph.set("memoryBytes", grid->getMemoryUsage());
+    return graph;
+}
+
+/**
+ * @return The start and goal tiles of each query, as [startX, startY, goalX, goalY].
+ */
+static JsonValue describeGridQueries(const std::vector<std::pair<Tile, Tile>> &queries)
+{
+    JsonValue result = JsonValue::array();
+    for (const auto &query : queries)
+    {
+        result.push(JsonValue::array(std::vector<int>{query.first.x, query.first.y,
+                                                      query.second.x, query.second.y}));
+    }
+    return result;
+}
+
+/**
+ * @return What was recorded about an algorithm, with the distribution of its running
+ * times and totals of the rest, for the report.
+ */
+static JsonValue describeResults(const AlgorithmResults &algorithm, bool hasCounters)
+{
+    JsonValue result = JsonValue::object();
+    result.set("name", algorithm.name);
+    result.set("exact", algorithm.exact);
+    result.set("preparationTime", algorithm.preparationTime);
+    result.set("memoryUsage", algorithm.memoryUsage);
+    result.set("preparationBytes", algorithm.preparationBytes);
+    result.set("distances", JsonValue::array(algorithm.distances));
+    result.set("expandedNodes", JsonValue::array(algorithm.expandedNodes));
+    result.set("times", JsonValue::array(algorithm.times));
+    std::vector<unsigned long> allocations;
+    std::vector<size_t> allocatedBytes, peakBytes;
+    for (const AllocationStats &stats : algorithm.allocations)
+    {
+        allocations.push_back(stats.allocations);
+        allocatedBytes.push_back(stats.allocatedBytes);
+        peakBytes.push_back(stats.peakBytes);
+    }
+    result.set("allocations", JsonValue::array(allocations));
+    result.set("allocatedBytes", JsonValue::array(allocatedBytes));
+    result.set("peakBytes", JsonValue::array(peakBytes));
+    if (hasCounters)
+    {
+        JsonValue counters = JsonValue::object();
+        for (int counter = 0; counter < PerfCounters::COUNTER_COUNT; ++counter)
+        {
+            std::vector<double> values;
+            for (const PerfCounters::Values &run : algorithm.counters)
+            {
+                values.push_back(run[counter]);
+            }
+            counters.set(PerfCounters::getName(PerfCounters::eCounter(counter)),
+                         JsonValue::array(values));
+        }
+        result.set("counters", counters);
+    }
+    if (algorithm.hasQueueStats)
+    {
+        JsonValue queueStats = JsonValue::object();
+        queueStats.set("pushes", algorithm.queueStats.pushes);
+        queueStats.set("pops", algorithm.queueStats.pops);
+        queueStats.set("decreaseKeys", algorithm.queueStats.decreaseKeys);
+        result.set("queueStats", queueStats);
+    }
+
+    JsonValue aggregates = JsonValue::object();
+    aggregates.set("queries", algorithm.times.size());
+    aggregates.set("totalNodes", std::accumulate(algorithm.expandedNodes.begin(),
+                                                 algorithm.expandedNodes.end(), 0.));
+    if (!algorithm.times.empty())
+    {
+        Distribution times = getDistribution(algorithm.times);
+        aggregates.set("totalTime", times.total);
+        aggregates.set("meanTime", times.mean);
+        aggregates.set("minTime", times.min);
+        aggregates.set("medianTime", times.median);
+        aggregates.set("p90Time", times.p90);
+        aggregates.set("p99Time", times.p99);
+        aggregates.set("stddevTime", times.stddev);
+        aggregates.set("meanAllocations",
+                       std::accumulate(allocations.begin(), allocations.end(), 0.)
+                       / allocations.size());
+        aggregates.set("maxPeakBytes", *std::max_element(peakBytes.begin(),
+                                                         peakBytes.end()));
+    }
+    result.set("aggregates", aggregates);
+    return result;
+}
+
+/**
+ * @brief Adds the stats of the last search run with a queue to a running total.
+ */
+static void addQueueStats(QueueStats &total, const QueueStats &run)
+{
+    total.pushes += run.pushes;
+    total.pops += run.pops;
+    total.decreaseKeys += run.decreaseKeys;
+}
+
+/**
+ * @return The mean of each performance counter over the queries, or -1 for the ones
+ * which weren't available.
+ */
+static PerfCounters::Values meanCounters(const std::vector<PerfCounters::Values> &counters)
+{
+    PerfCounters::Values means;
+    means.fill(-1);
+    for (int counter = 0; counter < PerfCounters::COUNTER_COUNT; ++counter)
+    {
+        if (counters.empty() || counters.front()[counter] < 0)
+        {
+            continue;
+        }
+        double total = 0;
+        for (const PerfCounters::Values &values : counters)
+        {
+            total += values[counter];
+        }
+        means[counter] = total / counters.size();
+    }
+    return means;
+}
 
 Benchmark::Benchmark(std::string filename)
     : filename(filename),
-      gridGraph(nullptr)
+      gridGraph(nullptr),
+      gridContext(nullptr),
+      roadContext(nullptr),
+      parallelBidirectional(false),
+      warmupCount(0),
+      repetitionCount(1),
+      threadCount(0),
+      threadPool(nullptr),
+      perfCounters(nullptr),
+      seed(std::mt19937::default_seed),
+      regressionCount(0)
 {
 }
 
 Benchmark::~Benchmark()
 {
+    deleteEngines();
+    delete gridContext;
+    delete roadContext;
+    delete threadPool;
+    delete perfCounters;
     if (gridGraph)
         delete gridGraph;
 }
 
+void Benchmark::deleteEngines()
+{
+    for (SearchEngine<GridGraph> *engine : gridEngines)
+    {
+        delete engine;
+    }
+    gridEngines.clear();
+    for (SearchEngine<GeolocationGraph> *engine : roadEngines)
+    {
+        delete engine;
+    }
+    roadEngines.clear();
+    results.clear();
+}
 
 void Benchmark::run(int count)
 {
+    delete threadPool;
+    threadPool = new ThreadPool(threadCount);
+
+    // Keep what the results depend on next to them
+    char date[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    JsonValue settings = JsonValue::object();
+    settings.set("seed", seed);
+    settings.set("warmup", warmupCount);
+    settings.set("repetitions", repetitionCount);
+    settings.set("threads", threadPool->getThreadCount());
+    settings.set("parallelBidirectional", parallelBidirectional);
+    settings.set("perfCounters", perfCounters != nullptr);
+    settings.set("algorithms", algorithmNames.empty() ? "default" : algorithmNames);
+    report = JsonValue::object();
+    report.set("version", REPORT_VERSION);
+    report.set("commit", GIT_COMMIT);
+    report.set("date", date);
+    report.set("machine", describeMachine());
+    report.set("settings", settings);
+    report.set("graphs", JsonValue::array());
+
+    const std::string scenarioExtension = ".scen";
+    if (filename.size() > scenarioExtension.size()
+            && filename.compare(filename.size() - scenarioExtension.size(),
+                                scenarioExtension.size(), scenarioExtension) == 0)
+    {
+        std::cout << "### Running MovingAI scenario benchmark ###" << std::endl;
+        runScenarioBenchmark(count);
+        return;
+    }
+
     std::cout << "### Running grid graph benchmark ###" << std::endl;
     runGridBenchmark(count);
 
     // Reset result structures
-    timesDijkstra.clear();
-    timesAstar.clear();
-    timesAstarAlt.clear();
-    expandedDijkstra.clear();
-    expandedAstar.clear();
-    expandedAstarAlt.clear();
-    distDijkstra.clear();
-    distAstar.clear();
-    distAstarAlt.clear();
-    distGreedy.clear();
+    deleteEngines();
 
     std::cout << "### Running geolocation graph benchmark ###" << std::endl;
     runRoadBenchmark(count);
 }
 
+void Benchmark::setAlgorithms(const std::string &names)
+{
+    for (const std::string &name : splitLine(names))
+    {
+        if (!gridAlgorithms().find(name) && !roadAlgorithms().find(name))
+        {
+            throw std::invalid_argument("Unknown algorithm " + name);
+        }
+    }
+    algorithmNames = names;
+}
+
+void Benchmark::setParallelBidirectional(bool enabled)
+{
+    parallelBidirectional = enabled;
+}
+
+void Benchmark::setRepetitions(int warmup, int repetitions)
+{
+    if (warmup < 0 || repetitions < 1)
+    {
+        throw std::invalid_argument("Invalid warmup or repetition count");
+    }
+    warmupCount = warmup;
+    repetitionCount = repetitions;
+}
+
+void Benchmark::setThreadCount(int threadCount)
+{
+    this->threadCount = threadCount;
+}
+
+void Benchmark::setPerfCounters(bool enabled)
+{
+    delete perfCounters;
+    perfCounters = nullptr;
+    if (!enabled)
+    {
+        return;
+    }
+    perfCounters = new PerfCounters();
+    if (!perfCounters->isAnyAvailable())
+    {
+        std::cout << "Performance counters are not available (" << perfCounters->getError()
+                  << "), running without them" << std::endl;
+        delete perfCounters;
+        perfCounters = nullptr;
+    }
+    else if (!perfCounters->getError().empty())
+    {
+        std::cout << "Some performance counters are not available ("
+                  << perfCounters->getError() << "), they are recorded as -1" << std::endl;
+    }
+}
+
+void Benchmark::setSeed(unsigned seed)
+{
+    this->seed = seed;
+    randomEngine.seed(seed);
+}
+
+void Benchmark::setBaseline(const std::string &baselineFilename)
+{
+    std::ifstream file(baselineFilename);
+    if (!file)
+    {
+        throw std::runtime_error("Couldn't open the baseline " + baselineFilename);
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+    JsonValue parsed = JsonValue::parse(text.str());
+    if (parsed.getType() != JsonValue::OBJECT || !parsed.has("graphs"))
+    {
+        throw std::runtime_error(baselineFilename + " isn't a benchmark report");
+    }
+    baseline = parsed;
+    this->baselineFilename = baselineFilename;
+}
+
+int Benchmark::getRegressionCount() const
+{
+    return regressionCount;
+}
+
+int Benchmark::randomInt(int n)
+{
+    // The engine gives the same numbers everywhere, unlike the standard distributions
+    return int(randomEngine() % unsigned(n));
+}
+
+Tile Benchmark::randomTile()
+{
+    std::pair<int, int> topLeft = gridGraph->getTopLeft();
+    return Tile{topLeft.first + randomInt(gridGraph->getWidth()),
+                topLeft.second + randomInt(gridGraph->getHeight())};
+}
+
+void Benchmark::prepareGridBenchmark(const std::string &gridFilename,
+                                     const std::string &defaults)
+{
+    // The JPS+ table and the landmarks are kept next to the map
+    gridContext = new GridSearchContext(gridGraph, gridFilename);
+    gridContext->setParallelBidirectional(parallelBidirectional);
+    if (gridContext->getBucketQueue(0))
+    {
+        std::cout << (gridGraph->isDiagonalAllowed()
+                      ? "Using a bucket queue for Dijkstra"
+                      : "Using a bucket queue for Dijkstra and A* with Manhattan distance")
+                  << std::endl;
+    }
+    prepareEngines(gridAlgorithms(), *gridContext, defaults, "benchmark_grid.csv",
+                   gridEngines);
+}
+
+template <typename Context>
+void Benchmark::prepareEngines(const AlgorithmRegistry<Context> &registry, Context &context,
+                               const std::string &defaults, const std::string &csvFilename,
+                               std::vector<SearchEngine<typename Context::Graph>*> &engines)
+{
+    // The selected algorithms which don't run on this graph are left out
+    std::vector<const typename AlgorithmRegistry<Context>::Entry*> entries;
+    if (algorithmNames.empty())
+    {
+        entries = registry.select(defaults);
+    }
+    for (const std::string &name : splitLine(algorithmNames))
+    {
+        if (registry.find(name))
+        {
+            entries.push_back(registry.find(name));
+        }
+    }
+
+    std::ofstream file(csvFilename);
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        const std::string &name = entries[i]->name;
+        // Preprocessing runs on every core, so it's timed by the wall clock instead of
+        // the processor time used
+        std::cout << "Preparing " << name << "..." << std::endl;
+        AllocationScope allocations;
+        auto begin = std::chrono::steady_clock::now();
+        engines.push_back(entries[i]->create(context));
+        double preparationTime = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - begin).count();
+        long long preparationBytes = allocations.getStats().liveBytes;
+        std::string description = engines.back()->describe();
+        if (!description.empty())
+        {
+            std::cout << name << ": " << description << std::endl;
+        }
+
+        AlgorithmResults algorithm;
+        algorithm.name = name;
+        algorithm.exact = entries[i]->exact;
+        algorithm.hasQueueStats = false;
+        algorithm.queueStats = QueueStats{0, 0, 0};
+        algorithm.preparationTime = preparationTime;
+        algorithm.memoryUsage = engines.back()->getMemoryUsage();
+        algorithm.preparationBytes = preparationBytes;
+        results.push_back(algorithm);
+
+        // Write header of benchmark results CSV file
+        file << (i > 0 ? "," : "") << name << "Dist," << name << "Nodes," << name << "Time,"
+             << name << "Allocations," << name << "PeakBytes";
+        if (perfCounters)
+        {
+            for (int counter = 0; counter < PerfCounters::COUNTER_COUNT; ++counter)
+            {
+                file << "," << name << PerfCounters::getName(PerfCounters::eCounter(counter));
+            }
+        }
+    }
+    file << std::endl;
+}
+
 void Benchmark::runGridBenchmark(int count)
 {
     // Assume the randomgrid.csv file has been generated
     std::cout << "Loading grid graph..." << std::endl;
-    CSVEncoder encoder("randomgrid.csv");
+    const std::string gridFilename = "randomgrid.csv";
+    CSVEncoder encoder(gridFilename);
     gridGraph = encoder.loadGridGraph();
-
-    // Write header of benchmark results CSV file
-    std::ofstream file("benchmark_grid.csv");
-    file << "dijDist,dijNodes,dijTime,A*Dist,A*Nodes,A*Time,A*altDist,A*altNodes,A*altTime,greedyDist,greedyNodes,greedyTime"
-         << std::endl;
+    prepareGridBenchmark(gridFilename, DEFAULT_GRID_ALGORITHMS);
+    if (gridEngines.empty())
+    {
+        std::cout << "No grid algorithms selected" << std::endl;
+        return;
+    }
 
     Tile startTile, goalTile;
-    srand(time(nullptr));
     for (int i = 1; i <= count; ++i)
     {
         bool success;
@@ -66,22 +670,99 @@ void Benchmark::runGridBenchmark(int count)
             // Repeat until we find start/goal nodes that are not walls
             do
             {
-                startTile = Tile{-gridGraph->getWidth() / 2 + rand() % gridGraph->getWidth(),
-                        -gridGraph->getHeight() / 2 + rand() % gridGraph->getWidth()};
-                goalTile = Tile{-gridGraph->getHeight() / 2 + rand() % gridGraph->getWidth(),
-                        -gridGraph->getHeight() / 2 + rand() % gridGraph->getHeight()};
+                startTile = randomTile();
+                goalTile = randomTile();
             } while (gridGraph->isWall(startTile) || gridGraph->isWall(goalTile));
 
             std::cout << "Executing benchmark " << i << "/" << count
                       << " with start=(" << startTile.x << "," << startTile.y
                       << ") and goal=(" << goalTile.x << "," << goalTile.y << ")"
                       << std::endl;
-            success = runGridSingle(startTile, goalTile);
+            success = runSingle(gridEngines, startTile, goalTile, "benchmark_grid.csv");
         } while (!success);
+        gridQueries.push_back(std::make_pair(startTile, goalTile));
+    }
+    runBatch(gridGraph, ManhattanDistance(), "manhattan", gridQueries);
+    std::cout << "Running summary..." << std::endl;
+    runSummary();
+    reportGraph(describeGrid("grid", gridFilename, gridGraph),
+                describeGridQueries(gridQueries));
+}
+
+void Benchmark::runScenarioBenchmark(int count)
+{
+    std::vector<Scenario> scenarios = loadMovingAIScenarios(filename);
+    if (scenarios.empty())
+    {
+        throw std::runtime_error("The scenario file has no problems");
+    }
+    // Every problem of a scenario file is on the same map
+    std::string mapFilename = findScenarioMap(filename, scenarios.front());
+    std::cout << "Loading map " << mapFilename << "..." << std::endl;
+    gridGraph = loadMovingAIMap(mapFilename);
+    // Checked before anything runs, as the searches don't check their bounds
+    for (const Scenario &scenario : scenarios)
+    {
+        checkScenario(scenario, gridGraph);
+    }
+    prepareGridBenchmark(mapFilename, DEFAULT_SCENARIO_ALGORITHMS);
+    if (gridEngines.empty())
+    {
+        std::cout << "No grid algorithms selected" << std::endl;
+        return;
+    }
+    // The bucket averages are reported for A* if it runs, or the first algorithm otherwise
+    AlgorithmResults *timed = findResults("astar-octile");
+    if (!timed)
+    {
+        timed = &results.front();
+    }
 
+    // The optimal lengths are written with a few decimals only
+    const double tolerance = 1e-4;
+    size_t next = 0;
+    while (next < scenarios.size())
+    {
+        int bucket = scenarios[next].bucket;
+        int problems = 0, solved = 0, mismatches = 0;
+        double totalTime = 0;
+        for (; next < scenarios.size() && scenarios[next].bucket == bucket; ++next)
+        {
+            const Scenario &scenario = scenarios[next];
+            if (count > 0 && problems == count)
+            {
+                continue;
+            }
+            ++problems;
+            if (!runSingle(gridEngines, scenario.start, scenario.goal, "benchmark_grid.csv"))
+            {
+                ++mismatches;
+                continue;
+            }
+            gridQueries.push_back(std::make_pair(scenario.start, scenario.goal));
+            ++solved;
+            totalTime += timed->times.back();
+            for (const AlgorithmResults &algorithm : results)
+            {
+                if (algorithm.exact
+                        && std::abs(algorithm.distances.back() - scenario.optimalLength)
+                        > tolerance * std::max(1., scenario.optimalLength))
+                {
+                    ++mismatches;
+                    break;
+                }
+            }
+        }
+        std::cout << "Bucket " << bucket << ": " << problems << " problems, " << timed->name
+                  << " took " << totalTime / std::max(1, solved) << " s on average, "
+                  << mismatches << " lengths differ from the optimal ones" << std::endl;
     }
+    runBatch(gridGraph, OctileDistance(), "octile", gridQueries);
     std::cout << "Running summary..." << std::endl;
     runSummary();
+    JsonValue graphInfo = describeGrid("scenario", mapFilename, gridGraph);
+    graphInfo.set("scenario", filename);
+    reportGraph(graphInfo, describeGridQueries(gridQueries));
 }
 
 void Benchmark::runRoadBenchmark(int count)
@@ -89,104 +770,291 @@ void Benchmark::runRoadBenchmark(int count)
     // Build needed structures
     buildCoordsMap();
     buildGeolocationGraph();
+    delete roadContext;
+    roadContext = new RoadSearchContext(&geolocationGraph, &geolocations, filename);
+    roadContext->setParallelBidirectional(parallelBidirectional);
+    prepareEngines(roadAlgorithms(), *roadContext, DEFAULT_ROAD_ALGORITHMS,
+                   "benchmark_road.csv", roadEngines);
+    if (roadEngines.empty())
+    {
+        std::cout << "No road network algorithms selected" << std::endl;
+        return;
+    }
 
-    // Write header of benchmark results CSV file
-    std::ofstream file("benchmark_road.csv");
-    file << "dijDist,dijNodes,dijTime,A*Dist,A*Nodes,A*Time,A*altDist,A*altNodes,A*altTime,greedyDist,greedyNodes,greedyTime"
-         << std::endl;
-
-    int startId, goalId;
-    srand(time(nullptr));
+    int startNode, goalNode;
     for (int i = 1; i <= count; ++i)
     {
-        startId = 1 + rand() % numNodes;
-        goalId = 1 + rand() % numNodes;
+        startNode = randomInt(numNodes);
+        goalNode = randomInt(numNodes);
 
-        std::cout << "Executing benchmark " << i << "/" << count << " with start=" << startId
-                  << " and goal=" << goalId << std::endl;
-        runRoadSingle(startId, goalId);
+        std::cout << "Executing benchmark " << i << "/" << count
+                  << " with start=" << geolocations.getId(startNode)
+                  << " and goal=" << geolocations.getId(goalNode) << std::endl;
+        // Only the queries with a path are recorded, so they line up with the results
+        if (runSingle(roadEngines, startNode, goalNode, "benchmark_road.csv"))
+        {
+            roadQueries.push_back(std::make_pair(startNode, goalNode));
+        }
+    }
+    runBatch(&geolocationGraph, LinearDistance3D{&geolocations}, "linear", roadQueries);
+    if (roadContext->hasContractionHierarchy())
+    {
+        runRoadDistanceTable();
     }
+    runRoadOneToAll();
     std::cout << "Running summary..." << std::endl;
     runSummary();
+
+    JsonValue graphInfo = JsonValue::object();
+    graphInfo.set("type", "road");
+    graphInfo.set("file", filename);
+    graphInfo.set("nodes", geolocationGraph.getNodeCount());
+    graphInfo.set("edges", geolocationGraph.getEdgeCount());
+    graphInfo.set("memoryBytes", geolocationGraph.getMemoryUsage());
+    // By their DIMACS identifiers, which don't change with the order nodes are read in
+    JsonValue queries = JsonValue::array();
+    for (const auto &query : roadQueries)
+    {
+        queries.push(JsonValue::array(std::vector<int>{geolocations.getId(query.first),
+                                                       geolocations.getId(query.second)}));
+    }
+    reportGraph(graphInfo, queries);
 }
 
-bool Benchmark::runGridSingle(Tile startTile, Tile goalTile)
+void Benchmark::runRoadDistanceTable()
 {
-    double optimalDistance;
-    std::map<Tile, Tile> previous;
-    std::map<Tile, double> costToNode;
-    Algorithm algorithm;
-    Heuristic<Tile> heuristic;
+    std::cout << "Computing a " << DISTANCE_TABLE_SIZE << "x" << DISTANCE_TABLE_SIZE
+              << " distance table..." << std::endl;
+    std::vector<int> sources, targets;
+    for (int i = 0; i < DISTANCE_TABLE_SIZE; ++i)
+    {
+        sources.push_back(randomInt(numNodes));
+        targets.push_back(randomInt(numNodes));
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<double> dijkstraTable = distanceTable(&geolocationGraph, sources, targets,
+                                                      roadContext->getWorkspace(),
+                                                      roadContext->getQueue());
+    auto middle = std::chrono::steady_clock::now();
+    std::vector<double> hierarchyTable =
+            roadContext->getContractionHierarchy()->distanceTable(sources, targets);
+    auto end = std::chrono::steady_clock::now();
+
+    // The hierarchy adds the costs up in another order, so they can differ slightly
+    int mismatches = 0;
+    for (size_t i = 0; i < dijkstraTable.size(); ++i)
+    {
+        if (std::abs(dijkstraTable[i] - hierarchyTable[i])
+                > 1e-6 * std::max(1., std::abs(dijkstraTable[i])))
+        {
+            ++mismatches;
+        }
+    }
+    std::cout << "One-to-many Dijkstra took "
+              << std::chrono::duration<double>(middle - begin).count()
+              << " s, Contraction Hierarchies buckets took "
+              << std::chrono::duration<double>(end - middle).count() << " s, "
+              << mismatches << " entries differ" << std::endl;
+}
+
+void Benchmark::runRoadOneToAll()
+{
+    std::cout << "Computing one-to-all costs..." << std::endl;
+    int startNode = randomInt(numNodes);
+    // Dijkstra stops when every node has been expanded, or runs out of reachable ones
+    std::vector<int> allNodes(numNodes);
+    for (int node = 0; node < numNodes; ++node)
+    {
+        allNodes[node] = node;
+    }
+    DeltaStepping<GeolocationGraph> deltaStepping(&geolocationGraph);
+    SearchWorkspace<GeolocationGraph> &workspace = roadContext->getWorkspace();
+
+    auto begin = std::chrono::steady_clock::now();
+    dijkstraToMany(&geolocationGraph, startNode, allNodes, workspace,
+                   roadContext->getQueue());
+    auto middle = std::chrono::steady_clock::now();
+    deltaStepping.run(startNode);
+    auto end = std::chrono::steady_clock::now();
+
+    int mismatches = 0;
+    for (int node = 0; node < numNodes; ++node)
+    {
+        bool reached = workspace.isClosed(node);
+        if (reached != deltaStepping.isReached(node)
+                || (reached && workspace.getCost(node)
+                    != deltaStepping.getCost(node)))
+        {
+            ++mismatches;
+        }
+    }
+    std::cout << "Dijkstra took " << std::chrono::duration<double>(middle - begin).count()
+              << " s, delta-stepping on " << deltaStepping.getThreadCount()
+              << " threads took " << std::chrono::duration<double>(end - middle).count()
+              << " s, " << mismatches << " costs differ" << std::endl;
+}
 
+template <typename Graph, typename HeuristicFunction>
+void Benchmark::runBatch(const Graph *graph, HeuristicFunction heuristic,
+                         const std::string &heuristicName,
+                         const std::vector<std::pair<typename Graph::Node,
+                                                     typename Graph::Node>> &queries)
+{
+    typedef BatchSearch<Graph, HeuristicFunction> Batch;
+    // The batch runs the same searches as the single runs, so the costs must match
+    std::vector<std::pair<typename Batch::eAlgorithm, const AlgorithmResults*>> compared;
+    if (const AlgorithmResults *dijkstraResults = findResults("dijkstra"))
+    {
+        compared.push_back(std::make_pair(Batch::DIJKSTRA, dijkstraResults));
+    }
+    if (const AlgorithmResults *aStarResults = findResults("astar-" + heuristicName))
+    {
+        compared.push_back(std::make_pair(Batch::A_STAR, aStarResults));
+    }
+    if (compared.empty() || queries.empty())
+    {
+        return;
+    }
+
+    std::cout << "Running the queries as a batch on " << threadPool->getThreadCount()
+              << " threads..." << std::endl;
+    std::vector<typename Batch::Query> batch;
+    for (const auto &query : queries)
+    {
+        for (const auto &algorithm : compared)
+        {
+            batch.push_back(typename Batch::Query{query.first, query.second,
+                                                  algorithm.first});
+        }
+    }
+    Batch batchSearch(graph, heuristic, threadPool);
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<typename Batch::Result> batchResults = batchSearch.run(batch);
+    double batchTime = std::chrono::duration<double>(std::chrono::steady_clock::now()
+                                                     - begin).count();
+
+    int mismatches = 0;
+    double singleTime = 0;
+    for (size_t i = 0; i < compared.size(); ++i)
+    {
+        const AlgorithmResults *single = compared[i].second;
+        for (size_t query = 0; query < queries.size(); ++query)
+        {
+            mismatches += batchResults[query * compared.size() + i].cost
+                    != single->distances[query];
+        }
+        singleTime += std::accumulate(single->times.begin(), single->times.end(), 0.);
+    }
+    std::cout << "Batch of " << batch.size() << " queries took " << batchTime << " s ("
+              << batch.size() / batchTime << " queries/s), single runs took " << singleTime
+              << " s, " << mismatches << " costs differ" << std::endl;
+}
+
+template <typename Algorithm>
+void Benchmark::evaluateAlgorithm(Algorithm alg,
+                                  std::vector<double> &timeVec,
+                                  std::vector<unsigned long> &nodeVec,
+                                  std::vector<PerfCounters::Values> &counterVec,
+                                  std::vector<AllocationStats> &allocationVec)
+{
+    for (int i = 0; i < warmupCount; ++i)
+    {
+        alg();
+    }
+    // Every run expands the same nodes, so only the time changes between repetitions
+    unsigned long expandedNodes = 0;
+    std::chrono::steady_clock::duration elapsedTime(0);
+    // The allocations and counters are started and stopped outside of the timed part
+    AllocationScope allocations;
+    if (perfCounters)
+    {
+        perfCounters->start();
+    }
+    for (int i = 0; i < repetitionCount; ++i)
+    {
+        auto timeBegin = std::chrono::steady_clock::now();
+        expandedNodes = alg();
+        elapsedTime += std::chrono::steady_clock::now() - timeBegin;
+    }
+    if (perfCounters)
+    {
+        perfCounters->stop();
+        PerfCounters::Values values = perfCounters->read();
+        for (double &value : values)
+        {
+            value = value < 0 ? -1 : value / repetitionCount;
+        }
+        counterVec.push_back(values);
+    }
+    AllocationStats allocationStats = allocations.getStats();
+    allocationStats.allocations /= repetitionCount;
+    allocationStats.allocatedBytes /= repetitionCount;
+    allocationVec.push_back(allocationStats);
+
+    timeVec.push_back(std::chrono::duration<double>(elapsedTime).count() / repetitionCount);
+    nodeVec.push_back(expandedNodes);
+}
+
+template <typename Graph>
+bool Benchmark::runSingle(const std::vector<SearchEngine<Graph>*> &engines,
+                          typename Graph::Node start, typename Graph::Node goal,
+                          const std::string &csvFilename)
+{
     try
     {
-        // Dijkstra
-        algorithm = std::bind(&dijkstra<Tile, GridGraph>,
-                              gridGraph, startTile, goalTile,
-                              std::ref(previous), std::ref(costToNode));
-        evaluateAlgorithm(algorithm, timesDijkstra, expandedDijkstra);
-        optimalDistance = costToNode[goalTile];
-        if (previous.find(goalTile) == previous.end()
-                || optimalDistance == std::numeric_limits<double>::infinity())
-        {
-            // There doesn't exist a path
-            std::cout << "No path found. Repeating with different start/goal tiles." << std::endl;
-            return false;
+        // The engines share a workspace, so each cost is read before the next one runs
+        std::vector<double> distances(engines.size());
+        std::vector<double> times;
+        std::vector<unsigned long> expandedNodes;
+        std::vector<PerfCounters::Values> counters;
+        std::vector<AllocationStats> allocations;
+        std::vector<QueueStats> queueStats(engines.size(), QueueStats{0, 0, 0});
+        for (size_t i = 0; i < engines.size(); ++i)
+        {
+            SearchEngine<Graph> *engine = engines[i];
+            evaluateAlgorithm([&]() {
+                return engine->search(start, goal);
+            }, times, expandedNodes, counters, allocations);
+            distances[i] = engine->getCost();
+            if (engine->getQueueStats())
+            {
+                queueStats[i] = *engine->getQueueStats();
+                results[i].hasQueueStats = true;
+            }
+            if (i == 0 && (distances[0] < 0
+                           || distances[0] == std::numeric_limits<double>::infinity()))
+            {
+                // There doesn't exist a path
+                std::cout << "No path found. Repeating with different start/goal tiles."
+                          << std::endl;
+                return false;
+            }
         }
-        distDijkstra.push_back(optimalDistance);
-
-        // Reset structures
-        costToNode.clear();
-        previous.clear();
-
-        // A* with Manhattan distance
-        heuristic = manhattanDistance;
-        algorithm = std::bind(&aStar<Tile, GridGraph>,
-                              gridGraph, startTile, goalTile,
-                              std::ref(previous), std::ref(costToNode), heuristic);
-        evaluateAlgorithm(algorithm, timesAstar, expandedAstar);
-        distAstar.push_back(costToNode[goalTile]);
-
-        // Reset structures
-        costToNode.clear();
-        previous.clear();
-
-        // A* with Euclidean distance
-        heuristic = euclideanDistance;
-        algorithm = std::bind(&aStar<Tile, GridGraph>,
-                              gridGraph, startTile, goalTile,
-                              std::ref(previous), std::ref(costToNode), heuristic);
-        evaluateAlgorithm(algorithm, timesAstarAlt, expandedAstarAlt);
-        distAstarAlt.push_back(costToNode[goalTile]);
-
-        // Reset structures
-        costToNode.clear();
-        previous.clear();
-
-        // Greedy with Manhattan distance
-        heuristic = manhattanDistance;
-        algorithm = std::bind(&greedyBestFirstSearch<Tile, GridGraph>,
-                              gridGraph, startTile, goalTile,
-                              std::ref(previous), std::ref(costToNode), heuristic);
-        evaluateAlgorithm(algorithm, timesGreedy, expandedGreedy);
-        distGreedy.push_back(costToNode[goalTile]);
 
         // Write partial results to CSV file
-        std::ofstream file("benchmark_grid.csv", std::ios_base::app);
-        file << distDijkstra.back() << ","
-             << expandedDijkstra.back() << ","
-             << timesDijkstra.back() << ","
-             << distAstar.back() << ","
-             << expandedAstar.back() << ","
-             << timesAstar.back() << ","
-             << distAstarAlt.back() << ","
-             << expandedAstarAlt.back() << ","
-             << timesAstarAlt.back() << ","
-             << distGreedy.back() << ","
-             << expandedGreedy.back() << ","
-             << timesGreedy.back()
-             << std::endl;
-
+        std::ofstream file(csvFilename, std::ios_base::app);
+        for (size_t i = 0; i < engines.size(); ++i)
+        {
+            AlgorithmResults &algorithm = results[i];
+            algorithm.distances.push_back(distances[i]);
+            algorithm.times.push_back(times[i]);
+            algorithm.expandedNodes.push_back(expandedNodes[i]);
+            addQueueStats(algorithm.queueStats, queueStats[i]);
+            algorithm.allocations.push_back(allocations[i]);
+            file << (i > 0 ? "," : "") << distances[i] << "," << expandedNodes[i] << ","
+                 << times[i] << "," << allocations[i].allocations << ","
+                 << allocations[i].peakBytes;
+            if (perfCounters)
+            {
+                algorithm.counters.push_back(counters[i]);
+                for (double value : counters[i])
+                {
+                    file << "," << value;
+                }
+            }
+        }
+        file << std::endl;
         return true;
     }
     catch (std::exception &ex)
@@ -197,65 +1065,6 @@ bool Benchmark::runGridSingle(Tile startTile, Tile goalTile)
     }
 }
 
-void Benchmark::runRoadSingle(int startId, int goalId)
-{
-    // Use 4 different map of each cus apparently clearing a map does not
-    // delete the memory and performance will be slower after
-    std::map<Geolocation, Geolocation> previous1, previous2, previous3, previous4;
-    std::map<Geolocation, double> costToNode1, costToNode2, costToNode3, costToNode4;
-    Algorithm algorithm;
-    Heuristic<Geolocation> heuristic;
-    Geolocation startNode = mapIdToGeolocation[startId];
-    Geolocation goalNode = mapIdToGeolocation[goalId];
-
-    // Dijkstra
-    algorithm = std::bind(&dijkstra<Geolocation, GeolocationGraph>,
-                          &geolocationGraph, startNode, goalNode,
-                          std::ref(previous1), std::ref(costToNode1));
-    evaluateAlgorithm(algorithm, timesDijkstra, expandedDijkstra);
-    distDijkstra.push_back(costToNode1[goalNode]);
-
-    // A* with linear distance
-    heuristic = euclideanDistance3D;
-    algorithm = std::bind(&aStar<Geolocation, GeolocationGraph>,
-                          &geolocationGraph, startNode, goalNode,
-                          std::ref(previous2), std::ref(costToNode2), heuristic);
-    evaluateAlgorithm(algorithm, timesAstar, expandedAstar);
-    distAstar.push_back(costToNode2[goalNode]);
-
-    // A* with Haversine distance
-    heuristic = haversineDistance;
-    algorithm = std::bind(&aStar<Geolocation, GeolocationGraph>,
-                          &geolocationGraph, startNode, goalNode,
-                          std::ref(previous3), std::ref(costToNode3), heuristic);
-    evaluateAlgorithm(algorithm, timesAstarAlt, expandedAstarAlt);
-    distAstarAlt.push_back(costToNode3[goalNode]);
-
-    // Greedy with linear distance
-    heuristic = euclideanDistance3D;
-    algorithm = std::bind(&greedyBestFirstSearch<Geolocation, GeolocationGraph>,
-                          &geolocationGraph, startNode, goalNode,
-                          std::ref(previous4), std::ref(costToNode4), heuristic);
-    evaluateAlgorithm(algorithm, timesGreedy, expandedGreedy);
-    distGreedy.push_back(costToNode4[goalNode]);
-
-    // Write partial results to CSV file
-    std::ofstream file("benchmark_road.csv", std::ios_base::app);
-    file << distDijkstra.back() << ","
-         << expandedDijkstra.back() << ","
-         << timesDijkstra.back() << ","
-         << distAstar.back() << ","
-         << expandedAstar.back() << ","
-         << timesAstar.back() << ","
-         << distAstarAlt.back() << ","
-         << expandedAstarAlt.back() << ","
-         << timesAstarAlt.back() << ","
-         << distGreedy.back() << ","
-         << expandedGreedy.back() << ","
-         << timesGreedy.back()
-         << std::endl;
-}
-
 void Benchmark::buildCoordsMap()
 {
     std::cout << "Building coordinate map..." << std::endl;
@@ -281,7 +1090,8 @@ void Benchmark::buildCoordsMap()
         // Discard next two lines as they are comments
         std::getline(file, line);
         std::getline(file, line);
-        // Build the map
+        // Build the coordinate table, which assigns a dense index to every DIMACS id
+        geolocations = GeolocationTable();
         for (int i = 0; i < numNodes; ++i)
         {
             std::getline(file, line);
@@ -289,10 +1099,7 @@ void Benchmark::buildCoordsMap()
             int id = std::stoi(parts[1]);
             int latitude = std::stoi(parts[2]),
                     longitude = std::stoi(parts[3]);
-            Geolocation node{id, latitude, longitude};
-            node.computeCartesianCoordinates();
-            // Add node to the map
-            mapIdToGeolocation[id] = node;
+            geolocations.addNode(id, latitude, longitude);
         }
     }
     catch (std::exception &ex)
@@ -326,18 +1133,24 @@ void Benchmark::buildGeolocationGraph()
         // Discard next two lines as they are comments
         std::getline(file, line);
         std::getline(file, line);
-        // Build the graph
+        // Read all the edges, then build the graph from them in one go
+        std::vector<GeolocationGraph::Edge> edges;
+        edges.reserve(edgeCount);
         for (int i = 0; i < edgeCount; ++i)
         {
             std::getline(file, line);
             parts = splitLine(line, delimiter);
-            Geolocation node1 = mapIdToGeolocation[std::stoi(parts[1])];
-            Geolocation node2 = mapIdToGeolocation[std::stoi(parts[2])];
+            int node1 = geolocations.getIndex(std::stoi(parts[1]));
+            int node2 = geolocations.getIndex(std::stoi(parts[2]));
+            if (node1 < 0 || node2 < 0)
+            {
+                throw std::runtime_error("Unknown node id");
+            }
             // Calculate weight using Haversine distance formula
-            double weight = haversineDistance(node1, node2);
-            // Add node to the graph
-            geolocationGraph.addEdge(node1, node2, weight);
+            float weight = geolocations.haversineDistance(node1, node2);
+            edges.push_back(GeolocationGraph::Edge{node1, node2, weight});
         }
+        geolocationGraph = GeolocationGraph(numNodes, edges);
     }
     catch (std::exception &ex)
     {
@@ -347,44 +1160,305 @@ void Benchmark::buildGeolocationGraph()
 
 void Benchmark::runSummary()
 {
-    double dijkstraTotalNodes, aStarTotalNodes, aStarAltTotalNodes, greedyTotalNodes;
-    double dijkstraTotalTime, aStarTotalTime, aStarAltTotalTime, greedyTotalTime;
+    // Report summary
+    std::cout << "\n###############\nSummary\n###############\n";
+    std::cout << "Algorithm\t\tTotal nodes\t\tTotal time\t\tMin\t\tMedian\t\tP90\t\tP99"
+              << "\t\tStddev\n";
+    for (const AlgorithmResults &algorithm : results)
+    {
+        printSummaryRow(algorithm.name, algorithm.expandedNodes, algorithm.times);
+    }
 
-    // Compute totals
-    dijkstraTotalNodes = std::accumulate(expandedDijkstra.begin(), expandedDijkstra.end(), 0);
-    aStarTotalNodes = std::accumulate(expandedAstar.begin(), expandedAstar.end(), 0);
-    aStarAltTotalNodes = std::accumulate(expandedAstarAlt.begin(),
-                                               expandedAstarAlt.end(),
-                                               0);
-    greedyTotalNodes = std::accumulate(expandedGreedy.begin(), expandedGreedy.end(), 0);
+    // Report the preprocessing, which the algorithms sharing it only pay for once, so
+    // only the first of them shows the memory allocated for it
+    std::cout << "\nAlgorithm\t\tPreparation time\t\tMemory (MiB)\t\tAllocated (MiB)\n";
+    for (const AlgorithmResults &algorithm : results)
+    {
+        std::cout << algorithm.name << "\t\t" << algorithm.preparationTime << "\t\t"
+                  << algorithm.memoryUsage / (1024. * 1024.) << "\t\t"
+                  << algorithm.preparationBytes / (1024. * 1024.) << std::endl;
+    }
 
-    dijkstraTotalTime = std::accumulate(timesDijkstra.begin(), timesDijkstra.end(), 0.);
-    aStarTotalTime = std::accumulate(timesAstar.begin(), timesAstar.end(), 0.);
-    aStarAltTotalTime = std::accumulate(timesAstarAlt.begin(),
-                                               timesAstarAlt.end(),
-                                               0.);
-    greedyTotalTime = std::accumulate(timesGreedy.begin(), timesGreedy.end(), 0.);
+    // Report the allocations of the queries, which reuse the shared workspaces and queues
+    // and so only allocate what's their own
+    std::cout << "\nAlgorithm\t\tAllocations/query\t\tAllocated bytes/query"
+              << "\t\tPeak bytes/query\t\tMax peak bytes\n";
+    for (const AlgorithmResults &algorithm : results)
+    {
+        double allocationCount = 0, allocatedBytes = 0, peakBytes = 0;
+        size_t maxPeakBytes = 0;
+        for (const AllocationStats &allocations : algorithm.allocations)
+        {
+            allocationCount += allocations.allocations;
+            allocatedBytes += allocations.allocatedBytes;
+            peakBytes += allocations.peakBytes;
+            maxPeakBytes = std::max(maxPeakBytes, allocations.peakBytes);
+        }
+        double queries = std::max(size_t(1), algorithm.allocations.size());
+        std::cout << algorithm.name << "\t\t" << allocationCount / queries << "\t\t"
+                  << allocatedBytes / queries << "\t\t" << peakBytes / queries << "\t\t"
+                  << maxPeakBytes << std::endl;
+    }
+    printResidentMemory();
 
-    // Report summary
-    std::cout << "\n###############\nSummary\n###############\n";
-    std::cout << "Algorithm\t\tTotal nodes\t\tTotal time\n";
-    std::cout << "Dijkstra\t\t" << dijkstraTotalNodes << "\t\t" << dijkstraTotalTime << std::endl;
-    std::cout << "A*\t\t" << aStarTotalNodes << "\t\t" << aStarTotalTime << std::endl;
-    std::cout << "A*(alt)\t\t" << aStarAltTotalNodes << "\t\t"
-              << aStarAltTotalTime << std::endl;
-    std::cout << "Greedy\t\t" << greedyTotalNodes << "\t\t" << greedyTotalTime << std::endl;
+    // Report the mean performance counters per query, and the instructions per cycle
+    if (perfCounters)
+    {
+        std::cout << "\nAlgorithm";
+        for (int counter = 0; counter < PerfCounters::COUNTER_COUNT; ++counter)
+        {
+            std::cout << "\t\t" << PerfCounters::getName(PerfCounters::eCounter(counter));
+        }
+        std::cout << "\t\tIPC\n";
+        for (const AlgorithmResults &algorithm : results)
+        {
+            PerfCounters::Values means = meanCounters(algorithm.counters);
+            std::cout << algorithm.name;
+            for (double mean : means)
+            {
+                std::cout << "\t\t" << mean;
+            }
+            bool hasIpc = means[PerfCounters::CYCLES] > 0
+                    && means[PerfCounters::INSTRUCTIONS] >= 0;
+            std::cout << "\t\t" << (hasIpc ? means[PerfCounters::INSTRUCTIONS]
+                                          / means[PerfCounters::CYCLES] : -1) << std::endl;
+        }
+    }
+
+    // Report queue operations of the algorithms using a queue of the benchmark
+    bool headerShown = false;
+    for (const AlgorithmResults &algorithm : results)
+    {
+        if (algorithm.hasQueueStats)
+        {
+            if (!headerShown)
+            {
+                std::cout << "\nAlgorithm\t\tPushes\t\tPops\t\tDecrease-keys\n";
+                headerShown = true;
+            }
+            std::cout << algorithm.name << "\t\t" << algorithm.queueStats.pushes << "\t\t"
+                      << algorithm.queueStats.pops << "\t\t"
+                      << algorithm.queueStats.decreaseKeys << std::endl;
+        }
+    }
 }
 
-void Benchmark::evaluateAlgorithm(std::function<unsigned long(void)> alg,
-                                  std::vector<double> &timeVec,
-                                  std::vector<unsigned long> &nodeVec)
+void Benchmark::reportGraph(JsonValue graphInfo, const JsonValue &queries)
 {
-    double timeBegin, timeEnd, elapsedTime;
-    timeBegin = std::clock();
-    unsigned long expandedNodes = alg();
-    timeEnd = std::clock();
-    elapsedTime = double(timeEnd - timeBegin) / CLOCKS_PER_SEC;
+    JsonValue algorithms = JsonValue::array();
+    for (const AlgorithmResults &algorithm : results)
+    {
+        algorithms.push(describeResults(algorithm, perfCounters != nullptr));
+    }
+    graphInfo.set("queries", queries);
+    graphInfo.set("algorithms", algorithms);
 
-    timeVec.push_back(elapsedTime);
-    nodeVec.push_back(expandedNodes);
+    // Written after every graph, so the ones done are kept if a later one fails
+    JsonValue graphs = report["graphs"];
+    graphs.push(graphInfo);
+    report.set("graphs", graphs);
+    std::ofstream file("benchmark.json");
+    report.write(file);
+    file << std::endl;
+
+    if (!baseline.isNull())
+    {
+        compareWithBaseline(graphInfo);
+    }
+}
+
+void Benchmark::compareWithBaseline(const JsonValue &graph)
+{
+    const std::string &type = graph["type"].asString();
+    const JsonValue *baselineGraph = nullptr;
+    const JsonValue &baselineGraphs = baseline["graphs"];
+    for (size_t i = 0; i < baselineGraphs.size(); ++i)
+    {
+        if (baselineGraphs[i]["type"].asString() == type)
+        {
+            baselineGraph = &baselineGraphs[i];
+            break;
+        }
+    }
+    std::cout << "\n###############\nComparison with " << baselineFilename << " (commit "
+              << (baseline.has("commit") ? baseline["commit"].asString() : "unknown")
+              << ")\n###############\n";
+    if (!baselineGraph)
+    {
+        std::cout << "The baseline has no " << type << " graph" << std::endl;
+        return;
+    }
+    if ((*baselineGraph)["file"].asString() != graph["file"].asString())
+    {
+        std::cout << "Warning: the baseline ran on " << (*baselineGraph)["file"].asString()
+                  << " instead" << std::endl;
+    }
+    if (baseline.has("machine") && baseline["machine"].has("cpu")
+            && baseline["machine"]["cpu"].asString() != report["machine"]["cpu"].asString())
+    {
+        std::cout << "Warning: the baseline ran on a different processor, "
+                  << baseline["machine"]["cpu"].asString() << std::endl;
+    }
+    // The expanded nodes and distances of the same queries can be compared one by one, as
+    // they don't depend on the machine
+    bool matchingQueries = sameQueries(graph["queries"], (*baselineGraph)["queries"]);
+    if (!matchingQueries)
+    {
+        std::cout << "The queries differ from the ones of the baseline, comparing the "
+                  << "distributions of expanded nodes only" << std::endl;
+    }
+
+    std::cout << "Algorithm\t\tBaseline median\t\tMedian\t\tChange\t\tp-value"
+              << "\t\tNodes change\t\tVerdict\n";
+    const JsonValue &baselineAlgorithms = (*baselineGraph)["algorithms"];
+    const JsonValue &algorithms = graph["algorithms"];
+    for (size_t i = 0; i < algorithms.size(); ++i)
+    {
+        const JsonValue &algorithm = algorithms[i];
+        const std::string &name = algorithm["name"].asString();
+        const JsonValue *baselineAlgorithm = nullptr;
+        for (size_t j = 0; j < baselineAlgorithms.size(); ++j)
+        {
+            if (baselineAlgorithms[j]["name"].asString() == name)
+            {
+                baselineAlgorithm = &baselineAlgorithms[j];
+            }
+        }
+        std::vector<double> times = getNumbers(algorithm["times"]);
+        std::vector<double> nodes = getNumbers(algorithm["expandedNodes"]);
+        std::vector<double> baselineTimes, baselineNodes;
+        if (baselineAlgorithm)
+        {
+            baselineTimes = getNumbers((*baselineAlgorithm)["times"]);
+            baselineNodes = getNumbers((*baselineAlgorithm)["expandedNodes"]);
+        }
+        if (times.empty() || baselineTimes.empty())
+        {
+            std::cout << name << "\t\t-\t\t-\t\t-\t\t-\t\t-\t\t"
+                      << (baselineAlgorithm ? "no queries" : "new") << std::endl;
+            continue;
+        }
+
+        std::vector<std::string> regressions, improvements;
+        bool enoughQueries = times.size() >= MIN_COMPARED_QUERIES
+                && baselineTimes.size() >= MIN_COMPARED_QUERIES;
+        double median = getDistribution(times).median;
+        double baselineMedian = getDistribution(baselineTimes).median;
+        double timePValue = mannWhitneyPValue(times, baselineTimes);
+        if (enoughQueries && timePValue < SIGNIFICANCE_LEVEL)
+        {
+            if (median > baselineMedian * (1 + MIN_RELATIVE_CHANGE))
+                regressions.push_back("slower");
+            else if (median < baselineMedian * (1 - MIN_RELATIVE_CHANGE))
+                improvements.push_back("faster");
+        }
+
+        double totalNodes = std::accumulate(nodes.begin(), nodes.end(), 0.);
+        double baselineTotalNodes = std::accumulate(baselineNodes.begin(),
+                                                    baselineNodes.end(), 0.);
+        if (matchingQueries)
+        {
+            if (totalNodes > baselineTotalNodes)
+                regressions.push_back("more nodes");
+            else if (totalNodes < baselineTotalNodes)
+                improvements.push_back("fewer nodes");
+
+            // The distances of the exact algorithms can't change
+            std::vector<double> distances = getNumbers(algorithm["distances"]);
+            std::vector<double> baselineDistances
+                    = getNumbers((*baselineAlgorithm)["distances"]);
+            bool distancesDiffer = distances.size() != baselineDistances.size();
+            for (size_t query = 0; !distancesDiffer && query < distances.size(); ++query)
+            {
+                double a = distances[query], b = baselineDistances[query];
+                distancesDiffer = (std::isfinite(a) || std::isfinite(b))
+                        && !(std::abs(a - b) <= 1e-9 * std::max(1., std::abs(b)));
+            }
+            if (algorithm["exact"].asBool() && distancesDiffer)
+            {
+                regressions.push_back("different distances");
+            }
+        }
+        else if (enoughQueries
+                 && mannWhitneyPValue(nodes, baselineNodes) < SIGNIFICANCE_LEVEL)
+        {
+            double nodeMedian = getDistribution(nodes).median;
+            double baselineNodeMedian = getDistribution(baselineNodes).median;
+            if (nodeMedian > baselineNodeMedian * (1 + MIN_RELATIVE_CHANGE))
+                regressions.push_back("more nodes");
+            else if (nodeMedian < baselineNodeMedian * (1 - MIN_RELATIVE_CHANGE))
+                improvements.push_back("fewer nodes");
+        }
+
+        std::string verdict;
+        for (const std::string &change : regressions.empty() ? improvements : regressions)
+        {
+            verdict += (verdict.empty() ? "" : ", ") + change;
+        }
+        if (!regressions.empty())
+        {
+            verdict = "REGRESSION: " + verdict;
+            ++regressionCount;
+        }
+        else if (verdict.empty())
+        {
+            verdict = enoughQueries ? "no significant change" : "too few queries";
+        }
+        double nodeChange = baselineTotalNodes > 0 ? totalNodes / baselineTotalNodes - 1 : 0;
+        std::cout << name << "\t\t" << baselineMedian << "\t\t" << median << "\t\t"
+                  << (median / baselineMedian - 1) * 100 << "%\t\t" << timePValue << "\t\t"
+                  << nodeChange * 100 << "%\t\t" << verdict << std::endl;
+    }
+}
+
+void Benchmark::printResidentMemory()
+{
+    std::vector<std::pair<std::string, size_t>> parts;
+    int nodeCount;
+    if (roadContext)
+    {
+        nodeCount = geolocationGraph.getNodeCount();
+        parts.push_back(std::make_pair("Graph", geolocationGraph.getMemoryUsage()));
+        parts.push_back(std::make_pair("Reverse graph",
+                                       roadContext->getReverseGraph()->getMemoryUsage()));
+        parts.push_back(std::make_pair("Coordinates", geolocations.getMemoryUsage()));
+        parts.push_back(std::make_pair("Workspace",
+                                       roadContext->getWorkspace().getMemoryUsage()));
+        parts.push_back(std::make_pair("Queue", roadContext->getQueue().getMemoryUsage()));
+    }
+    else
+    {
+        // The reverse grid is a view of the grid, with no memory of its own
+        nodeCount = gridGraph->getNodeCount();
+        parts.push_back(std::make_pair("Graph", gridGraph->getMemoryUsage()));
+        parts.push_back(std::make_pair("Workspace",
+                                       gridContext->getWorkspace().getMemoryUsage()));
+        parts.push_back(std::make_pair("Queue", gridContext->getQueue().getMemoryUsage()));
+        BucketQueue<Tile> *bucketQueue = gridContext->getBucketQueue(0);
+        parts.push_back(std::make_pair("Bucket queue",
+                                       bucketQueue ? bucketQueue->getMemoryUsage() : 0));
+    }
+
+    std::cout << "\nStructure\t\tMemory (MiB)\t\tBytes/node\n";
+    size_t total = 0;
+    for (const auto &part : parts)
+    {
+        std::cout << part.first << "\t\t" << part.second / (1024. * 1024.) << "\t\t"
+                  << double(part.second) / nodeCount << std::endl;
+        total += part.second;
+    }
+    std::cout << "Total\t\t" << total / (1024. * 1024.) << "\t\t"
+              << double(total) / nodeCount << std::endl;
+}
+
+AlgorithmResults *Benchmark::findResults(const std::string &name)
+{
+    for (AlgorithmResults &algorithm : results)
+    {
+        if (algorithm.name == name)
+        {
+            return &algorithm;
+        }
+    }
+    return nullptr;
 }
@@ -3,12 +3,39 @@
 
 #include <exception>
 #include <map>
+#include <random>
 #include <string>
-#include <functional>
-#include "gridgraph.h"
+#include "algorithmregistry.hpp"
+#include "allocationtracker.h"
+#include "batchsearch.hpp"
 #include "geolocationgraph.h"
+#include "gridgraph.h"
+#include "json.h"
+#include "movingai.h"
+#include "perfcounters.h"
+#include "priorityqueues.hpp"
+#include "searchengines.h"
+#include "threadpool.h"
 #include "utils.h"
 
+/**
+ * @brief What the benchmark records about an algorithm, one entry per query.
+ */
+typedef struct AlgorithmResults
+{
+    std::string name;  // As registered
+    bool exact;
+    std::vector<double> distances, times;
+    std::vector<unsigned long> expandedNodes;
+    std::vector<PerfCounters::Values> counters;  // Only if the counters are enabled
+    std::vector<AllocationStats> allocations;
+    bool hasQueueStats;
+    QueueStats queueStats;  // Totals over every run
+    double preparationTime;  // Wall-clock seconds spent building the engine
+    size_t memoryUsage;  // As reported by the engine
+    long long preparationBytes;  // Left allocated by building the engine
+} AlgorithmResults;
+
 class Benchmark
 {
 public:
@@ -20,35 +47,195 @@ public:
      * and show results.
      * @param count Number of randomized benchmarks to run.
      *
-     * Stores intermediate results in a file called benchmark.txt
+     * If the file is a MovingAI scenario, ending in .scen, its problems are run instead,
+     * on its map, taking up to count of them from each bucket, or all if it's 0.
+     *
+     * Stores intermediate results in a file called benchmark.txt, and the results of
+     * every query and their aggregates, with the machine and the settings they were run
+     * with, in benchmark.json.
      */
     void run(int count);
 
-private:
-    typedef std::function<unsigned long(void)> Algorithm;
+    /**
+     * @brief Sets the seed of the random start and goal nodes, so runs with the same seed
+     * pick the same ones. A fixed seed is used by default.
+     */
+    void setSeed(unsigned seed);
+
+    /**
+     * @brief Sets whether the bidirectional searches run each of their sides on a thread
+     * of its own. They run on a single thread by default.
+     */
+    void setParallelBidirectional(bool enabled);
+
+    /**
+     * @brief Sets how many untimed runs of each search come before the timed ones, and
+     * how many timed runs are averaged into the time of each search. By default every
+     * search is run once.
+     */
+    void setRepetitions(int warmup, int repetitions);
+
+    /**
+     * @brief Sets the threads used to run batches of queries, or 0 to use as many as the
+     * hardware runs at once, which is the default.
+     */
+    void setThreadCount(int threadCount);
+
+    /**
+     * @brief Sets the algorithms to run, as a comma-separated list of their registered
+     * names, like "dijkstra,astar-manhattan". Each graph runs the ones registered for it,
+     * and a default list of its own if none is set.
+     * @throws std::invalid_argument if a name isn't registered for any graph.
+     */
+    void setAlgorithms(const std::string &names);
+
+    /**
+     * @brief Sets whether the hardware performance counters of every search are recorded,
+     * averaged over the repetitions like the time. They're disabled by default.
+     *
+     * If the kernel doesn't allow any of the counters, they stay disabled, and the ones it
+     * doesn't allow are recorded as -1.
+     */
+    void setPerfCounters(bool enabled);
+
+    /**
+     * @brief Sets a JSON file written by an earlier run to compare the results of each
+     * graph with, flagging the algorithms which got significantly slower or expand more
+     * nodes than they did.
+     * @throws std::runtime_error if the file can't be read or isn't a benchmark report.
+     */
+    void setBaseline(const std::string &baselineFilename);
+
+    /**
+     * @return The number of regressions found comparing with the baseline, if any.
+     */
+    int getRegressionCount() const;
 
 private:
     void buildCoordsMap();
     void buildGeolocationGraph();
-    bool runGridSingle(Tile startTile, Tile goalTile);
-    void runRoadSingle(int startId, int goalId);
+    /**
+     * @brief Builds the engines of the grid searches once the grid has been loaded,
+     * keeping the saved tables next to the grid file, and starts the grid CSV file.
+     */
+    void prepareGridBenchmark(const std::string &gridFilename, const std::string &defaults);
+    /**
+     * @brief Builds the engines of the selected algorithms of a registry, timing their
+     * preprocessing, and writes the header of the CSV file with a distance, expanded nodes
+     * and time column for each one.
+     */
+    template <typename Context>
+    void prepareEngines(const AlgorithmRegistry<Context> &registry, Context &context,
+                        const std::string &defaults, const std::string &csvFilename,
+                        std::vector<SearchEngine<typename Context::Graph>*> &engines);
+    /**
+     * @brief Runs every engine on a query, and records the results and writes them to the
+     * CSV file if the first engine finds a path.
+     * @return Whether the first engine found a path.
+     */
+    template <typename Graph>
+    bool runSingle(const std::vector<SearchEngine<Graph>*> &engines,
+                   typename Graph::Node start, typename Graph::Node goal,
+                   const std::string &csvFilename);
+    void deleteEngines();
     void runSummary();
+    /**
+     * @brief Adds the graph just run, its queries and the results of its algorithms to
+     * the JSON report and writes it, then compares them with the baseline if there's one.
+     * @param graphInfo The type of the graph, its file and its size.
+     * @param queries The start and goal of each query, in the order of the results.
+     */
+    void reportGraph(JsonValue graphInfo, const JsonValue &queries);
+    /**
+     * @brief Prints how the results of a graph compare with the ones of the same graph in
+     * the baseline, and counts the regressions.
+     */
+    void compareWithBaseline(const JsonValue &graph);
+    /**
+     * @brief Prints the memory used by the graph being benchmarked and the search
+     * structures shared by its engines, in total and per node.
+     */
+    void printResidentMemory();
     void runGridBenchmark(int count);
+    /**
+     * @brief Runs the problems of a MovingAI scenario bucket by bucket, with the octile
+     * distance as heuristic by default, and checks the costs found by the exact algorithms
+     * against the optimal ones.
+     */
+    void runScenarioBenchmark(int count);
     void runRoadBenchmark(int count);
-    void evaluateAlgorithm(std::function<unsigned long(void)> alg,
+    /**
+     * @brief Times a distance table between random nodes computed with one-to-many
+     * Dijkstra searches and with the contraction hierarchy, and checks they match.
+     */
+    void runRoadDistanceTable();
+    /**
+     * @brief Times a one-to-all search from a random node with Dijkstra and with
+     * delta-stepping on every core, and checks they match.
+     */
+    void runRoadOneToAll();
+    /**
+     * @brief Runs the queries of the benchmark again as a batch on the thread pool, with
+     * Dijkstra and A* with the heuristic named heuristicName, and compares its wall-clock
+     * time and results with the ones of the single runs. Each of them only runs if it's
+     * among the selected algorithms.
+     */
+    template <typename Graph, typename HeuristicFunction>
+    void runBatch(const Graph *graph, HeuristicFunction heuristic,
+                  const std::string &heuristicName,
+                  const std::vector<std::pair<typename Graph::Node,
+                                              typename Graph::Node>> &queries);
+    /**
+     * @brief Runs a search, given as a callable returning the number of expanded nodes,
+     * and records its wall-clock running time, its allocations and its performance
+     * counters, if enabled, averaged over the repetitions after the warmup runs, and its
+     * expanded nodes. The peak of the allocations is the highest of any repetition.
+     */
+    template <typename Algorithm>
+    void evaluateAlgorithm(Algorithm alg,
                            std::vector<double> &timeVec,
-                           std::vector<unsigned long> &nodeVec);
+                           std::vector<unsigned long> &nodeVec,
+                           std::vector<PerfCounters::Values> &counterVec,
+                           std::vector<AllocationStats> &allocationVec);
+    /**
+     * @return The results of the algorithm with the given name, or nullptr if it isn't
+     * running.
+     */
+    AlgorithmResults *findResults(const std::string &name);
+    /**
+     * @return A random number from 0 to n - 1.
+     */
+    int randomInt(int n);
+    /**
+     * @return A random tile inside the bounds of the grid.
+     */
+    Tile randomTile();
 
 private:
     // Information about the problem to benchmark
     std::string filename;
-    std::map<int, Geolocation> mapIdToGeolocation;
+    std::string algorithmNames;  // Empty to run the default ones
+    GeolocationTable geolocations;
     GridGraph *gridGraph;
     GeolocationGraph geolocationGraph;
+    GridSearchContext *gridContext;
+    RoadSearchContext *roadContext;
+    std::vector<SearchEngine<GridGraph>*> gridEngines;
+    std::vector<SearchEngine<GeolocationGraph>*> roadEngines;
+    std::vector<AlgorithmResults> results;  // Of the engines of the graph being run
+    bool parallelBidirectional;
+    int warmupCount, repetitionCount, threadCount;
+    ThreadPool *threadPool;
+    PerfCounters *perfCounters;  // Only if enabled
+    unsigned seed;
+    std::mt19937 randomEngine;
+    std::vector<std::pair<Tile, Tile>> gridQueries;  // The ones with a path
+    std::vector<std::pair<int, int>> roadQueries;
     int numNodes;
-    std::vector<double> distDijkstra, distAstar, distAstarAlt, distGreedy;
-    std::vector<double> timesDijkstra, timesAstar, timesAstarAlt, timesGreedy;
-    std::vector<unsigned long> expandedDijkstra, expandedAstar, expandedAstarAlt, expandedGreedy;
+    JsonValue report;  // Written to benchmark.json after each graph
+    JsonValue baseline;  // Null if not comparing
+    std::string baselineFilename;
+    int regressionCount;
 };
 
 #endif // BENCHMARK_H
@@ -0,0 +1,452 @@
+#ifndef BIDIRECTIONAL_H
+#define BIDIRECTIONAL_H
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "algorithms.hpp"
+#include "priorityqueues.hpp"
+#include "searchworkspace.hpp"
+
+/**
+ * @brief Potential used by bidirectional A*, the average of the forward estimate to the
+ * goal and the negated backward estimate from the start.
+ *
+ * The forward search uses it as is and the backward search negated, which makes both of
+ * them see the same reduced edge costs. Those are non-negative as long as the heuristic
+ * is consistent in both directions, as any metric on the nodes is.
+ */
+template <typename Node, typename HeuristicFunction>
+struct AveragePotential
+{
+    Node start, goal;
+    HeuristicFunction heuristic;
+
+    double operator()(const Node &node) const
+    {
+        return (heuristic(node, goal) - heuristic(start, node)) / 2;
+    }
+};
+
+/**
+ * Expands the next node of one of the two sides of a bidirectional search.
+ *
+ * Every relaxed edge is also checked against the costs found by the other side, updating
+ * the best path found so far and the node where both sides meet on it.
+ *
+ * @return The number of expanded nodes, which is 0 if the popped node was outdated.
+ */
+template <typename Node, typename Graph, typename State, typename OtherState,
+          typename Queue, typename Potential>
+unsigned long expandBidirectional(Graph *graph,
+                                  State &state,
+                                  const OtherState &otherState,
+                                  Queue &nodeQueue,
+                                  Potential potential,
+                                  double &bestCost,
+                                  Node &meeting)
+{
+    Node current = nodeQueue.pop();
+    // Skip outdated queue entries of nodes that were already expanded
+    if (state.isClosed(current))
+    {
+        return 0;
+    }
+    state.close(current);
+
+    double currentCost = state.getCost(current);
+    graph->forEachNeighbor(current, [&](Node next, double edgeCost) {
+        double cost = currentCost + edgeCost;
+        if (!state.isVisited(next) || cost < state.getCost(next))
+        {
+            state.update(next, current, cost);
+            nodeQueue.push(next, cost + potential(next));
+        }
+        // The edge may join both searches through a better path than the best so far
+        if (otherState.isVisited(next) && cost + otherState.getCost(next) < bestCost)
+        {
+            bestCost = cost + otherState.getCost(next);
+            meeting = next;
+        }
+    });
+    return 1;
+}
+
+/**
+ * Compute the optimal path between two nodes using bidirectional A*.
+ *
+ * A forward search from the start on the graph and a backward search from the goal on
+ * its reverse graph are expanded alternately, picking the one with the lowest reduced
+ * key, until no path through the nodes left in the queues can be shorter than the best
+ * one found so far. Both graphs must number their nodes in the same way, and the
+ * heuristic must be consistent in both directions.
+ *
+ * The optimal path goes through the meeting node, and can be recovered with
+ * reconstructBidirectionalPath. If there's no path, the meeting node won't be visited by
+ * both searches.
+ */
+template <typename Node, typename Graph, typename ReverseGraph,
+          typename ForwardState, typename BackwardState,
+          typename ForwardQueue, typename BackwardQueue, typename HeuristicFunction>
+unsigned long bidirectionalAStar(Graph *graph,
+                                 ReverseGraph *reverseGraph,
+                                 Node start,
+                                 Node goal,
+                                 ForwardState &forwardState,
+                                 BackwardState &backwardState,
+                                 ForwardQueue &forwardQueue,
+                                 BackwardQueue &backwardQueue,
+                                 HeuristicFunction heuristic,
+                                 Node &meeting)
+{
+    AveragePotential<Node, HeuristicFunction> potential{start, goal, heuristic};
+    auto backwardPotential = [&potential](const Node &node) {
+        return -potential(node);
+    };
+    // Offsets turning the keys of each side into distances in the reduced graph
+    double forwardOffset = potential(start),
+           backwardOffset = backwardPotential(goal);
+
+    forwardState.reset();
+    backwardState.reset();
+    forwardState.update(start, start, 0);
+    backwardState.update(goal, goal, 0);
+    forwardQueue.clear();
+    backwardQueue.clear();
+    forwardQueue.push(start, forwardOffset);
+    backwardQueue.push(goal, backwardOffset);
+
+    unsigned long expandedNodes = 0;
+    double bestCost = std::numeric_limits<double>::infinity();
+    meeting = start;
+    if (start == goal)
+    {
+        bestCost = 0;
+    }
+
+    while (!forwardQueue.empty() && !backwardQueue.empty())
+    {
+        double forwardTop = forwardQueue.topPriority(),
+               backwardTop = backwardQueue.topPriority();
+        // Stopping condition, no path through the unexpanded nodes can be shorter
+        if (forwardTop + backwardTop >= bestCost)
+        {
+            break;
+        }
+        if (forwardTop - forwardOffset <= backwardTop - backwardOffset)
+        {
+            expandedNodes += expandBidirectional(graph, forwardState, backwardState,
+                                                 forwardQueue, potential, bestCost, meeting);
+        }
+        else
+        {
+            expandedNodes += expandBidirectional(reverseGraph, backwardState, forwardState,
+                                                 backwardQueue, backwardPotential, bestCost,
+                                                 meeting);
+        }
+    }
+    return expandedNodes;
+}
+
+/**
+ * Compute the optimal path between two nodes using bidirectional Dijkstra.
+ *
+ * Works like bidirectionalAStar, without a heuristic.
+ */
+template <typename Node, typename Graph, typename ReverseGraph,
+          typename ForwardState, typename BackwardState,
+          typename ForwardQueue, typename BackwardQueue>
+unsigned long bidirectionalDijkstra(Graph *graph,
+                                    ReverseGraph *reverseGraph,
+                                    Node start,
+                                    Node goal,
+                                    ForwardState &forwardState,
+                                    BackwardState &backwardState,
+                                    ForwardQueue &forwardQueue,
+                                    BackwardQueue &backwardQueue,
+                                    Node &meeting)
+{
+    return bidirectionalAStar(graph, reverseGraph, start, goal, forwardState, backwardState,
+                              forwardQueue, backwardQueue, ZeroDistance(), meeting);
+}
+
+/**
+ * @return The cost of the path found by a bidirectional search, or -1 if there's none.
+ */
+template <typename Node, typename ForwardState, typename BackwardState>
+double bidirectionalDistance(const ForwardState &forwardState,
+                             const BackwardState &backwardState,
+                             Node meeting)
+{
+    if (!forwardState.isVisited(meeting) || !backwardState.isVisited(meeting))
+    {
+        return -1;
+    }
+    return forwardState.getCost(meeting) + backwardState.getCost(meeting);
+}
+
+/**
+ * Reconstructs the path found by a bidirectional search to a vector with nodes going from
+ * start to goal, joining the forward path to the meeting node and the backward path
+ * from it.
+ */
+template <typename Node, typename ForwardState, typename BackwardState>
+std::vector<Node> reconstructBidirectionalPath(Node start,
+                                               Node goal,
+                                               Node meeting,
+                                               const ForwardState &forwardState,
+                                               const BackwardState &backwardState)
+{
+    std::vector<Node> path;
+    // Follow the forward path backwards until we reach the starting node
+    Node current = meeting;
+    while (current != start)
+    {
+        path.push_back(current);
+        current = forwardState.getPrevious(current);
+    }
+    path.push_back(start);
+    std::reverse(path.begin(), path.end());
+    // The backward search stores the next node of the path as the previous one
+    current = meeting;
+    while (current != goal)
+    {
+        current = backwardState.getPrevious(current);
+        path.push_back(current);
+    }
+    return path;
+}
+
+/**
+ * @brief Bidirectional searches between nodes of a graph, with their own workspaces and
+ * queues, which can run each side on a thread of its own.
+ *
+ * In parallel mode, the forward search runs on the calling thread and the backward one on
+ * a new thread. The cost of every node reached by each side is also published in an
+ * array of atomics, so that each side can detect where it meets the other without
+ * locking. Only the updates of the best path found so far take a lock.
+ *
+ * Both graphs must outlive the search, and number their nodes in the same way.
+ */
+template <typename Graph, typename ReverseGraph>
+class BidirectionalSearch
+{
+public:
+    typedef typename Graph::Node Node;
+
+public:
+    BidirectionalSearch(const Graph *graph, const ReverseGraph *reverseGraph)
+        : graph(graph),
+          reverseGraph(reverseGraph),
+          forwardWorkspace(graph),
+          backwardWorkspace(reverseGraph),
+          forwardQueue(graph),
+          backwardQueue(reverseGraph),
+          parallel(false)
+    {
+    }
+
+    /**
+     * @brief Sets whether or not both sides of the search run on separate threads.
+     */
+    void setParallel(bool enabled)
+    {
+        parallel = enabled;
+        if (parallel && forwardCosts.empty())
+        {
+            int nodeCount = graph->getNodeCount();
+            forwardCosts = std::vector<std::atomic<double>>(nodeCount);
+            backwardCosts = std::vector<std::atomic<double>>(nodeCount);
+            for (int i = 0; i < nodeCount; ++i)
+            {
+                forwardCosts[i].store(INFINITE_COST);
+                backwardCosts[i].store(INFINITE_COST);
+            }
+        }
+    }
+
+    /**
+     * @brief Finds the optimal path between two nodes with bidirectional A*.
+     * @return The number of expanded nodes.
+     */
+    template <typename HeuristicFunction>
+    unsigned long aStar(Node start, Node goal, HeuristicFunction heuristic)
+    {
+        this->start = start;
+        this->goal = goal;
+        if (!parallel)
+        {
+            return bidirectionalAStar(graph, reverseGraph, start, goal,
+                                      forwardWorkspace, backwardWorkspace,
+                                      forwardQueue, backwardQueue, heuristic, meeting);
+        }
+        return parallelAStar(heuristic);
+    }
+
+    /**
+     * @brief Finds the optimal path between two nodes with bidirectional Dijkstra.
+     * @return The number of expanded nodes.
+     */
+    unsigned long dijkstra(Node start, Node goal)
+    {
+        return aStar(start, goal, ZeroDistance());
+    }
+
+    /**
+     * @return The cost of the path found by the last search, or -1 if there was none.
+     */
+    double getCost() const
+    {
+        return bidirectionalDistance(forwardWorkspace, backwardWorkspace, meeting);
+    }
+
+    /**
+     * @return The path found by the last search, which must have found one.
+     */
+    std::vector<Node> getPath() const
+    {
+        return reconstructBidirectionalPath(start, goal, meeting,
+                                            forwardWorkspace, backwardWorkspace);
+    }
+
+private:
+    static constexpr double INFINITE_COST = std::numeric_limits<double>::infinity();
+
+    template <typename HeuristicFunction>
+    unsigned long parallelAStar(HeuristicFunction heuristic)
+    {
+        AveragePotential<Node, HeuristicFunction> potential{start, goal, heuristic};
+        auto backwardPotential = [&potential](const Node &node) {
+            return -potential(node);
+        };
+
+        forwardWorkspace.reset();
+        backwardWorkspace.reset();
+        forwardWorkspace.update(start, start, 0);
+        backwardWorkspace.update(goal, goal, 0);
+        forwardQueue.clear();
+        backwardQueue.clear();
+        forwardQueue.push(start, potential(start));
+        backwardQueue.push(goal, backwardPotential(goal));
+        publish(forwardCosts, forwardTouched, graph->getNodeIndex(start), 0);
+        publish(backwardCosts, backwardTouched, reverseGraph->getNodeIndex(goal), 0);
+        forwardTop.store(forwardQueue.topPriority());
+        backwardTop.store(backwardQueue.topPriority());
+
+        meeting = start;
+        bestCost.store(start == goal ? 0 : INFINITE_COST);
+
+        unsigned long forwardExpanded = 0, backwardExpanded = 0;
+        std::thread backwardThread([&]() {
+            backwardExpanded = runSide(reverseGraph, backwardWorkspace, backwardQueue,
+                                       backwardCosts, backwardTouched, backwardTop,
+                                       forwardCosts, forwardTop, backwardPotential);
+        });
+        forwardExpanded = runSide(graph, forwardWorkspace, forwardQueue,
+                                  forwardCosts, forwardTouched, forwardTop,
+                                  backwardCosts, backwardTop, potential);
+        backwardThread.join();
+
+        // Leave the published costs ready for the next search
+        unpublish(forwardCosts, forwardTouched);
+        unpublish(backwardCosts, backwardTouched);
+        return forwardExpanded + backwardExpanded;
+    }
+
+    /**
+     * @brief Runs one side of a parallel search until both sides can stop.
+     */
+    template <typename SideGraph, typename Potential>
+    unsigned long runSide(const SideGraph *sideGraph,
+                          SearchWorkspace<SideGraph> &workspace,
+                          IndexedHeapQueue<SideGraph> &nodeQueue,
+                          std::vector<std::atomic<double>> &costs,
+                          std::vector<int> &touched,
+                          std::atomic<double> &top,
+                          const std::vector<std::atomic<double>> &otherCosts,
+                          const std::atomic<double> &otherTop,
+                          Potential potential)
+    {
+        unsigned long expandedNodes = 0;
+        while (!nodeQueue.empty())
+        {
+            // The other side's top can only grow, so an outdated value just delays stopping
+            top.store(nodeQueue.topPriority());
+            if (top.load() + otherTop.load() >= bestCost.load())
+            {
+                return expandedNodes;
+            }
+            Node current = nodeQueue.pop();
+            workspace.close(current);
+            ++expandedNodes;
+
+            double currentCost = workspace.getCost(current);
+            sideGraph->forEachNeighbor(current, [&](Node next, double edgeCost) {
+                double cost = currentCost + edgeCost;
+                int index = sideGraph->getNodeIndex(next);
+                if (!workspace.isVisited(next) || cost < workspace.getCost(next))
+                {
+                    workspace.update(next, current, cost);
+                    publish(costs, touched, index, cost);
+                    nodeQueue.push(next, cost + potential(next));
+                }
+                double otherCost = otherCosts[index].load();
+                if (cost + otherCost < bestCost.load())
+                {
+                    std::lock_guard<std::mutex> lock(bestMutex);
+                    if (cost + otherCost < bestCost.load())
+                    {
+                        bestCost.store(cost + otherCost);
+                        meeting = next;
+                    }
+                }
+            });
+        }
+        // Nothing else is reachable from this side, so the other side can stop too
+        top.store(INFINITE_COST);
+        return expandedNodes;
+    }
+
+    static void publish(std::vector<std::atomic<double>> &costs, std::vector<int> &touched,
+                        int index, double cost)
+    {
+        if (costs[index].load() == INFINITE_COST)
+        {
+            touched.push_back(index);
+        }
+        costs[index].store(cost);
+    }
+
+    static void unpublish(std::vector<std::atomic<double>> &costs, std::vector<int> &touched)
+    {
+        for (int index : touched)
+        {
+            costs[index].store(INFINITE_COST);
+        }
+        touched.clear();
+    }
+
+private:
+    const Graph *graph;
+    const ReverseGraph *reverseGraph;
+    SearchWorkspace<Graph> forwardWorkspace;
+    SearchWorkspace<ReverseGraph> backwardWorkspace;
+    IndexedHeapQueue<Graph> forwardQueue;
+    IndexedHeapQueue<ReverseGraph> backwardQueue;
+    Node start, goal, meeting;
+    bool parallel;
+    // Shared between both threads in parallel mode
+    std::vector<std::atomic<double>> forwardCosts, backwardCosts;
+    std::vector<int> forwardTouched, backwardTouched;  // Entries to clear after a search
+    std::atomic<double> forwardTop, backwardTop;
+    std::atomic<double> bestCost;
+    std::mutex bestMutex;
+};
+
+template <typename Graph, typename ReverseGraph>
+constexpr double BidirectionalSearch<Graph, ReverseGraph>::INFINITE_COST;
+
+#endif // BIDIRECTIONAL_H
@@ -0,0 +1,480 @@
+#include "contraction.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <thread>
+#include "bidirectional.hpp"
+
+ContractionHierarchy::ContractionHierarchy(const GeolocationGraph *graph, int threadCount)
+    : graph(graph),
+      threadCount(threadCount),
+      forwardWorkspace(nullptr),
+      backwardWorkspace(nullptr),
+      forwardQueue(nullptr),
+      backwardQueue(nullptr),
+      start(0),
+      goal(0),
+      meeting(0),
+      cost(-1)
+{
+    if (this->threadCount <= 0)
+    {
+        this->threadCount = std::max(1, int(std::thread::hardware_concurrency()));
+    }
+    for (int i = 0; i < this->threadCount; ++i)
+    {
+        witnesses.push_back(new Witness{SearchWorkspace<GeolocationGraph>(graph),
+                                        IndexedHeapQueue<GeolocationGraph>(graph),
+                                        std::vector<uint32_t>(graph->getNodeCount(), 0),
+                                        0});
+    }
+    contract();
+    buildSearchGraphs();
+
+    forwardWorkspace = new SearchWorkspace<HierarchyGraph>(&upwardGraph);
+    backwardWorkspace = new SearchWorkspace<HierarchyGraph>(&downwardGraph);
+    forwardQueue = new IndexedHeapQueue<HierarchyGraph>(&upwardGraph);
+    backwardQueue = new IndexedHeapQueue<HierarchyGraph>(&downwardGraph);
+}
+
+ContractionHierarchy::~ContractionHierarchy()
+{
+    for (Witness *witness : witnesses)
+    {
+        delete witness;
+    }
+    delete forwardWorkspace;
+    delete backwardWorkspace;
+    delete forwardQueue;
+    delete backwardQueue;
+}
+
+unsigned long ContractionHierarchy::query(int start, int goal)
+{
+    this->start = start;
+    this->goal = goal;
+    forwardWorkspace->reset();
+    backwardWorkspace->reset();
+    forwardQueue->clear();
+    backwardQueue->clear();
+    forwardWorkspace->update(start, start, 0);
+    backwardWorkspace->update(goal, goal, 0);
+    forwardQueue->push(start, 0);
+    backwardQueue->push(goal, 0);
+
+    unsigned long expandedNodes = 0;
+    double bestCost = std::numeric_limits<double>::infinity();
+    meeting = -1;
+    while (true)
+    {
+        // Each side stops on its own once it can't improve the best path, as it only
+        // climbs in rank and the best path may meet the other side anywhere above
+        bool forwardDone = forwardQueue->empty() || forwardQueue->topPriority() >= bestCost;
+        bool backwardDone = backwardQueue->empty() || backwardQueue->topPriority() >= bestCost;
+        if (forwardDone && backwardDone)
+        {
+            break;
+        }
+        bool forward = backwardDone
+                || (!forwardDone && forwardQueue->topPriority() <= backwardQueue->topPriority());
+        const HierarchyGraph &sideGraph = forward ? upwardGraph : downwardGraph;
+        SearchWorkspace<HierarchyGraph> &workspace = forward ? *forwardWorkspace
+                                                             : *backwardWorkspace;
+        const SearchWorkspace<HierarchyGraph> &otherWorkspace = forward ? *backwardWorkspace
+                                                                        : *forwardWorkspace;
+        IndexedHeapQueue<HierarchyGraph> &queue = forward ? *forwardQueue : *backwardQueue;
+
+        int current = queue.pop();
+        workspace.close(current);
+        ++expandedNodes;
+        double currentCost = workspace.getCost(current);
+        if (otherWorkspace.isVisited(current)
+                && currentCost + otherWorkspace.getCost(current) < bestCost)
+        {
+            bestCost = currentCost + otherWorkspace.getCost(current);
+            meeting = current;
+        }
+        sideGraph.forEachNeighbor(current, [&](int next, double edgeCost) {
+            double nextCost = currentCost + edgeCost;
+            if (!workspace.isVisited(next) || nextCost < workspace.getCost(next))
+            {
+                workspace.update(next, current, nextCost);
+                queue.push(next, nextCost);
+            }
+        });
+    }
+    cost = meeting < 0 ? -1 : bestCost;
+    return expandedNodes;
+}
+
+double ContractionHierarchy::getCost() const
+{
+    return cost;
+}
+
+std::vector<int> ContractionHierarchy::getPath() const
+{
+    std::vector<int> packed = reconstructBidirectionalPath(start, goal, meeting,
+                                                           *forwardWorkspace,
+                                                           *backwardWorkspace);
+    std::vector<int> path(1, start);
+    for (size_t i = 0; i + 1 < packed.size(); ++i)
+    {
+        unpackEdge(packed[i], packed[i + 1], path);
+    }
+    return path;
+}
+
+std::vector<double> ContractionHierarchy::distanceTable(const std::vector<int> &sources,
+                                                        const std::vector<int> &targets)
+{
+    std::vector<std::vector<BucketEntry>> buckets(graph->getNodeCount());
+    for (size_t j = 0; j < targets.size(); ++j)
+    {
+        searchUpward(downwardGraph, targets[j], *backwardWorkspace, *backwardQueue,
+                     [&](int node, double nodeCost) {
+            buckets[node].push_back(BucketEntry{int(j), nodeCost});
+        });
+    }
+
+    const double infinity = std::numeric_limits<double>::infinity();
+    std::vector<double> table(sources.size() * targets.size(), infinity);
+    for (size_t i = 0; i < sources.size(); ++i)
+    {
+        double *row = &table[i * targets.size()];
+        searchUpward(upwardGraph, sources[i], *forwardWorkspace, *forwardQueue,
+                     [&](int node, double nodeCost) {
+            for (const BucketEntry &entry : buckets[node])
+            {
+                row[entry.target] = std::min(row[entry.target], nodeCost + entry.weight);
+            }
+        });
+    }
+    std::replace(table.begin(), table.end(), infinity, -1.);
+    return table;
+}
+
+size_t ContractionHierarchy::getShortcutCount() const
+{
+    return shortcutMiddles.size();
+}
+
+size_t ContractionHierarchy::getMemoryUsage() const
+{
+    size_t nodes = size_t(graph->getNodeCount()) + 1;
+    size_t edges = upwardGraph.getEdgeCount() + downwardGraph.getEdgeCount();
+    // Offsets of both graphs, and the target and weight of every edge
+    size_t graphs = 2 * nodes * sizeof(uint32_t) + edges * (sizeof(int) + sizeof(double));
+    // Every entry of the map is a node of a list, plus the bucket array
+    size_t middles = shortcutMiddles.size() * (sizeof(std::pair<const uint64_t, int>)
+                                               + sizeof(void*))
+            + shortcutMiddles.bucket_count() * sizeof(void*);
+    return graphs + middles;
+}
+
+template <typename Function>
+void ContractionHierarchy::parallelFor(int count, Function f)
+{
+    std::atomic<int> next(0);
+    auto work = [&](Witness &witness) {
+        for (int begin = next.fetch_add(CHUNK_SIZE); begin < count;
+             begin = next.fetch_add(CHUNK_SIZE))
+        {
+            int end = std::min(begin + CHUNK_SIZE, count);
+            for (int item = begin; item < end; ++item)
+            {
+                f(item, witness);
+            }
+        }
+    };
+    // Small batches aren't worth starting threads for
+    int chunks = (count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    std::vector<std::thread> threads;
+    for (int i = 1; i < std::min(threadCount, chunks); ++i)
+    {
+        threads.emplace_back(work, std::ref(*witnesses[i]));
+    }
+    work(*witnesses[0]);
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+}
+
+template <typename Visitor>
+void ContractionHierarchy::searchUpward(const HierarchyGraph &searchGraph, int source,
+                                        SearchWorkspace<HierarchyGraph> &workspace,
+                                        IndexedHeapQueue<HierarchyGraph> &queue,
+                                        Visitor visit)
+{
+    workspace.reset();
+    queue.clear();
+    workspace.update(source, source, 0);
+    queue.push(source, 0);
+    while (!queue.empty())
+    {
+        int current = queue.pop();
+        workspace.close(current);
+        double currentCost = workspace.getCost(current);
+        visit(current, currentCost);
+        searchGraph.forEachNeighbor(current, [&](int next, double edgeCost) {
+            double nextCost = currentCost + edgeCost;
+            if (!workspace.isVisited(next) || nextCost < workspace.getCost(next))
+            {
+                workspace.update(next, current, nextCost);
+                queue.push(next, nextCost);
+            }
+        });
+    }
+}
+
+void ContractionHierarchy::findShortcuts(int node, int witnessLimit, Witness &witness,
+                                         std::vector<Shortcut> &shortcuts) const
+{
+    SearchWorkspace<GeolocationGraph> &workspace = witness.workspace;
+    IndexedHeapQueue<GeolocationGraph> &queue = witness.queue;
+    for (const Arc &in : inArcs[node])
+    {
+        int from = in.node;
+        if (contracting[from])
+        {
+            continue;
+        }
+        // The witness search only needs to go as far as the longest path through the node,
+        // or until every target is expanded
+        double maxCost = -1;
+        int targets = 0;
+        ++witness.stamp;
+        for (const Arc &out : outArcs[node])
+        {
+            if (out.node != from && !contracting[out.node])
+            {
+                maxCost = std::max(maxCost, in.weight + out.weight);
+                witness.targetStamps[out.node] = witness.stamp;
+                ++targets;
+            }
+        }
+        if (targets == 0)
+        {
+            continue;
+        }
+
+        workspace.reset();
+        queue.clear();
+        workspace.update(from, from, 0);
+        queue.push(from, 0);
+        int expanded = 0;
+        while (!queue.empty() && queue.topPriority() <= maxCost && expanded < witnessLimit
+               && targets > 0)
+        {
+            int current = queue.pop();
+            workspace.close(current);
+            ++expanded;
+            if (witness.targetStamps[current] == witness.stamp)
+            {
+                --targets;
+            }
+            double currentCost = workspace.getCost(current);
+            for (const Arc &arc : outArcs[current])
+            {
+                if (arc.node == node || contracting[arc.node])
+                {
+                    continue;
+                }
+                double nextCost = currentCost + arc.weight;
+                if (!workspace.isVisited(arc.node) || nextCost < workspace.getCost(arc.node))
+                {
+                    workspace.update(arc.node, current, nextCost);
+                    queue.push(arc.node, nextCost);
+                }
+            }
+        }
+
+        // Paths through the node are only kept if there's no witness as short as them
+        for (const Arc &out : outArcs[node])
+        {
+            int to = out.node;
+            double weight = in.weight + out.weight;
+            if (to == from || contracting[to]
+                    || (workspace.isVisited(to) && workspace.getCost(to) <= weight))
+            {
+                continue;
+            }
+            shortcuts.push_back(Shortcut{from, to, node, weight});
+        }
+    }
+}
+
+int ContractionHierarchy::computePriority(int node, Witness &witness) const
+{
+    std::vector<Shortcut> shortcuts;
+    findShortcuts(node, ESTIMATE_LIMIT, witness, shortcuts);
+    int edgeDifference = int(shortcuts.size()) - int(inArcs[node].size() + outArcs[node].size());
+    return edgeDifference + contractedNeighbors[node];
+}
+
+bool ContractionHierarchy::isLocalMinimum(int node) const
+{
+    // Ties are broken by node number, so two neighbors are never both minimums
+    auto goesFirst = [&](const Arc &arc) {
+        return priorities[arc.node] < priorities[node]
+                || (priorities[arc.node] == priorities[node] && arc.node < node);
+    };
+    return std::none_of(outArcs[node].begin(), outArcs[node].end(), goesFirst)
+            && std::none_of(inArcs[node].begin(), inArcs[node].end(), goesFirst);
+}
+
+bool ContractionHierarchy::addArc(std::vector<Arc> &arcs, int node, double weight)
+{
+    for (Arc &arc : arcs)
+    {
+        if (arc.node == node)
+        {
+            if (arc.weight <= weight)
+            {
+                return false;
+            }
+            arc.weight = weight;
+            return true;
+        }
+    }
+    arcs.push_back(Arc{node, weight});
+    return true;
+}
+
+void ContractionHierarchy::removeArcs(std::vector<Arc> &arcs, int node)
+{
+    arcs.erase(std::remove_if(arcs.begin(), arcs.end(), [node](const Arc &arc) {
+        return arc.node == node;
+    }), arcs.end());
+}
+
+void ContractionHierarchy::contract()
+{
+    int nodeCount = graph->getNodeCount();
+    // Parallel edges are merged into the cheapest one, and loops are useless
+    outArcs.assign(nodeCount, std::vector<Arc>());
+    inArcs.assign(nodeCount, std::vector<Arc>());
+    for (int node = 0; node < nodeCount; ++node)
+    {
+        graph->forEachNeighbor(node, [&](int next, double weight) {
+            if (next != node && addArc(outArcs[node], next, weight))
+            {
+                addArc(inArcs[next], node, weight);
+            }
+        });
+    }
+    ranks.assign(nodeCount, -1);
+    contracting.assign(nodeCount, false);
+    contractedNeighbors.assign(nodeCount, 0);
+    priorities.assign(nodeCount, 0);
+    parallelFor(nodeCount, [&](int node, Witness &witness) {
+        priorities[node] = computePriority(node, witness);
+    });
+
+    std::vector<int> remaining(nodeCount);
+    for (int node = 0; node < nodeCount; ++node)
+    {
+        remaining[node] = node;
+    }
+    std::vector<int> batch, neighbors;
+    std::vector<std::vector<Shortcut>> batchShortcuts;
+    std::vector<bool> isNeighbor(nodeCount, false);
+    int nextRank = 0;
+    while (!remaining.empty())
+    {
+        batch.clear();
+        for (int node : remaining)
+        {
+            if (isLocalMinimum(node))
+            {
+                batch.push_back(node);
+                contracting[node] = true;
+            }
+        }
+        batchShortcuts.assign(batch.size(), std::vector<Shortcut>());
+        parallelFor(int(batch.size()), [&](int i, Witness &witness) {
+            findShortcuts(batch[i], WITNESS_LIMIT, witness, batchShortcuts[i]);
+        });
+
+        // Take the batch out of the graph, and link their neighbors with the shortcuts
+        neighbors.clear();
+        for (size_t i = 0; i < batch.size(); ++i)
+        {
+            int node = batch[i];
+            ranks[node] = nextRank++;
+            auto detach = [&](const std::vector<Arc> &arcs, std::vector<std::vector<Arc>> &other) {
+                for (const Arc &arc : arcs)
+                {
+                    removeArcs(other[arc.node], node);
+                    ++contractedNeighbors[arc.node];
+                    if (!isNeighbor[arc.node])
+                    {
+                        isNeighbor[arc.node] = true;
+                        neighbors.push_back(arc.node);
+                    }
+                }
+            };
+            detach(outArcs[node], inArcs);
+            detach(inArcs[node], outArcs);
+            for (const Shortcut &shortcut : batchShortcuts[i])
+            {
+                if (addArc(outArcs[shortcut.from], shortcut.to, shortcut.weight))
+                {
+                    addArc(inArcs[shortcut.to], shortcut.from, shortcut.weight);
+                    shortcutMiddles[edgeKey(shortcut.from, shortcut.to)] = shortcut.middle;
+                }
+            }
+        }
+        for (int node : neighbors)
+        {
+            isNeighbor[node] = false;
+        }
+        parallelFor(int(neighbors.size()), [&](int i, Witness &witness) {
+            priorities[neighbors[i]] = computePriority(neighbors[i], witness);
+        });
+        remaining.erase(std::remove_if(remaining.begin(), remaining.end(), [&](int node) {
+            return ranks[node] >= 0;
+        }), remaining.end());
+    }
+}
+
+void ContractionHierarchy::buildSearchGraphs()
+{
+    // The arcs left on every node lead to the nodes contracted after it
+    int nodeCount = graph->getNodeCount();
+    std::vector<HierarchyGraph::Edge> upwardEdges, downwardEdges;
+    for (int node = 0; node < nodeCount; ++node)
+    {
+        for (const Arc &arc : outArcs[node])
+        {
+            upwardEdges.push_back(HierarchyGraph::Edge{node, arc.node, arc.weight});
+        }
+        for (const Arc &arc : inArcs[node])
+        {
+            downwardEdges.push_back(HierarchyGraph::Edge{node, arc.node, arc.weight});
+        }
+    }
+    upwardGraph = HierarchyGraph(nodeCount, upwardEdges);
+    downwardGraph = HierarchyGraph(nodeCount, downwardEdges);
+
+    // Only the search graphs are needed from now on
+    std::vector<std::vector<Arc>>().swap(outArcs);
+    std::vector<std::vector<Arc>>().swap(inArcs);
+    std::vector<bool>().swap(contracting);
+    std::vector<int>().swap(priorities);
+    std::vector<int>().swap(contractedNeighbors);
+}
+
+void ContractionHierarchy::unpackEdge(int from, int to, std::vector<int> &path) const
+{
+    auto middle = shortcutMiddles.find(edgeKey(from, to));
+    if (middle == shortcutMiddles.end())
+    {
+        path.push_back(to);
+        return;
+    }
+    unpackEdge(from, middle->second, path);
+    unpackEdge(middle->second, to, path);
+}
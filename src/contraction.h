@@ -0,0 +1,211 @@
+#ifndef CONTRACTION_H
+#define CONTRACTION_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "geolocationgraph.h"
+#include "priorityqueues.hpp"
+#include "searchworkspace.hpp"
+
+/**
+ * @brief Graph of the edges of a contraction hierarchy going up in rank, or the reverse
+ * of the ones going down, with double precision weights since shortcuts add them up.
+ */
+typedef CSRGraph<double> HierarchyGraph;
+
+/**
+ * @brief Contraction Hierarchies (CH) over a road network, for fast exact queries after
+ * a preprocessing step.
+ *
+ * Preprocessing contracts the nodes one by one in order of importance: each node is
+ * removed from the graph, adding a shortcut between every pair of its neighbors whose
+ * shortest path went through it. Nodes are ordered by their edge difference, the number
+ * of shortcuts contracting them would add minus the number of edges they would remove,
+ * plus the number of neighbors already contracted to keep the contraction even across
+ * the graph. In every round, the nodes whose priority is lower than the ones of all
+ * their neighbors form an independent set, which is contracted in parallel.
+ *
+ * The rank of a node is the order in which it was contracted. The edges going up in rank
+ * form the upward graph, and the edges going down, reversed, the downward graph. A query
+ * runs Dijkstra from the start on the upward graph and from the goal on the downward
+ * graph, since every shortest path climbs to its most important node and then goes
+ * down. Shortcuts remember the node they skip, so the path found can be unpacked into the
+ * edges of the original graph.
+ */
+class ContractionHierarchy
+{
+public:
+    /**
+     * @brief Preprocesses the given graph, which must outlive the hierarchy, on the given
+     * number of threads, or on as many as the hardware runs at once if it's 0.
+     */
+    explicit ContractionHierarchy(const GeolocationGraph *graph, int threadCount = 0);
+
+    ~ContractionHierarchy();
+
+    /**
+     * @brief Finds the shortest path between two nodes.
+     * @return The number of expanded nodes.
+     */
+    unsigned long query(int start, int goal);
+
+    /**
+     * @return The cost of the path found by the last query, or -1 if there was none.
+     */
+    double getCost() const;
+
+    /**
+     * @return The path found by the last query in the original graph, which must have
+     * found one.
+     */
+    std::vector<int> getPath() const;
+
+    /**
+     * @brief Finds the costs from every source to every target with the bucket method.
+     *
+     * An upward search from each target on the downward graph leaves its cost in a
+     * bucket at every node it reaches. Then an upward search from each source looks at
+     * the buckets of the nodes it reaches, since every shortest path meets both searches
+     * at its most important node. This takes one search per source and target instead of
+     * one query per pair. The state of the last query is lost.
+     *
+     * @return The costs in row-major order, with a row for each source and a column for
+     * each target, and -1 for the targets which can't be reached.
+     */
+    std::vector<double> distanceTable(const std::vector<int> &sources,
+                                      const std::vector<int> &targets);
+
+    /**
+     * @return The number of shortcuts in the hierarchy.
+     */
+    size_t getShortcutCount() const;
+
+    /**
+     * @return An estimate of the memory used by the hierarchy, in bytes.
+     */
+    size_t getMemoryUsage() const;
+
+private:
+    typedef struct Arc
+    {
+        int node;
+        double weight;
+    } Arc;
+
+    typedef struct Shortcut
+    {
+        int from, to, middle;
+        double weight;
+    } Shortcut;
+
+    /**
+     * @brief Cost to reach a target of a distance table from a node.
+     */
+    typedef struct BucketEntry
+    {
+        int target;
+        double weight;
+    } BucketEntry;
+
+    /**
+     * @brief Search state of a thread running witness searches.
+     */
+    typedef struct Witness
+    {
+        SearchWorkspace<GeolocationGraph> workspace;
+        IndexedHeapQueue<GeolocationGraph> queue;
+        // The targets of the current search have the current stamp
+        std::vector<uint32_t> targetStamps;
+        uint32_t stamp;
+    } Witness;
+
+    // Nodes expanded by a witness search before giving up and adding the shortcut, and
+    // by the ones that only estimate the shortcuts to find a priority
+    static const int WITNESS_LIMIT = 500;
+    static const int ESTIMATE_LIMIT = 50;
+    // Items taken at once by each thread of parallelFor
+    static const int CHUNK_SIZE = 64;
+
+    /**
+     * @brief Runs f(item, witness) for every item from 0 to count - 1 on all the threads.
+     */
+    template <typename Function>
+    void parallelFor(int count, Function f);
+
+    /**
+     * @brief Finds the shortcuts needed to contract a node, skipping the contracted
+     * nodes and the ones being contracted, with witness searches that give up after
+     * expanding the given number of nodes.
+     */
+    void findShortcuts(int node, int witnessLimit, Witness &witness,
+                       std::vector<Shortcut> &shortcuts) const;
+
+    /**
+     * @return The priority of a node, where lower ones are contracted first.
+     */
+    int computePriority(int node, Witness &witness) const;
+
+    /**
+     * @return true if the node goes before all its remaining neighbors.
+     */
+    bool isLocalMinimum(int node) const;
+
+    /**
+     * @brief Adds an arc to the graph being contracted, or lowers the weight of the one
+     * already there.
+     * @return false if there already was an arc as cheap.
+     */
+    static bool addArc(std::vector<Arc> &arcs, int node, double weight);
+
+    /**
+     * @brief Removes the arcs leading to a node.
+     */
+    static void removeArcs(std::vector<Arc> &arcs, int node);
+
+    /**
+     * @brief Runs Dijkstra on one of the search graphs from a node to every node above
+     * it, calling visit(node, cost) for every node reached.
+     */
+    template <typename Visitor>
+    void searchUpward(const HierarchyGraph &searchGraph, int source,
+                      SearchWorkspace<HierarchyGraph> &workspace,
+                      IndexedHeapQueue<HierarchyGraph> &queue, Visitor visit);
+
+    void contract();
+    void buildSearchGraphs();
+
+    /**
+     * @brief Appends the original path of an edge of the hierarchy, without its first
+     * node.
+     */
+    void unpackEdge(int from, int to, std::vector<int> &path) const;
+
+    static uint64_t edgeKey(int from, int to)
+    {
+        return uint64_t(uint32_t(from)) << 32 | uint32_t(to);
+    }
+
+private:
+    const GeolocationGraph *graph;
+    int threadCount;
+    std::vector<Witness*> witnesses;  // One for each thread
+
+    // Graph being contracted, with the arcs going out of and into each node. The arcs of
+    // a contracted node are kept, and lead to the nodes ranked above it.
+    std::vector<std::vector<Arc>> outArcs, inArcs;
+    std::vector<int> ranks;  // -1 until contracted
+    std::vector<bool> contracting;
+    std::vector<int> priorities, contractedNeighbors;
+
+    HierarchyGraph upwardGraph, downwardGraph;
+    std::unordered_map<uint64_t, int> shortcutMiddles;  // Node skipped by each shortcut
+
+    // State of the last query
+    SearchWorkspace<HierarchyGraph> *forwardWorkspace, *backwardWorkspace;
+    IndexedHeapQueue<HierarchyGraph> *forwardQueue, *backwardQueue;
+    int start, goal, meeting;
+    double cost;
+};
+
+#endif // CONTRACTION_H
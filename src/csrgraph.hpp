@@ -0,0 +1,202 @@
+#ifndef CSRGRAPH_H
+#define CSRGRAPH_H
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "graph.hpp"
+
+/**
+ * @brief A CSRGraph is an immutable, positively weighted directed graph stored in
+ * compressed sparse row form.
+ *
+ * Nodes are the integers from 0 to N-1. The edges going out of a node are stored
+ * contiguously, so the whole graph is just three flat arrays: the offset of the first
+ * edge of each node, and the target and weight of every edge. The weight type can be
+ * chosen to trade precision for memory, for example float or int.
+ */
+template <typename Weight>
+class CSRGraph : public Graph<int>
+{
+public:
+    typedef struct Edge
+    {
+        int from, to;
+        Weight weight;
+    } Edge;
+
+public:
+    /**
+     * @brief Default constructor.
+     *
+     * Creates a graph with no nodes.
+     */
+    CSRGraph() : Graph<int>(), offsets(1, 0) {}
+
+    /**
+     * @brief Builds the graph from a list of edges, in two passes over them: the first
+     * counts the edges going out of each node, which gives the offsets, and the second
+     * places every edge in the slots of its source node.
+     *
+     * The edges going out of each node keep the order they had in the list. Parallel
+     * edges are kept as they are.
+     *
+     * @param nodeCount Number of nodes in the graph.
+     * @param edges List of edges, with both endpoints between 0 and nodeCount - 1.
+     *
+     * @throws std::out_of_range if an edge references a node that doesn't exist.
+     */
+    CSRGraph(int nodeCount, const std::vector<Edge> &edges)
+        : Graph<int>(),
+          offsets(nodeCount + 1, 0),
+          targets(edges.size()),
+          weights(edges.size())
+    {
+        // Count the edges going out of each node
+        for (const Edge &edge : edges)
+        {
+            if (edge.from < 0 || edge.from >= nodeCount
+                    || edge.to < 0 || edge.to >= nodeCount)
+            {
+                throw std::out_of_range("Edge references a node out of range");
+            }
+            ++offsets[edge.from + 1];
+        }
+        // Turn the counts into offsets
+        for (int i = 0; i < nodeCount; ++i)
+        {
+            offsets[i + 1] += offsets[i];
+        }
+        // Place every edge in the first free slot of its source node
+        std::vector<uint32_t> next(offsets.begin(), offsets.end() - 1);
+        for (const Edge &edge : edges)
+        {
+            uint32_t slot = next[edge.from]++;
+            targets[slot] = edge.to;
+            weights[slot] = edge.weight;
+        }
+    }
+
+    /**
+     * @brief Return a list of all the nodes that can be accessed from this node.
+     */
+    virtual std::vector<int> neighbors(int node)
+    {
+        return std::vector<int>(targets.begin() + offsets[node],
+                                targets.begin() + offsets[node + 1]);
+    }
+
+    /**
+     * @brief Calls visit(neighbor, cost) for every edge going out of this node.
+     */
+    template <typename Visitor>
+    void forEachNeighbor(int node, Visitor visit) const
+    {
+        for (uint32_t i = offsets[node], end = offsets[node + 1]; i < end; ++i)
+        {
+            visit(targets[i], double(weights[i]));
+        }
+    }
+
+    /**
+     * @return The cost of the edge in the graph going from node1 to node2.
+     *
+     * If there's no edge from node1 to node2, it returns -1, meaning an infinite cost.
+     * If there are parallel edges, the cheapest one is used.
+     */
+    double getCost(int node2, int node1) const
+    {
+        double cost = -1;
+        forEachNeighbor(node1, [&](int next, double edgeCost) {
+            if (next == node2 && (cost < 0 || edgeCost < cost))
+            {
+                cost = edgeCost;
+            }
+        });
+        return cost;
+    }
+
+    /**
+     * @brief Checks if the node exists in the graph.
+     */
+    bool exists(int node) const
+    {
+        return node >= 0 && node < getNodeCount();
+    }
+
+    /**
+     * @brief Checks if an edge from node1 to node2 exists in the graph.
+     */
+    bool exists(int node1, int node2) const
+    {
+        return exists(node1) && exists(node2) && getCost(node2, node1) >= 0;
+    }
+
+    /**
+     * @return The number of nodes in the graph.
+     */
+    int getNodeCount() const
+    {
+        return int(offsets.size()) - 1;
+    }
+
+    /**
+     * @return The index of a node, which for this graph is the node itself.
+     */
+    int getNodeIndex(int node) const
+    {
+        return node;
+    }
+
+    /**
+     * @return The node with the given index, which for this graph is the index itself.
+     */
+    int getNode(int index) const
+    {
+        return index;
+    }
+
+    /**
+     * @return A graph with the same nodes and every edge reversed, keeping its weight.
+     *
+     * Searching it finds the paths that lead to a node instead of the ones leaving it,
+     * as needed by the backward half of a bidirectional search.
+     */
+    CSRGraph reversed() const
+    {
+        std::vector<Edge> edges;
+        edges.reserve(targets.size());
+        for (int node = 0; node < getNodeCount(); ++node)
+        {
+            for (uint32_t i = offsets[node]; i < offsets[node + 1]; ++i)
+            {
+                edges.push_back(Edge{targets[i], node, weights[i]});
+            }
+        }
+        return CSRGraph(getNodeCount(), edges);
+    }
+
+    /**
+     * @return The number of edges in the graph.
+     */
+    size_t getEdgeCount() const
+    {
+        return targets.size();
+    }
+
+    /**
+     * @return The memory used by the offsets and the edges, in bytes.
+     */
+    size_t getMemoryUsage() const
+    {
+        return offsets.capacity() * sizeof(uint32_t) + targets.capacity() * sizeof(int)
+                + weights.capacity() * sizeof(Weight);
+    }
+
+private:
+    std::vector<uint32_t> offsets;  // First edge of each node, plus the total at the end
+    std::vector<int> targets;
+    std::vector<Weight> weights;
+};
+
+#endif // CSRGRAPH_H
@@ -89,7 +89,8 @@ GridGraph* CSVEncoder::loadGridGraph()
     {
         --top;
     }
-    GridGraph *graph = new GridGraph(left, top, width, height);
+    // Maps usually have only a few distinct weights, so use the compact storage
+    GridGraph *graph = new GridGraph(left, top, width, height, GridGraph::COMPACT);
 
     // Load all costs
     for (int y = top; y < top + height; ++y)
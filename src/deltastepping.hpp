@@ -0,0 +1,366 @@
+#ifndef DELTASTEPPING_H
+#define DELTASTEPPING_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Parallel single-source shortest paths to every node of a graph with
+ * delta-stepping.
+ *
+ * Nodes are kept in buckets of width delta by their tentative cost, and the buckets are
+ * settled in order. The nodes of a bucket are all expanded at once, relaxing only their
+ * light edges, not longer than delta, which can put nodes back in the same bucket. Once
+ * the bucket stays empty its nodes are final, and their heavy edges are relaxed, which
+ * can only reach later buckets. A delta close to 0 behaves like Dijkstra, and a huge one
+ * like Bellman-Ford.
+ *
+ * Every node is owned by one thread, which keeps the buckets of its nodes and is the
+ * only one writing their costs. Threads expand their own nodes and send the relaxations
+ * of other threads' nodes to them, so no locks or atomics are needed on the costs, only
+ * a barrier between the steps.
+ *
+ * The graph must provide getNodeCount(), getNodeIndex(node), getNode(index) and a
+ * constant forEachNeighbor(node, visit), and its edge costs must not be negative.
+ */
+template <typename Graph>
+class DeltaStepping
+{
+public:
+    typedef typename Graph::Node Node;
+
+public:
+    /**
+     * @brief Prepares searches on the given graph, which must outlive the engine.
+     * @param threadCount Threads to run on, or as many as the hardware runs at once if
+     * it's 0.
+     * @param delta Width of the buckets, or the mean edge cost if it's 0.
+     * @throws std::invalid_argument if delta is negative.
+     */
+    explicit DeltaStepping(const Graph *graph, int threadCount = 0, double delta = 0)
+        : graph(graph),
+          threadCount(threadCount),
+          delta(delta),
+          costs(graph->getNodeCount()),
+          parents(graph->getNodeCount()),
+          bucketOf(graph->getNodeCount()),
+          barrier(0)
+    {
+        if (delta < 0)
+        {
+            throw std::invalid_argument("Delta must not be negative");
+        }
+        if (this->threadCount <= 0)
+        {
+            this->threadCount = std::max(1, int(std::thread::hardware_concurrency()));
+        }
+        // The ring of buckets needs to span the longest edge
+        double totalCost = 0, maxCost = 0;
+        long edgeCount = 0;
+        for (int index = 0; index < graph->getNodeCount(); ++index)
+        {
+            graph->forEachNeighbor(graph->getNode(index), [&](Node, double cost) {
+                totalCost += cost;
+                maxCost = std::max(maxCost, cost);
+                ++edgeCount;
+            });
+        }
+        if (this->delta == 0)
+        {
+            this->delta = edgeCount > 0 && totalCost > 0 ? totalCost / edgeCount : 1;
+        }
+        bucketCount = int(maxCost / this->delta) + 2;
+        workers.resize(this->threadCount);
+        for (Worker &worker : workers)
+        {
+            worker.buckets.resize(bucketCount);
+            worker.outboxes.resize(this->threadCount);
+        }
+        barrier.threadCount = this->threadCount;
+    }
+
+    /**
+     * @brief Finds the cost of the best path from a node to every other one.
+     */
+    void run(const Node &start)
+    {
+        std::fill(costs.begin(), costs.end(), std::numeric_limits<double>::infinity());
+        std::fill(bucketOf.begin(), bucketOf.end(), NO_BUCKET);
+        for (Worker &worker : workers)
+        {
+            for (std::vector<int> &bucket : worker.buckets)
+            {
+                bucket.clear();
+            }
+        }
+        int startIndex = graph->getNodeIndex(start);
+        costs[startIndex] = 0;
+        parents[startIndex] = startIndex;
+        bucketOf[startIndex] = 0;
+        workers[owner(startIndex)].buckets[0].push_back(startIndex);
+
+        std::vector<std::thread> threads;
+        for (int i = 1; i < threadCount; ++i)
+        {
+            threads.emplace_back(&DeltaStepping::work, this, i);
+        }
+        work(0);
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    /**
+     * @return true if the node was reached by the last run.
+     */
+    bool isReached(const Node &node) const
+    {
+        return costs[graph->getNodeIndex(node)] != std::numeric_limits<double>::infinity();
+    }
+
+    /**
+     * @return The cost of the best path to a node reached by the last run.
+     */
+    double getCost(const Node &node) const
+    {
+        return costs[graph->getNodeIndex(node)];
+    }
+
+    /**
+     * @return The node before a node reached by the last run in its best path, or the
+     * node itself for the start.
+     */
+    Node getPrevious(const Node &node) const
+    {
+        return graph->getNode(parents[graph->getNodeIndex(node)]);
+    }
+
+    /**
+     * @brief Records the result of the last run in a search state, like a MapSearchState
+     * or a SearchWorkspace, as if Dijkstra had expanded every node reached.
+     */
+    template <typename State>
+    void copyTo(State &state) const
+    {
+        state.reset();
+        for (int index = 0; index < int(costs.size()); ++index)
+        {
+            if (costs[index] != std::numeric_limits<double>::infinity())
+            {
+                Node node = graph->getNode(index);
+                state.update(node, graph->getNode(parents[index]), costs[index]);
+                state.close(node);
+            }
+        }
+    }
+
+    double getDelta() const
+    {
+        return delta;
+    }
+
+    int getThreadCount() const
+    {
+        return threadCount;
+    }
+
+private:
+    typedef struct Request
+    {
+        int node, parent;
+        double cost;
+    } Request;
+
+    /**
+     * @brief Buckets of the nodes owned by a thread, and the relaxations it sends to each
+     * thread.
+     */
+    typedef struct Worker
+    {
+        std::vector<std::vector<int>> buckets;  // A ring, indexed by bucket modulo its size
+        std::vector<std::vector<Request>> outboxes;
+        std::vector<int> current, settled;  // Nodes taken from the bucket being settled
+    } Worker;
+
+    /**
+     * @brief Barrier for all the threads of a run, which also finds the lowest of the
+     * values given by the threads.
+     */
+    typedef struct Barrier
+    {
+        std::mutex mutex;
+        std::condition_variable condition;
+        int threadCount, waiting;
+        unsigned generation;
+        long minimum, result;
+
+        explicit Barrier(int threadCount)
+            : threadCount(threadCount),
+              waiting(0),
+              generation(0),
+              minimum(NO_BUCKET),
+              result(NO_BUCKET)
+        {
+        }
+
+        long wait(long value)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            minimum = std::min(minimum, value);
+            unsigned arrival = generation;
+            if (++waiting == threadCount)
+            {
+                result = minimum;
+                minimum = NO_BUCKET;
+                waiting = 0;
+                ++generation;
+                condition.notify_all();
+                return result;
+            }
+            condition.wait(lock, [&]() { return generation != arrival; });
+            return result;
+        }
+    } Barrier;
+
+    static const long NO_BUCKET = std::numeric_limits<long>::max();
+
+    int owner(int index) const
+    {
+        return index % threadCount;
+    }
+
+    long bucketIndex(double cost) const
+    {
+        return long(cost / delta);
+    }
+
+    /**
+     * @return The lowest bucket a thread has nodes in, at or after the given one.
+     */
+    long findNextBucket(Worker &worker, long from) const
+    {
+        for (long bucket = from; bucket < from + bucketCount; ++bucket)
+        {
+            if (!worker.buckets[bucket % bucketCount].empty())
+            {
+                return bucket;
+            }
+        }
+        return NO_BUCKET;
+    }
+
+    /**
+     * @brief Sends the relaxations of the light or heavy edges of the given nodes to
+     * their owners.
+     */
+    void relaxEdges(Worker &worker, const std::vector<int> &nodes, bool light)
+    {
+        for (int index : nodes)
+        {
+            double cost = costs[index];
+            graph->forEachNeighbor(graph->getNode(index), [&](Node next, double edgeCost) {
+                if ((edgeCost <= delta) == light)
+                {
+                    int nextIndex = graph->getNodeIndex(next);
+                    worker.outboxes[owner(nextIndex)].push_back(
+                                Request{nextIndex, index, cost + edgeCost});
+                }
+            });
+        }
+    }
+
+    /**
+     * @brief Applies the relaxations sent to a thread, moving the improved nodes to
+     * their new buckets.
+     */
+    void applyRequests(int thread)
+    {
+        Worker &worker = workers[thread];
+        for (Worker &sender : workers)
+        {
+            for (const Request &request : sender.outboxes[thread])
+            {
+                if (request.cost < costs[request.node])
+                {
+                    costs[request.node] = request.cost;
+                    parents[request.node] = request.parent;
+                    long bucket = bucketIndex(request.cost);
+                    // Nodes left in their old bucket are skipped when it's taken
+                    if (bucketOf[request.node] != bucket)
+                    {
+                        bucketOf[request.node] = bucket;
+                        worker.buckets[bucket % bucketCount].push_back(request.node);
+                    }
+                }
+            }
+            sender.outboxes[thread].clear();
+        }
+    }
+
+    /**
+     * @brief Runs the part of a run of one of the threads.
+     */
+    void work(int thread)
+    {
+        Worker &worker = workers[thread];
+        long bucket = barrier.wait(findNextBucket(worker, 0));
+        while (bucket != NO_BUCKET)
+        {
+            std::vector<int> &nodes = worker.buckets[bucket % bucketCount];
+            worker.settled.clear();
+            while (true)
+            {
+                // Take the nodes still in the bucket, which may have been put back in it
+                worker.current.clear();
+                for (int index : nodes)
+                {
+                    if (bucketOf[index] == bucket)
+                    {
+                        bucketOf[index] = NO_BUCKET;
+                        worker.current.push_back(index);
+                    }
+                }
+                nodes.clear();
+                bool empty = barrier.wait(worker.current.empty() ? NO_BUCKET : bucket)
+                        == NO_BUCKET;
+                if (empty)
+                {
+                    break;
+                }
+                relaxEdges(worker, worker.current, true);
+                worker.settled.insert(worker.settled.end(), worker.current.begin(),
+                                      worker.current.end());
+                barrier.wait(NO_BUCKET);
+                applyRequests(thread);
+                barrier.wait(NO_BUCKET);
+            }
+            // The nodes of the bucket are final, so their heavy edges can be relaxed
+            relaxEdges(worker, worker.settled, false);
+            barrier.wait(NO_BUCKET);
+            applyRequests(thread);
+            bucket = barrier.wait(findNextBucket(worker, bucket + 1));
+        }
+    }
+
+private:
+    const Graph *graph;
+    int threadCount;
+    double delta;
+    int bucketCount;
+    std::vector<double> costs;
+    std::vector<int> parents;
+    std::vector<long> bucketOf;  // Bucket each node is waiting in, or NO_BUCKET
+    std::vector<Worker> workers;
+    Barrier barrier;
+};
+
+template <typename Graph>
+const long DeltaStepping<Graph>::NO_BUCKET;
+
+#endif // DELTASTEPPING_H
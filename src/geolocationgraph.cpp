@@ -1,5 +1,6 @@
 #include "geolocationgraph.h"
 #include <cmath>
+#include <stdexcept>
 
 void Geolocation::computeCartesianCoordinates()
 {
@@ -11,3 +12,58 @@ void Geolocation::computeCartesianCoordinates()
     y = radius * std::cos(theta) * std::sin(phi);
     z = radius * std::sin(theta);
 }
+
+int GeolocationTable::addNode(int id, int latitude, int longitude)
+{
+    int index = size();
+    if (!indexOfId.emplace(id, index).second)
+    {
+        throw std::invalid_argument("Duplicated node id");
+    }
+    Geolocation node{id, latitude, longitude, 0, 0, 0};
+    node.computeCartesianCoordinates();
+
+    ids.push_back(id);
+    double theta = (latitude / 1e6) * M_PI / 180;
+    latitudes.push_back(theta);
+    longitudes.push_back((longitude / 1e6) * M_PI / 180);
+    cosLatitudes.push_back(std::cos(theta));
+    x.push_back(node.x);
+    y.push_back(node.y);
+    z.push_back(node.z);
+    return index;
+}
+
+int GeolocationTable::getIndex(int id) const
+{
+    auto it = indexOfId.find(id);
+    return it == indexOfId.end() ? -1 : it->second;
+}
+
+int GeolocationTable::getId(int index) const
+{
+    return ids[index];
+}
+
+Geolocation GeolocationTable::getGeolocation(int index) const
+{
+    int latitude = int(std::lround(latitudes[index] * 180 / M_PI * 1e6));
+    int longitude = int(std::lround(longitudes[index] * 180 / M_PI * 1e6));
+    return Geolocation{ids[index], latitude, longitude, x[index], y[index], z[index]};
+}
+
+int GeolocationTable::size() const
+{
+    return int(ids.size());
+}
+
+size_t GeolocationTable::getMemoryUsage() const
+{
+    // Every entry of the map of identifiers is a node of a list, plus the bucket array
+    size_t indexBytes = indexOfId.size() * (sizeof(std::pair<const int, int>)
+                                            + sizeof(void*))
+            + indexOfId.bucket_count() * sizeof(void*);
+    size_t coordinates = latitudes.capacity() + longitudes.capacity()
+            + cosLatitudes.capacity() + x.capacity() + y.capacity() + z.capacity();
+    return indexBytes + ids.capacity() * sizeof(int) + coordinates * sizeof(double);
+}
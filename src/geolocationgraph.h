@@ -1,7 +1,10 @@
 #ifndef GEOLOCATIONGRAPH_H
 #define GEOLOCATIONGRAPH_H
 
-#include "graph.hpp"
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+#include "csrgraph.hpp"
 
 typedef struct Geolocation
 {
@@ -28,6 +31,91 @@ typedef struct Geolocation
     }
 } Geolocation;
 
-typedef SimpleGraph<Geolocation> GeolocationGraph;
+/**
+ * @brief Coordinates of the nodes of a road network, stored as a structure of arrays.
+ *
+ * Nodes are added with their original (for example, DIMACS) identifiers, and each one
+ * gets a dense index from 0 to N-1 in the order they're added. Graphs and searches only
+ * deal with those indices, and the distance functions read the coordinates of a node
+ * from contiguous arrays by index.
+ */
+class GeolocationTable
+{
+public:
+    /**
+     * @brief Adds a node with the given original identifier and coordinates.
+     * @return The dense index assigned to the node.
+     * @throws std::invalid_argument if a node with the same identifier was already added.
+     */
+    int addNode(int id, int latitude, int longitude);
+
+    /**
+     * @return The dense index of the node with the given original identifier, or -1 if
+     * there's no such node.
+     */
+    int getIndex(int id) const;
+
+    /**
+     * @return The original identifier of the node with the given index.
+     */
+    int getId(int index) const;
+
+    /**
+     * @return The full geolocation of the node with the given index.
+     */
+    Geolocation getGeolocation(int index) const;
+
+    /**
+     * @return The number of nodes in the table.
+     */
+    int size() const;
+
+    /**
+     * @return The memory used by the identifiers and the coordinates, in bytes.
+     */
+    size_t getMemoryUsage() const;
+
+    /**
+     * @brief Compute the straight line distance between two nodes, through the Earth.
+     */
+    double euclideanDistance3D(int a, int b) const
+    {
+        double dx = x[a] - x[b],
+               dy = y[a] - y[b],
+               dz = z[a] - z[b];
+        return std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+
+    /**
+     * @brief Find the distance along the Earth's surface between two nodes using the
+     * Haversine formula.
+     */
+    double haversineDistance(int a, int b) const
+    {
+        double sinLat = std::sin((latitudes[b] - latitudes[a]) / 2);
+        double sinLong = std::sin((longitudes[b] - longitudes[a]) / 2);
+        double asinArgument = std::sqrt(
+                    sinLat * sinLat + cosLatitudes[a] * cosLatitudes[b] * sinLong * sinLong
+                    );
+        return 2 * Geolocation::radius * std::asin(asinArgument);
+    }
+
+private:
+    std::unordered_map<int, int> indexOfId;
+    std::vector<int> ids;
+    // Latitude and longitude in radians, and the cosine of the latitude
+    std::vector<double> latitudes, longitudes, cosLatitudes;
+    // Cartesian coordinates in meters
+    std::vector<double> x, y, z;
+};
+
+/**
+ * @brief Road network graph, where nodes are indices in a GeolocationTable and edge
+ * weights are distances in meters.
+ *
+ * Single precision is plenty for the length of a road segment, and halves the size of
+ * the weights array.
+ */
+typedef CSRGraph<float> GeolocationGraph;
 
 #endif // GEOLOCATIONGRAPH_H
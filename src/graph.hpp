@@ -4,9 +4,23 @@
 #include <map>
 #include <vector>
 
+/**
+ * @brief Base class for all graphs.
+ *
+ * Besides neighbors(), every graph also provides a non-virtual template method
+ *
+ *     template <typename Visitor> void forEachNeighbor(T node, Visitor visit) const;
+ *
+ * which calls visit(neighbor, cost) for every node reachable from the given node, where
+ * cost is the cost of the edge going to it. Unlike neighbors(), it doesn't allocate, so
+ * it's the one used by the pathfinding algorithms.
+ */
 template <typename T>
 class Graph
 {
+public:
+    typedef T Node;
+
 public:
     Graph() = default;
     virtual ~Graph() = default;
@@ -40,15 +54,31 @@ public:
     virtual std::vector<T> neighbors(T node)
     {
         std::vector<T> result;
-        Edges nodeEdges = _edges[node];
-        for (auto it = nodeEdges.begin(); it != nodeEdges.end(); ++it)
-        {
+        forEachNeighbor(node, [&result](const T &next, double) {
             // Push back only the identifiers
-            result.push_back(it->first);
-        }
+            result.push_back(next);
+        });
         return result;
     }
 
+    /**
+     * @brief Calls visit(neighbor, cost) for every edge going out of this node, in the
+     * same order as neighbors(), without copying the edges.
+     */
+    template <typename Visitor>
+    void forEachNeighbor(const T &node, Visitor visit) const
+    {
+        auto it = _edges.find(node);
+        if (it == _edges.end())
+        {
+            return;
+        }
+        for (auto edge = it->second.begin(); edge != it->second.end(); ++edge)
+        {
+            visit(edge->first, edge->second);
+        }
+    }
+
     /**
      * @brief Checks if the node exists in the graph.
      */
@@ -67,7 +97,7 @@ public:
         {
             return false;
         }
-        Edges node1Edges = _edges[node1];
+        const Edges &node1Edges = _edges.find(node1)->second;
         auto it = node1Edges.find(node2);
         return it != node1Edges.end();
     }
@@ -81,10 +111,14 @@ public:
     virtual double getCost(T node2, T node1)
     {
         // Get edges coming out of node1
-        Edges nodeEdges = _edges[node1];
+        auto nodeEdges = _edges.find(node1);
+        if (nodeEdges == _edges.end())
+        {
+            return -1;
+        }
         // If there's no connection to node2, return -1
-        auto it = nodeEdges.find(node2);
-        if (it == nodeEdges.end())
+        auto it = nodeEdges->second.find(node2);
+        if (it == nodeEdges->second.end())
         {
             return -1;
         }
@@ -124,6 +158,26 @@ public:
         _edges[node1][node2] = cost;
     }
 
+    /**
+     * @return A copy of this graph with every edge reversed, keeping its cost.
+     */
+    SimpleGraph<T> reversed() const
+    {
+        SimpleGraph<T> result;
+        for (auto node = _edges.begin(); node != _edges.end(); ++node)
+        {
+            result.addNode(node->first);
+        }
+        for (auto node = _edges.begin(); node != _edges.end(); ++node)
+        {
+            for (auto edge = node->second.begin(); edge != node->second.end(); ++edge)
+            {
+                result._edges[edge->first][node->first] = edge->second;
+            }
+        }
+        return result;
+    }
+
 private:
     std::map<T, Edges> _edges;
 };
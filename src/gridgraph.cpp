@@ -1,53 +1,108 @@
 #include "gridgraph.h"
 #include "graph.hpp"
 #include "utils.h"
+#include <algorithm>
+#include <cmath>
 #include <limits>
+#include <stdexcept>
 
-GridGraph::GridGraph(int left, int top, int width, int height)
+/**
+ * @brief Tables mapping a neighbor mask to the directions that can actually be taken,
+ * one for each combination of the diagonal and corner movement settings.
+ */
+struct SuccessorRules
+{
+    uint8_t straight[256], diagonal[256], cornerMovement[256];
+
+    SuccessorRules()
+    {
+        for (int mask = 0; mask < 256; ++mask)
+        {
+            bool east = mask & 1, north = mask & 2, west = mask & 4, south = mask & 8;
+            // A diagonal is only allowed without corner movement if both tiles on its
+            // sides are walkable
+            int cornerFree = (east && south) << 4 | (west && north) << 5
+                    | (west && south) << 6 | (east && north) << 7;
+            straight[mask] = mask & 0x0F;
+            diagonal[mask] = mask & (0x0F | cornerFree);
+            cornerMovement[mask] = mask;
+        }
+    }
+};
+
+static const SuccessorRules SUCCESSOR_RULES;
+
+GridGraph::GridGraph(int left, int top, int width, int height, eStorage storage)
     : Graph(),
       left(left),
       top(top),
       right(left + width),
       bottom(top + height),
+      storage(storage),
+      wordsPerRow((width + 63) / 64),
       diagonalAllowed(false),
-      cornerMovementAllowed(false)
+      cornerMovementAllowed(false),
+      diagonalCostFactor(1)
 {
+    size_t tileCount = size_t(width) * height;
+    if (storage == DENSE)
+    {
+        costs.assign(tileCount, 1.);
+    }
+    else
+    {
+        // Every tile starts as floor, which is the first palette entry
+        palette.push_back(1.);
+        terrain.assign(tileCount, 0);
+    }
+    walls.assign(size_t(wordsPerRow) * height, 0);
+    if (tileCount > 0)
+    {
+        costCounts[1.] = tileCount;
+    }
+
+    // With no walls, only the grid bounds limit the movement
+    masks.assign(tileCount, 0);
+    for (int y = top; y < bottom; ++y)
+    {
+        for (int x = left; x < right; ++x)
+        {
+            uint8_t mask = 0;
+            for (int i = 0; i < 8; ++i)
+            {
+                if (!isOutOfBounds(Tile{x + MASK_DIRS[i].x, y + MASK_DIRS[i].y}))
+                    mask |= 1 << i;
+            }
+            masks[index(Tile{x, y})] = mask;
+        }
+    }
+    updateSuccessorRules();
 }
 
-bool GridGraph::isOutOfBounds(Tile tile)
+bool GridGraph::isOutOfBounds(Tile tile) const
 {
     return tile.x < left || tile.x >= right
             || tile.y < top || tile.y >= bottom;
 }
 
-bool GridGraph::isWall(Tile tile)
+bool GridGraph::isWall(Tile tile) const
 {
-    return costs[tile] < 0;
+    if (isOutOfBounds(tile))
+    {
+        return false;
+    }
+    int column = tile.x - left;
+    uint64_t word = walls[size_t(tile.y - top) * wordsPerRow + column / 64];
+    return (word >> (column % 64)) & 1;
 }
 
 std::vector<Tile> GridGraph::neighbors(Tile tile)
 {
     std::vector<Tile> result;
-    std::vector<Tile> dirs{GridGraph::DIRS};
-    // If diagonal is allowed, add diagonal directions
-    if (diagonalAllowed)
-    {
-        dirs.insert(dirs.end(),
-                    GridGraph::DIAGONAL_DIRS.begin(),
-                    GridGraph::DIAGONAL_DIRS.end());
-    }
-    // For each possible direction, check for adjacent walkable tiles
-    for (auto dir : dirs)
-    {
-        Tile adjacentTile{tile.x + dir.x, tile.y + dir.y};
-        if (!isOutOfBounds(adjacentTile) && !isWall(adjacentTile)
-                && (!diagonalAllowed || cornerMovementAllowed
-                    || !isCornerMovement(tile, dir)))
-        {
-            // Walkable tile, add to neighbors vector
-            result.push_back(adjacentTile);
-        }
-    }
+    // Every walkable direction is already encoded in the tile's successor mask
+    forEachNeighbor(tile, [&result](Tile next, double) {
+        result.push_back(next);
+    });
     return result;
 }
 
@@ -66,36 +121,205 @@ std::vector<Tile> GridGraph::adjacentTiles(Tile tile)
     return result;
 }
 
-double GridGraph::getCost(Tile tile, Tile previous)
+double GridGraph::getCost(Tile tile, Tile previous) const
+{
+    // Tiles outside the grid behave as floor tiles
+    if (isOutOfBounds(tile))
+        return 1;
+    return costAt(index(tile));
+}
+
+void GridGraph::setCost(Tile tile, double cost)
 {
-    // If cost is 0 (the map's default), use 1 as default
-    double cost = costs[tile];
+    if (isOutOfBounds(tile))
+    {
+        throw std::out_of_range("Tile out of bounds");
+    }
+    // If cost is 0, use 1 as default
     if (approxEqual(cost, 0))
         cost = 1;
-    return cost;
+    bool wall = cost < 0;
+
+    // Keep the cost histogram of the walkable tiles up to date
+    double oldCost = costAt(index(tile));
+    if (oldCost >= 0)
+    {
+        auto entry = costCounts.find(oldCost);
+        if (--entry->second == 0)
+            costCounts.erase(entry);
+    }
+    if (!wall)
+        ++costCounts[cost];
+
+    if (wall != isWall(tile))
+    {
+        setWallBit(tile, wall);
+        updateNeighborMasks(tile, wall);
+    }
+
+    storeCost(tile, cost);
+    if (oldCost != cost)
+    {
+        for (GridGraphObserver *observer : observers)
+        {
+            observer->tileChanged(tile, oldCost, cost);
+        }
+    }
 }
 
-void GridGraph::setCost(Tile tile, double cost)
+void GridGraph::storeCost(Tile tile, double cost)
+{
+    if (storage == COMPACT)
+    {
+        // Look for the cost in the palette, adding it if there's still room
+        size_t entry = std::find(palette.begin(), palette.end(), cost) - palette.begin();
+        if (entry == palette.size() && palette.size() < MAX_PALETTE_SIZE)
+        {
+            palette.push_back(cost);
+        }
+        if (entry < palette.size())
+        {
+            terrain[index(tile)] = uint8_t(entry);
+            return;
+        }
+        // Too many distinct costs for the palette, fall back to dense storage
+        convertToDense();
+    }
+    costs[index(tile)] = cost;
+}
+
+void GridGraph::setWallBit(Tile tile, bool wall)
 {
-    // TODO: Throw error if tile is out of bounds
-    costs[tile] = cost;
+    int column = tile.x - left;
+    uint64_t &word = walls[size_t(tile.y - top) * wordsPerRow + column / 64];
+    uint64_t mask = uint64_t(1) << (column % 64);
+    if (wall)
+        word |= mask;
+    else
+        word &= ~mask;
+}
+
+void GridGraph::updateNeighborMasks(Tile tile, bool wall)
+{
+    for (int i = 0; i < 8; ++i)
+    {
+        Tile neighbor{tile.x - MASK_DIRS[i].x, tile.y - MASK_DIRS[i].y};
+        if (isOutOfBounds(neighbor))
+        {
+            continue;
+        }
+        // The neighbor reaches this tile by moving in direction i
+        uint8_t &mask = masks[index(neighbor)];
+        if (wall)
+            mask &= ~(1 << i);
+        else
+            mask |= 1 << i;
+    }
+}
+
+void GridGraph::updateSuccessorRules()
+{
+    if (!diagonalAllowed)
+        successorRules = SUCCESSOR_RULES.straight;
+    else if (cornerMovementAllowed)
+        successorRules = SUCCESSOR_RULES.cornerMovement;
+    else
+        successorRules = SUCCESSOR_RULES.diagonal;
+}
+
+void GridGraph::convertToDense()
+{
+    costs.resize(terrain.size());
+    for (size_t i = 0; i < terrain.size(); ++i)
+    {
+        costs[i] = palette[terrain[i]];
+    }
+    // Release the compact storage
+    std::vector<uint8_t>().swap(terrain);
+    std::vector<double>().swap(palette);
+    storage = DENSE;
+}
+
+bool GridGraph::isDiagonalAllowed() const
+{
+    return diagonalAllowed;
+}
+
+bool GridGraph::isCornerMovementAllowed() const
+{
+    return cornerMovementAllowed;
+}
+
+bool GridGraph::hasUniformCosts() const
+{
+    return costCounts.size() <= 1;
+}
+
+double GridGraph::getDiagonalCostFactor() const
+{
+    return diagonalCostFactor;
+}
+
+bool GridGraph::hasIntegralCosts() const
+{
+    if (diagonalAllowed && diagonalCostFactor != 1)
+        return false;
+    for (const auto &entry : costCounts)
+    {
+        if (std::floor(entry.first) != entry.first)
+            return false;
+    }
+    return true;
+}
+
+double GridGraph::getMaxCost() const
+{
+    return costCounts.empty() ? 0 : costCounts.rbegin()->first;
+}
+
+double GridGraph::getMinCost() const
+{
+    return costCounts.empty() ? 0 : costCounts.begin()->first;
 }
 
 void GridGraph::setDiagonalAllowed(bool allowed)
 {
     diagonalAllowed = allowed;
+    updateSuccessorRules();
+    for (GridGraphObserver *observer : observers)
+    {
+        observer->movementChanged();
+    }
 }
 
 void GridGraph::setCornerMovementAllowed(bool allowed)
 {
     cornerMovementAllowed = allowed;
+    updateSuccessorRules();
+    for (GridGraphObserver *observer : observers)
+    {
+        observer->movementChanged();
+    }
 }
 
-bool GridGraph::isCornerMovement(Tile tile, Tile direction)
+void GridGraph::setDiagonalCostFactor(double factor)
 {
-    Tile corner1{tile.x + direction.x, tile.y};
-    Tile corner2{tile.x, tile.y + direction.y};
-    return isWall(corner1) || isWall(corner2);
+    diagonalCostFactor = factor;
+    for (GridGraphObserver *observer : observers)
+    {
+        observer->movementChanged();
+    }
+}
+
+void GridGraph::addObserver(GridGraphObserver *observer) const
+{
+    observers.push_back(observer);
+}
+
+void GridGraph::removeObserver(GridGraphObserver *observer) const
+{
+    observers.erase(std::remove(observers.begin(), observers.end(), observer),
+                    observers.end());
 }
 
 std::vector<Tile> GridGraph::DIRS = {
@@ -106,11 +330,35 @@ std::vector<Tile> GridGraph::DIAGONAL_DIRS = {
     Tile{1, 1}, Tile{-1, -1}, Tile{-1, 1}, Tile{1, -1}
 };
 
+const Tile GridGraph::MASK_DIRS[8] = {
+    Tile{1, 0}, Tile{0, -1}, Tile{-1, 0}, Tile{0, 1},
+    Tile{1, 1}, Tile{-1, -1}, Tile{-1, 1}, Tile{1, -1}
+};
+
+GridGraph::eStorage GridGraph::getStorage() const
+{
+    return storage;
+}
+
 std::pair<int, int> GridGraph::getTopLeft() const
 {
     return std::make_pair(left, top);
 }
 
+size_t GridGraph::getMemoryUsage() const
+{
+    // Every entry of the map of cost counts is a node of a tree, with three pointers and
+    // a color
+    size_t costCountsBytes = costCounts.size() * (sizeof(std::pair<const double, size_t>)
+                                                  + 4 * sizeof(void*));
+    return costs.capacity() * sizeof(double)
+            + terrain.capacity() * sizeof(uint8_t)
+            + palette.capacity() * sizeof(double)
+            + walls.capacity() * sizeof(uint64_t)
+            + masks.capacity() * sizeof(uint8_t)
+            + costCountsBytes;
+}
+
 int GridGraph::getWidth() const
 {
     return right - left;
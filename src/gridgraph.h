@@ -1,6 +1,9 @@
 #ifndef GRIDGRAPH_H
 #define GRIDGRAPH_H
 
+#include <cstddef>
+#include <cstdint>
+#include <map>
 #include "graph.hpp"
 
 typedef struct Tile {
@@ -23,6 +26,29 @@ typedef struct Tile {
     }
 } Tile;
 
+/**
+ * @brief Interface for the classes that keep data derived from a GridGraph, such as
+ * precomputed tables, and need to know when the grid changes to keep it up to date.
+ */
+class GridGraphObserver
+{
+public:
+    virtual ~GridGraphObserver() {}
+
+    /**
+     * @brief Called after the cost of a tile has changed.
+     *
+     * A negative cost means that the tile is a wall.
+     */
+    virtual void tileChanged(Tile tile, double oldCost, double newCost) = 0;
+
+    /**
+     * @brief Called after the diagonal or corner movement settings, or the cost of the
+     * diagonal moves, have changed.
+     */
+    virtual void movementChanged() = 0;
+};
+
 /**
  * @brief A GridGraph is a graph representation of a tiled grid.
  *
@@ -34,6 +60,20 @@ class GridGraph : public Graph<Tile>
 public:
     static std::vector<Tile> DIRS;
     static std::vector<Tile> DIAGONAL_DIRS;
+    // Direction of each bit in a neighbor mask: DIRS followed by DIAGONAL_DIRS
+    static const Tile MASK_DIRS[8];
+
+    /**
+     * @brief How the tile costs are stored.
+     *
+     * DENSE keeps one double per tile. COMPACT keeps a one byte index per tile into a
+     * small palette of distinct costs, which is enough for maps painted with a handful of
+     * terrain types. A compact grid switches to dense storage by itself as soon as it is
+     * given more distinct costs than the palette can hold.
+     */
+    enum eStorage {DENSE, COMPACT};
+
+    static const size_t MAX_PALETTE_SIZE = 256;
 
 public:
     using Graph = Graph<Tile>;
@@ -49,20 +89,23 @@ public:
      * @param top Minimum y value for a tile in the grid.
      * @param width Width of the grid, in tiles.
      * @param height Height of the grid, in tiles.
+     * @param storage Storage mode used for the tile costs.
      */
-    GridGraph(int left, int top, int width, int height);
+    GridGraph(int left, int top, int width, int height, eStorage storage = DENSE);
 
     /**
      * @return true if the tile is outside of the bounds of the grid, false
      * otherwise.
      */
-    bool isOutOfBounds(Tile tile);
+    bool isOutOfBounds(Tile tile) const;
 
     /**
      * @return true if the tile is a wall in the grid, which is represented by
      * having a negative weight.
+     *
+     * Tiles outside of the grid's bounds are not considered walls.
      */
-    bool isWall(Tile tile);
+    bool isWall(Tile tile) const;
 
     /**
      * @return A list of all adjacent tiles to the given tile, if they're walkable,
@@ -70,6 +113,31 @@ public:
      */
     std::vector<Tile> neighbors(Tile tile);
 
+    /**
+     * @brief Calls visit(neighbor, cost) for every tile that neighbors() would return,
+     * in the same order, where cost is the cost of moving to that neighbor.
+     *
+     * Doesn't allocate any memory, so it's preferred over neighbors() in the search loops.
+     */
+    template <typename Visitor>
+    void forEachNeighbor(Tile tile, Visitor visit) const
+    {
+        if (isOutOfBounds(tile))
+        {
+            return;
+        }
+        uint8_t mask = successors(tile);
+        for (int i = 0; mask != 0; ++i, mask >>= 1)
+        {
+            if (mask & 1)
+            {
+                Tile next{tile.x + MASK_DIRS[i].x, tile.y + MASK_DIRS[i].y};
+                double cost = costAt(index(next));
+                visit(next, i < 4 ? cost : cost * diagonalCostFactor);
+            }
+        }
+    }
+
     /**
      * @brief Similar to the neighbors method, but also returns wall tiles, and ignores
      * diagonal movement.
@@ -80,10 +148,24 @@ public:
      * @return The cost or weight of a tile in the grid, which is the cost of moving
      * to that tile from an adjacent one.
      */
-    double getCost(Tile tile, Tile previous=Tile{0, 0});
+    double getCost(Tile tile, Tile previous=Tile{0, 0}) const;
+
+    /**
+     * @return The cost of moving between two adjacent tiles, which is the cost of the
+     * tile moved to, multiplied by the diagonal cost factor for diagonal moves.
+     */
+    double getMoveCost(Tile from, Tile to) const
+    {
+        double cost = getCost(to);
+        return from.x != to.x && from.y != to.y ? cost * diagonalCostFactor : cost;
+    }
 
     /**
      * @brief Sets the cost of a given tile in the grid.
+     *
+     * A cost of 0 is treated as the default floor cost of 1.
+     *
+     * @throws std::out_of_range if the tile is outside of the grid's bounds.
      */
     void setCost(Tile tile, double cost);
 
@@ -97,6 +179,67 @@ public:
      */
     void setCornerMovementAllowed(bool allowed);
 
+    /**
+     * @brief Sets the factor by which the cost of diagonal moves is multiplied, which is 1
+     * by default. A factor of sqrt(2) gives the octile costs used by most grid benchmarks.
+     */
+    void setDiagonalCostFactor(double factor);
+
+    /**
+     * @return true if diagonal tile movement is allowed.
+     */
+    bool isDiagonalAllowed() const;
+
+    /**
+     * @return true if corner movement is allowed.
+     */
+    bool isCornerMovementAllowed() const;
+
+    /**
+     * @return The factor by which the cost of diagonal moves is multiplied.
+     */
+    double getDiagonalCostFactor() const;
+
+    /**
+     * @return true if every walkable tile has the same cost.
+     */
+    bool hasUniformCosts() const;
+
+    /**
+     * @return true if every move has an integral cost no higher than getMaxCost(), so
+     * every path cost is an integer too, which needs integral tile costs and diagonal
+     * moves to cost the same as the others.
+     */
+    bool hasIntegralCosts() const;
+
+    /**
+     * @return The highest cost among the walkable tiles, or 0 if there are none.
+     */
+    double getMaxCost() const;
+
+    /**
+     * @return The lowest cost among the walkable tiles, or 0 if there are none.
+     */
+    double getMinCost() const;
+
+    /**
+     * @brief Registers an observer to be notified of every change to the grid.
+     *
+     * Observers don't modify the grid, so they can be registered on a constant one. The
+     * observer must be removed before it is destroyed.
+     */
+    void addObserver(GridGraphObserver *observer) const;
+
+    /**
+     * @brief Stops notifying an observer of the changes to the grid.
+     */
+    void removeObserver(GridGraphObserver *observer) const;
+
+    /**
+     * @return The storage mode currently in use for the tile costs.
+     */
+    eStorage getStorage() const;
+
     /**
      * @brief Return the tile coordinates of the top-left tile.
      */
@@ -112,21 +255,110 @@ public:
      */
     int getHeight() const;
 
+    /**
+     * @return The number of tiles in the graph.
+     */
+    int getNodeCount() const
+    {
+        return (right - left) * (bottom - top);
+    }
+
+    /**
+     * @return The memory used by the tiles, the wall bitmap and the successor masks, in
+     * bytes.
+     */
+    size_t getMemoryUsage() const;
+
+    /**
+     * @return A number between 0 and getNodeCount() - 1 identifying an in-bounds tile.
+     */
+    int getNodeIndex(Tile tile) const
+    {
+        return index(tile);
+    }
+
+    /**
+     * @return The tile identified by the given index, as returned by getNodeIndex.
+     */
+    Tile getNode(int nodeIndex) const
+    {
+        int width = right - left;
+        return Tile{left + nodeIndex % width, top + nodeIndex / width};
+    }
+
 private:
     /**
-     * @brief Tests whether moving in the given direction from a tile is a corner movement.
-     *
-     * A corner movement is defined by moving around a corner tile on one of the sides in a
-     * diagonal movement. For example, if moving NE, it would be considered a corner
-     * movement if there were a wall tile on the N or E directions.
+     * @return A bitmask with a bit set for each direction in MASK_DIRS that can be taken
+     * from the given in-bounds tile, following the diagonal and corner movement settings.
+     */
+    uint8_t successors(Tile tile) const
+    {
+        return successorRules[masks[index(tile)]];
+    }
+
+    /**
+     * @brief Selects the table which turns neighbor masks into successor masks for the
+     * current diagonal and corner movement settings.
+     */
+    void updateSuccessorRules();
+
+    /**
+     * @brief Updates the neighbor masks of the tiles around a tile which has just become
+     * a wall or stopped being one.
+     */
+    void updateNeighborMasks(Tile tile, bool wall);
+
+    /**
+     * @return The position of an in-bounds tile in the row-major cost array.
+     */
+    int index(Tile tile) const
+    {
+        return (tile.y - top) * (right - left) + (tile.x - left);
+    }
+
+    /**
+     * @return The cost of the tile at the given position of the cost array.
+     */
+    double costAt(int i) const
+    {
+        return storage == DENSE ? costs[i] : palette[terrain[i]];
+    }
+
+    /**
+     * @brief Updates the walkability bit of an in-bounds tile.
+     */
+    void setWallBit(Tile tile, bool wall);
+
+    /**
+     * @brief Stores the cost of an in-bounds tile, switching to dense storage if needed.
+     */
+    void storeCost(Tile tile, double cost);
+
+    /**
+     * @brief Moves every cost from the palette to the dense cost array.
      */
-    bool isCornerMovement(Tile tile, Tile direction);
+    void convertToDense();
 
 private:
     int left, top, right, bottom;  // Bounds for x and y coordinates
-    // TODO: Use array for improved efficiency
-    std::map<Tile, double> costs;
+    eStorage storage;
+    // Dense storage, row-major, starting at the top-left tile
+    std::vector<double> costs;
+    // Compact storage, an index into the palette for each tile
+    std::vector<uint8_t> terrain;
+    std::vector<double> palette;
+    // Number of walkable tiles with each distinct cost
+    std::map<double, size_t> costCounts;
+    // One bit per tile, set for walls, with each row starting on a new word
+    std::vector<uint64_t> walls;
+    int wordsPerRow;
+    // For each tile, a bit per direction in MASK_DIRS set if the tile reached by moving
+    // in that direction is inside the grid and is not a wall
+    std::vector<uint8_t> masks;
+    const uint8_t *successorRules;
     bool diagonalAllowed, cornerMovementAllowed;
+    double diagonalCostFactor;
+    mutable std::vector<GridGraphObserver*> observers;
 };
 
 #endif // GRIDGRAPH_H
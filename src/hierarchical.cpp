@@ -0,0 +1,594 @@
+#include "hierarchical.h"
+#include <algorithm>
+#include <stdexcept>
+
+ClusterGraph::ClusterGraph(const GridGraph *graph, int maxSize)
+    : Graph<Tile>(),
+      graph(graph),
+      maxSize(maxSize),
+      left(0),
+      top(0),
+      width(0),
+      height(0),
+      reversed(false)
+{
+}
+
+void ClusterGraph::setBounds(int left, int top, int width, int height, bool reversed)
+{
+    this->left = left;
+    this->top = top;
+    this->width = width;
+    this->height = height;
+    this->reversed = reversed;
+}
+
+Tile ClusterGraph::getOutsideTile() const
+{
+    return Tile{left - 1, top - 1};
+}
+
+std::vector<Tile> ClusterGraph::neighbors(Tile tile)
+{
+    std::vector<Tile> result;
+    forEachNeighbor(tile, [&result](Tile next, double) {
+        result.push_back(next);
+    });
+    return result;
+}
+
+std::vector<int> AbstractGraph::neighbors(int node)
+{
+    std::vector<int> result;
+    forEachNeighbor(node, [&result](int next, double) {
+        result.push_back(next);
+    });
+    return result;
+}
+
+int AbstractGraph::addNode(Tile tile)
+{
+    if (freeNodes.empty())
+    {
+        reserveNodes(1);
+    }
+    int node = freeNodes.back();
+    freeNodes.pop_back();
+    tiles[node] = tile;
+    return node;
+}
+
+void AbstractGraph::removeNode(int node)
+{
+    intraEdges[node].clear();
+    interEdges[node].clear();
+    freeNodes.push_back(node);
+}
+
+void AbstractGraph::reserveNodes(int count)
+{
+    while (int(freeNodes.size()) < count)
+    {
+        freeNodes.push_back(int(tiles.size()));
+        tiles.push_back(Tile{0, 0});
+        intraEdges.emplace_back();
+        interEdges.emplace_back();
+    }
+}
+
+HierarchicalSearch::HierarchicalSearch(const GridGraph *graph, int clusterSize)
+    : graph(graph),
+      clusterSize(clusterSize),
+      abstractWorkspace(nullptr),
+      clusterGraph(graph, clusterSize),
+      clusterWorkspace(&clusterGraph),
+      startNode(0),
+      goalNode(0),
+      cost(-1)
+{
+    if (clusterSize <= 0)
+    {
+        throw std::invalid_argument("Cluster size must be positive");
+    }
+    std::pair<int, int> topLeft = graph->getTopLeft();
+    left = topLeft.first;
+    top = topLeft.second;
+    width = graph->getWidth();
+    height = graph->getHeight();
+    clustersX = (width + clusterSize - 1) / clusterSize;
+    clustersY = (height + clusterSize - 1) / clusterSize;
+    int clusterCount = clustersX * clustersY;
+    for (std::vector<std::vector<Transition>> &kind : borders)
+    {
+        kind.resize(clusterCount);
+    }
+    clusterNodes.resize(clusterCount);
+    dirty.assign(clusterCount, false);
+
+    // Build everything up front
+    movementChanged();
+    rebuildDirtyClusters();
+    graph->addObserver(this);
+}
+
+HierarchicalSearch::~HierarchicalSearch()
+{
+    graph->removeObserver(this);
+    delete abstractWorkspace;
+}
+
+int HierarchicalSearch::getClusterSize() const
+{
+    return clusterSize;
+}
+
+int HierarchicalSearch::getEntranceCount()
+{
+    rebuildDirtyClusters();
+    int count = 0;
+    for (const std::vector<int> &nodes : clusterNodes)
+    {
+        count += int(nodes.size());
+    }
+    return count;
+}
+
+double HierarchicalSearch::getCost() const
+{
+    return cost;
+}
+
+const std::vector<Tile> &HierarchicalSearch::getAbstractPath() const
+{
+    return abstractPath;
+}
+
+std::vector<Tile> HierarchicalSearch::refineSegment(size_t segment)
+{
+    Tile from = abstractPath[segment];
+    Tile to = abstractPath[segment + 1];
+    int cluster = clusterOf(from);
+    // Segments between clusters are a single move across the border
+    if (cluster != clusterOf(to))
+    {
+        return std::vector<Tile>(1, to);
+    }
+    viewCluster(cluster);
+    dijkstra(&clusterGraph, from, to, clusterWorkspace, clusterQueue);
+    std::vector<Tile> path = reconstructPath(from, to, clusterWorkspace);
+    path.erase(path.begin());
+    return path;
+}
+
+std::vector<Tile> HierarchicalSearch::getPath()
+{
+    std::vector<Tile> path(1, abstractPath.front());
+    for (size_t i = 0; i + 1 < abstractPath.size(); ++i)
+    {
+        std::vector<Tile> segment = refineSegment(i);
+        path.insert(path.end(), segment.begin(), segment.end());
+    }
+    return path;
+}
+
+void HierarchicalSearch::tileChanged(Tile tile, double, double)
+{
+    markDirty(clusterOf(tile));
+}
+
+void HierarchicalSearch::movementChanged()
+{
+    for (int cluster = 0; cluster < clustersX * clustersY; ++cluster)
+    {
+        markDirty(cluster);
+    }
+}
+
+int HierarchicalSearch::clusterOf(Tile tile) const
+{
+    return (tile.y - top) / clusterSize * clustersX + (tile.x - left) / clusterSize;
+}
+
+void HierarchicalSearch::viewCluster(int cluster, bool reversed)
+{
+    int clusterLeft = left + cluster % clustersX * clusterSize;
+    int clusterTop = top + cluster / clustersX * clusterSize;
+    clusterGraph.setBounds(clusterLeft, clusterTop,
+                           std::min(clusterSize, left + width - clusterLeft),
+                           std::min(clusterSize, top + height - clusterTop),
+                           reversed);
+}
+
+template <typename Visitor>
+void HierarchicalSearch::forEachBorder(int cluster, Visitor visit) const
+{
+    int x = cluster % clustersX, y = cluster / clustersX;
+    bool hasRight = x + 1 < clustersX, hasLeft = x > 0;
+    bool hasBelow = y + 1 < clustersY, hasAbove = y > 0;
+    if (hasRight)
+        visit(RIGHT, cluster, true, cluster + 1);
+    if (hasLeft)
+        visit(RIGHT, cluster - 1, false, cluster - 1);
+    if (hasBelow)
+        visit(BELOW, cluster, true, cluster + clustersX);
+    if (hasAbove)
+        visit(BELOW, cluster - clustersX, false, cluster - clustersX);
+    if (hasBelow && hasRight)
+        visit(BELOW_RIGHT, cluster, true, cluster + clustersX + 1);
+    if (hasAbove && hasLeft)
+        visit(BELOW_RIGHT, cluster - clustersX - 1, false, cluster - clustersX - 1);
+    if (hasBelow && hasLeft)
+        visit(BELOW_LEFT, cluster, true, cluster + clustersX - 1);
+    if (hasAbove && hasRight)
+        visit(BELOW_LEFT, cluster - clustersX + 1, false, cluster - clustersX + 1);
+}
+
+bool HierarchicalSearch::canMove(Tile from, Tile to) const
+{
+    if (graph->isWall(from))
+    {
+        return false;
+    }
+    bool found = false;
+    graph->forEachNeighbor(from, [&](Tile next, double) {
+        found = found || next == to;
+    });
+    return found;
+}
+
+std::vector<HierarchicalSearch::Transition> HierarchicalSearch::findTransitions(
+        eBorder kind, int border) const
+{
+    int clusterLeft = left + border % clustersX * clusterSize;
+    int clusterTop = top + border / clustersX * clusterSize;
+    int clusterRight = std::min(clusterLeft + clusterSize, left + width) - 1;
+    int clusterBottom = std::min(clusterTop + clusterSize, top + height) - 1;
+    std::vector<Transition> transitions;
+
+    // Corners can only be crossed with a diagonal move, which is needed when the tiles
+    // on both sides of it are walls
+    if (kind == BELOW_RIGHT || kind == BELOW_LEFT)
+    {
+        Tile from = kind == BELOW_RIGHT ? Tile{clusterRight, clusterBottom}
+                                        : Tile{clusterLeft, clusterBottom};
+        Tile to{kind == BELOW_RIGHT ? from.x + 1 : from.x - 1, from.y + 1};
+        if (graph->isWall(Tile{to.x, from.y}) && graph->isWall(Tile{from.x, to.y})
+                && canMove(from, to))
+        {
+            transitions.push_back(Transition{from, to});
+        }
+        return transitions;
+    }
+
+    // Walk along the last line of the top or left cluster
+    bool vertical = kind == RIGHT;
+    Tile first = vertical ? Tile{clusterRight, clusterTop} : Tile{clusterLeft, clusterBottom};
+    Tile step = vertical ? Tile{0, 1} : Tile{1, 0};
+    Tile across = vertical ? Tile{1, 0} : Tile{0, 1};
+    int length = vertical ? clusterBottom - clusterTop + 1 : clusterRight - clusterLeft + 1;
+    auto tileAt = [&](int i, bool otherSide) {
+        return Tile{first.x + i * step.x + (otherSide ? across.x : 0),
+                    first.y + i * step.y + (otherSide ? across.y : 0)};
+    };
+    auto isOpen = [&](int i) {
+        return i < length && !graph->isWall(tileAt(i, false)) && !graph->isWall(tileAt(i, true));
+    };
+
+    int runStart = -1;
+    for (int i = 0; i <= length; ++i)
+    {
+        bool open = isOpen(i);
+        if (open && runStart < 0)
+        {
+            runStart = i;
+        }
+        if (open || runStart < 0)
+        {
+            continue;
+        }
+        // A walkable stretch of the border ended before i
+        int runLength = i - runStart;
+        std::vector<int> positions;
+        if (runLength < LONG_ENTRANCE)
+        {
+            positions.push_back(runStart + runLength / 2);
+        }
+        else
+        {
+            positions.push_back(runStart);
+            positions.push_back(i - 1);
+        }
+        for (int position : positions)
+        {
+            transitions.push_back(Transition{tileAt(position, false), tileAt(position, true)});
+        }
+        runStart = -1;
+    }
+
+    // Diagonal moves between two closed positions of the border
+    for (int i = 0; i + 1 < length; ++i)
+    {
+        if (isOpen(i) || isOpen(i + 1))
+        {
+            continue;
+        }
+        for (int j : {i, i + 1})
+        {
+            Tile from = tileAt(j, false), to = tileAt(j == i ? i + 1 : i, true);
+            if (canMove(from, to))
+            {
+                transitions.push_back(Transition{from, to});
+            }
+        }
+    }
+    return transitions;
+}
+
+void HierarchicalSearch::markDirty(int cluster)
+{
+    if (!dirty[cluster])
+    {
+        dirty[cluster] = true;
+        dirtyClusters.push_back(cluster);
+    }
+}
+
+void HierarchicalSearch::rebuildDirtyClusters()
+{
+    if (dirtyClusters.empty())
+    {
+        return;
+    }
+    int clusterCount = clustersX * clustersY;
+    std::vector<bool> affected(clusterCount, false);
+    std::vector<int> affectedClusters;
+    auto markAffected = [&](int cluster) {
+        if (!affected[cluster])
+        {
+            affected[cluster] = true;
+            affectedClusters.push_back(cluster);
+        }
+    };
+
+    // The clusters on the other side of a border are only affected if its entrances
+    // changed
+    auto refreshBorder = [&](eBorder kind, int border, int other) {
+        std::vector<Transition> found = findTransitions(kind, border);
+        if (found != borders[kind][border])
+        {
+            borders[kind][border].swap(found);
+            markAffected(border);
+            markAffected(other);
+        }
+    };
+    for (int cluster : dirtyClusters)
+    {
+        markAffected(cluster);
+        forEachBorder(cluster, [&](eBorder kind, int border, bool, int other) {
+            refreshBorder(kind, border, border == cluster ? other : cluster);
+        });
+        // Crossing a corner also depends on the two clusters on its sides
+        int x = cluster % clustersX, y = cluster / clustersX;
+        if (x > 0 && y + 1 < clustersY)
+            refreshBorder(BELOW_RIGHT, cluster - 1, cluster + clustersX);
+        if (x + 1 < clustersX && y > 0)
+            refreshBorder(BELOW_RIGHT, cluster - clustersX, cluster + 1);
+        if (x + 1 < clustersX && y + 1 < clustersY)
+            refreshBorder(BELOW_LEFT, cluster + 1, cluster + clustersX);
+        if (x > 0 && y > 0)
+            refreshBorder(BELOW_LEFT, cluster - clustersX, cluster - 1);
+        dirty[cluster] = false;
+    }
+    dirtyClusters.clear();
+
+    for (int cluster : affectedClusters)
+    {
+        rebuildNodes(cluster);
+    }
+    for (int cluster : affectedClusters)
+    {
+        computeIntraEdges(cluster);
+    }
+    // Edges across borders go out of the affected clusters and into them from their
+    // neighbors
+    std::vector<bool> linked(clusterCount, false);
+    for (int cluster : affectedClusters)
+    {
+        if (!linked[cluster])
+        {
+            linked[cluster] = true;
+            computeInterEdges(cluster);
+        }
+        forEachBorder(cluster, [&](eBorder, int, bool, int other) {
+            if (!linked[other])
+            {
+                linked[other] = true;
+                computeInterEdges(other);
+            }
+        });
+    }
+
+    // The start and goal tiles are added to the graph in every search, so keep room
+    // for them to avoid changing the node count
+    abstractGraph.reserveNodes(2);
+    if (!abstractWorkspace || abstractWorkspace->getNodeCount() != abstractGraph.getNodeCount())
+    {
+        delete abstractWorkspace;
+        abstractWorkspace = new SearchWorkspace<AbstractGraph>(&abstractGraph);
+    }
+}
+
+void HierarchicalSearch::rebuildNodes(int cluster)
+{
+    std::vector<Tile> tiles;
+    forEachBorder(cluster, [&](eBorder kind, int border, bool first, int) {
+        for (const Transition &transition : borders[kind][border])
+        {
+            tiles.push_back(first ? transition.first : transition.second);
+        }
+    });
+    std::sort(tiles.begin(), tiles.end());
+    tiles.erase(std::unique(tiles.begin(), tiles.end()), tiles.end());
+
+    // Drop the entrances that are gone, and add the new ones
+    for (int node : clusterNodes[cluster])
+    {
+        Tile tile = abstractGraph.getTile(node);
+        if (!std::binary_search(tiles.begin(), tiles.end(), tile))
+        {
+            entranceNodes.erase(graph->getNodeIndex(tile));
+            abstractGraph.removeNode(node);
+        }
+    }
+    std::vector<int> &nodes = clusterNodes[cluster];
+    nodes.clear();
+    for (const Tile &tile : tiles)
+    {
+        auto entry = entranceNodes.find(graph->getNodeIndex(tile));
+        if (entry == entranceNodes.end())
+        {
+            entry = entranceNodes.emplace(graph->getNodeIndex(tile),
+                                          abstractGraph.addNode(tile)).first;
+        }
+        nodes.push_back(entry->second);
+    }
+}
+
+void HierarchicalSearch::computeIntraEdges(int cluster)
+{
+    viewCluster(cluster);
+    const std::vector<int> &nodes = clusterNodes[cluster];
+    for (int node : nodes)
+    {
+        std::vector<AbstractGraph::Edge> &edges = abstractGraph.getIntraEdges(node);
+        edges.clear();
+        // A single search from each entrance finds the costs to all the others
+        dijkstra(&clusterGraph, abstractGraph.getTile(node), clusterGraph.getOutsideTile(),
+                 clusterWorkspace, clusterQueue);
+        for (int other : nodes)
+        {
+            Tile tile = abstractGraph.getTile(other);
+            if (other != node && clusterWorkspace.isVisited(tile))
+            {
+                edges.push_back(AbstractGraph::Edge{other, clusterWorkspace.getCost(tile)});
+            }
+        }
+    }
+}
+
+void HierarchicalSearch::computeInterEdges(int cluster)
+{
+    for (int node : clusterNodes[cluster])
+    {
+        std::vector<AbstractGraph::Edge> &edges = abstractGraph.getInterEdges(node);
+        edges.clear();
+        Tile tile = abstractGraph.getTile(node);
+        forEachBorder(cluster, [&](eBorder kind, int border, bool first, int) {
+            for (const Transition &transition : borders[kind][border])
+            {
+                if ((first ? transition.first : transition.second) != tile)
+                {
+                    continue;
+                }
+                Tile other = first ? transition.second : transition.first;
+                edges.push_back(AbstractGraph::Edge{
+                                    entranceNodes[graph->getNodeIndex(other)],
+                                    graph->getMoveCost(tile, other)});
+            }
+        });
+    }
+}
+
+bool HierarchicalSearch::prepareSearch(Tile start, Tile goal)
+{
+    rebuildDirtyClusters();
+    abstractPath.clear();
+    cost = -1;
+    temporaryNodes.clear();
+    goalEdgeNodes.clear();
+    if (graph->isOutOfBounds(start) || graph->isOutOfBounds(goal)
+            || graph->isWall(start) || graph->isWall(goal))
+    {
+        return false;
+    }
+
+    // Tiles which aren't entrances are linked to the entrances of their cluster for this
+    // search only. The costs to the goal are found searching backwards from it.
+    auto entry = entranceNodes.find(graph->getNodeIndex(goal));
+    bool goalAdded = entry == entranceNodes.end();
+    if (goalAdded)
+    {
+        goalNode = abstractGraph.addNode(goal);
+        temporaryNodes.push_back(goalNode);
+        viewCluster(clusterOf(goal), true);
+        dijkstra(&clusterGraph, goal, clusterGraph.getOutsideTile(), clusterWorkspace,
+                 clusterQueue);
+        for (int node : clusterNodes[clusterOf(goal)])
+        {
+            Tile tile = abstractGraph.getTile(node);
+            if (clusterWorkspace.isVisited(tile))
+            {
+                abstractGraph.getIntraEdges(node).push_back(
+                            AbstractGraph::Edge{goalNode, clusterWorkspace.getCost(tile)});
+                goalEdgeNodes.push_back(node);
+            }
+        }
+    }
+    else
+    {
+        goalNode = entry->second;
+    }
+
+    entry = entranceNodes.find(graph->getNodeIndex(start));
+    if (start == goal)
+    {
+        startNode = goalNode;
+    }
+    else if (entry == entranceNodes.end())
+    {
+        startNode = abstractGraph.addNode(start);
+        temporaryNodes.push_back(startNode);
+        viewCluster(clusterOf(start));
+        dijkstra(&clusterGraph, start, clusterGraph.getOutsideTile(), clusterWorkspace,
+                 clusterQueue);
+        std::vector<AbstractGraph::Edge> &edges = abstractGraph.getIntraEdges(startNode);
+        for (int node : clusterNodes[clusterOf(start)])
+        {
+            Tile tile = abstractGraph.getTile(node);
+            if (clusterWorkspace.isVisited(tile))
+            {
+                edges.push_back(AbstractGraph::Edge{node, clusterWorkspace.getCost(tile)});
+            }
+        }
+        // A goal in the same cluster may be reached without going through an entrance
+        if (goalAdded && clusterGraph.contains(goal) && clusterWorkspace.isVisited(goal))
+        {
+            edges.push_back(AbstractGraph::Edge{goalNode, clusterWorkspace.getCost(goal)});
+        }
+    }
+    else
+    {
+        startNode = entry->second;
+    }
+    return true;
+}
+
+void HierarchicalSearch::finishSearch()
+{
+    if (abstractWorkspace->isVisited(goalNode))
+    {
+        cost = abstractWorkspace->getCost(goalNode);
+        for (int node : reconstructPath(startNode, goalNode, *abstractWorkspace))
+        {
+            abstractPath.push_back(abstractGraph.getTile(node));
+        }
+    }
+    for (int node : goalEdgeNodes)
+    {
+        abstractGraph.getIntraEdges(node).pop_back();
+    }
+    for (int node : temporaryNodes)
+    {
+        abstractGraph.removeNode(node);
+    }
+}
@@ -0,0 +1,376 @@
+#ifndef HIERARCHICAL_H
+#define HIERARCHICAL_H
+
+#include <unordered_map>
+#include <vector>
+#include "algorithms.hpp"
+#include "gridgraph.h"
+#include "priorityqueues.hpp"
+#include "searchworkspace.hpp"
+
+/**
+ * @brief Read-only view of a rectangular cluster of a GridGraph, where the moves leaving
+ * the cluster are not allowed.
+ *
+ * Tiles are numbered as if the cluster always had the maximum size, so a single
+ * workspace can be shared by the searches on every cluster. When reversed, moving to a
+ * neighbor costs the cost of the tile being left, like in ReverseGridGraph.
+ */
+class ClusterGraph : public Graph<Tile>
+{
+public:
+    /**
+     * @brief Creates a view of the given grid, which must outlive it, for clusters of up
+     * to maxSize x maxSize tiles.
+     */
+    ClusterGraph(const GridGraph *graph, int maxSize);
+
+    /**
+     * @brief Moves the view to another cluster, which must fit in the maximum size.
+     */
+    void setBounds(int left, int top, int width, int height, bool reversed = false);
+
+    /**
+     * @return true if the tile is inside the current cluster.
+     */
+    bool contains(Tile tile) const
+    {
+        return tile.x >= left && tile.x < left + width && tile.y >= top && tile.y < top + height;
+    }
+
+    /**
+     * @return A tile which is never reached by searches on the view, to be used as the goal
+     * of searches that must cover the whole cluster.
+     */
+    Tile getOutsideTile() const;
+
+    std::vector<Tile> neighbors(Tile tile);
+
+    /**
+     * @brief Calls visit(neighbor, cost) for every neighbor of a tile in the grid which is
+     * inside the cluster.
+     */
+    template <typename Visitor>
+    void forEachNeighbor(Tile tile, Visitor visit) const
+    {
+        graph->forEachNeighbor(tile, [&](Tile next, double cost) {
+            if (contains(next))
+            {
+                visit(next, reversed ? graph->getMoveCost(next, tile) : cost);
+            }
+        });
+    }
+
+    int getNodeCount() const
+    {
+        return maxSize * maxSize;
+    }
+
+    int getNodeIndex(Tile tile) const
+    {
+        return (tile.y - top) * maxSize + (tile.x - left);
+    }
+
+    Tile getNode(int nodeIndex) const
+    {
+        return Tile{left + nodeIndex % maxSize, top + nodeIndex / maxSize};
+    }
+
+private:
+    const GridGraph *graph;
+    int maxSize;
+    int left, top, width, height;
+    bool reversed;
+};
+
+/**
+ * @brief Directed graph of the entrances between clusters, used by HierarchicalSearch.
+ *
+ * Nodes are numbered from 0 and each one stands for a tile. Intra-cluster edges join
+ * the entrances of the same cluster, with the cost of the best path between them inside
+ * the cluster, and inter-cluster edges cross a border between two clusters. Removed
+ * nodes keep their number, which is reused by the next node added.
+ */
+class AbstractGraph : public Graph<int>
+{
+public:
+    typedef struct Edge
+    {
+        int to;
+        double cost;
+    } Edge;
+
+public:
+    std::vector<int> neighbors(int node);
+
+    /**
+     * @brief Calls visit(neighbor, cost) for every edge going out of a node.
+     */
+    template <typename Visitor>
+    void forEachNeighbor(int node, Visitor visit) const
+    {
+        for (const Edge &edge : intraEdges[node])
+        {
+            visit(edge.to, edge.cost);
+        }
+        for (const Edge &edge : interEdges[node])
+        {
+            visit(edge.to, edge.cost);
+        }
+    }
+
+    /**
+     * @return The number of node numbers in use, including the ones of removed nodes.
+     */
+    int getNodeCount() const
+    {
+        return int(tiles.size());
+    }
+
+    int getNodeIndex(int node) const
+    {
+        return node;
+    }
+
+    int getNode(int nodeIndex) const
+    {
+        return nodeIndex;
+    }
+
+    /**
+     * @brief Adds a node without edges for a tile.
+     * @return The number of the new node.
+     */
+    int addNode(Tile tile);
+
+    /**
+     * @brief Removes a node and the edges going out of it.
+     *
+     * Edges going into the node must be removed by the caller.
+     */
+    void removeNode(int node);
+
+    /**
+     * @brief Makes room for adding the given number of nodes without changing the node
+     * count.
+     */
+    void reserveNodes(int count);
+
+    Tile getTile(int node) const
+    {
+        return tiles[node];
+    }
+
+    std::vector<Edge> &getIntraEdges(int node)
+    {
+        return intraEdges[node];
+    }
+
+    std::vector<Edge> &getInterEdges(int node)
+    {
+        return interEdges[node];
+    }
+
+private:
+    std::vector<Tile> tiles;
+    std::vector<std::vector<Edge>> intraEdges, interEdges;
+    std::vector<int> freeNodes;
+};
+
+/**
+ * @brief Heuristic on the nodes of an AbstractGraph, given by a heuristic on their tiles.
+ */
+template <typename HeuristicFunction>
+struct AbstractHeuristic
+{
+    const AbstractGraph *graph;
+    HeuristicFunction heuristic;
+
+    double operator()(int a, int b) const
+    {
+        return heuristic(graph->getTile(a), graph->getTile(b));
+    }
+};
+
+/**
+ * @brief Hierarchical path-finding A* (HPA*) over a GridGraph.
+ *
+ * The grid is split into square clusters, and the tiles on both sides of the borders
+ * between them where the border can be crossed are the entrances. Each walkable stretch
+ * of a border gets a single entrance in its middle, or one at each end if it's long.
+ * Diagonal moves across a border or a corner between clusters also get entrances when
+ * they're the only way across there, which only happens with corner movement. The best
+ * paths between the entrances of each cluster, staying inside it, are computed up front
+ * and make an abstract graph much smaller than the grid.
+ *
+ * A search adds the start and goal tiles to the abstract graph, runs A* on it and keeps
+ * the abstract path. Each of its segments is only turned into tiles when asked for, so
+ * the path can be followed before it's fully refined. Paths are optimal in the abstract
+ * graph, which makes them close to optimal but not always optimal in the grid, since
+ * they must go through entrances.
+ *
+ * The abstraction observes the grid. An edited cluster is marked and rebuilt before the
+ * next search, along with the clusters next to it only if the entrances on their shared
+ * border changed.
+ */
+class HierarchicalSearch : public GridGraphObserver
+{
+public:
+    static const int DEFAULT_CLUSTER_SIZE = 16;
+
+public:
+    /**
+     * @brief Builds the abstraction of the given grid, which must outlive it.
+     * @throws std::invalid_argument if the cluster size isn't positive.
+     */
+    explicit HierarchicalSearch(const GridGraph *graph,
+                                int clusterSize = DEFAULT_CLUSTER_SIZE);
+
+    ~HierarchicalSearch();
+
+    int getClusterSize() const;
+
+    /**
+     * @return The number of entrances in the abstract graph, rebuilding the edited
+     * clusters first.
+     */
+    int getEntranceCount();
+
+    /**
+     * @brief Finds an abstract path between two tiles with A*.
+     * @return The number of expanded abstract nodes.
+     */
+    template <typename HeuristicFunction>
+    unsigned long aStar(Tile start, Tile goal, HeuristicFunction heuristic)
+    {
+        if (!prepareSearch(start, goal))
+        {
+            return 0;
+        }
+        AbstractHeuristic<HeuristicFunction> abstractHeuristic{&abstractGraph, heuristic};
+        unsigned long expandedNodes = ::aStar(&abstractGraph, startNode, goalNode,
+                                              *abstractWorkspace, abstractQueue,
+                                              abstractHeuristic);
+        finishSearch();
+        return expandedNodes;
+    }
+
+    /**
+     * @return The cost of the path found by the last search, or -1 if there was none.
+     */
+    double getCost() const;
+
+    /**
+     * @return The entrances the path found by the last search goes through, starting
+     * with the start tile and ending with the goal tile, or an empty path if there was
+     * none.
+     */
+    const std::vector<Tile> &getAbstractPath() const;
+
+    /**
+     * @brief Refines a segment of the abstract path into tiles.
+     *
+     * The grid must not have changed since the search.
+     *
+     * @return The tiles that follow the start of the segment, up to and including its
+     * end.
+     */
+    std::vector<Tile> refineSegment(size_t segment);
+
+    /**
+     * @return The whole path found by the last search, which must have found one.
+     */
+    std::vector<Tile> getPath();
+
+    void tileChanged(Tile tile, double oldCost, double newCost) override;
+    void movementChanged() override;
+
+private:
+    // Kinds of borders, named after where the other cluster is
+    enum eBorder {RIGHT, BELOW, BELOW_RIGHT, BELOW_LEFT};
+
+    typedef struct Transition
+    {
+        Tile first, second;  // The first one is in the top or left cluster
+
+        bool operator==(const Transition &other) const
+        {
+            return first == other.first && second == other.second;
+        }
+    } Transition;
+
+    // Entrances as long as this or longer get a transition at each end
+    static const int LONG_ENTRANCE = 6;
+
+    int clusterOf(Tile tile) const;
+
+    /**
+     * @brief Moves the cluster view to a cluster.
+     */
+    void viewCluster(int cluster, bool reversed = false);
+
+    /**
+     * @brief Calls visit(kind, border, first, other) for every border of a cluster,
+     * including the corners it shares with the clusters diagonal to it, where border is
+     * the top or left cluster of the border, first tells if that's this cluster, and
+     * other is the cluster on the other side.
+     */
+    template <typename Visitor>
+    void forEachBorder(int cluster, Visitor visit) const;
+
+    /**
+     * @return true if there's a move in the grid from a walkable tile to another.
+     */
+    bool canMove(Tile from, Tile to) const;
+
+    /**
+     * @return The transitions across a border, with the top or left cluster given.
+     */
+    std::vector<Transition> findTransitions(eBorder kind, int border) const;
+
+    void markDirty(int cluster);
+    void rebuildDirtyClusters();
+    void rebuildNodes(int cluster);
+    void computeIntraEdges(int cluster);
+    void computeInterEdges(int cluster);
+
+    /**
+     * @brief Rebuilds what's needed and adds the start and goal tiles to the abstract
+     * graph.
+     * @return false if there can't be a path.
+     */
+    bool prepareSearch(Tile start, Tile goal);
+
+    /**
+     * @brief Keeps the abstract path found and removes the start and goal tiles from the
+     * abstract graph.
+     */
+    void finishSearch();
+
+private:
+    const GridGraph *graph;
+    int clusterSize;
+    int left, top, width, height;
+    int clustersX, clustersY;
+    // Transitions across each kind of border of each cluster
+    std::vector<std::vector<Transition>> borders[4];
+    std::vector<std::vector<int>> clusterNodes;
+    std::vector<bool> dirty;
+    std::vector<int> dirtyClusters;
+
+    AbstractGraph abstractGraph;
+    std::unordered_map<int, int> entranceNodes;  // Grid node index to abstract node
+    SearchWorkspace<AbstractGraph> *abstractWorkspace;
+    BinaryHeapQueue<int> abstractQueue;
+    ClusterGraph clusterGraph;
+    SearchWorkspace<ClusterGraph> clusterWorkspace;
+    BinaryHeapQueue<Tile> clusterQueue;
+
+    // State of the last search
+    int startNode, goalNode;
+    std::vector<int> temporaryNodes, goalEdgeNodes;
+    std::vector<Tile> abstractPath;
+    double cost;
+};
+
+#endif // HIERARCHICAL_H
@@ -0,0 +1,382 @@
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <queue>
+#include <vector>
+#include "algorithms.hpp"
+#include "gridgraph.h"
+
+/**
+ * @brief Lifelong Planning A* (LPA*) over a GridGraph, which repairs the previous search
+ * after the grid changes instead of starting over.
+ *
+ * Every tile keeps g, the cost it was reached with, and rhs, the best cost offered by
+ * its predecessors. A tile whose costs differ is inconsistent and is queued. When tiles
+ * change, only the costs of the tiles next to them are updated, and the next search
+ * expands the queued tiles until the goal is consistent again. Small edits then touch a
+ * small part of the grid.
+ *
+ * The planner observes the grid and collects the changed tiles until the next search.
+ * Moving the start or goal, setting another heuristic or changing the movement settings
+ * makes every key outdated, so the next search starts from scratch. Paths are optimal as
+ * long as the heuristic is consistent. A heuristic which is consistent with no slack,
+ * like the octile distance with diagonal moves costing sqrt(2), can still overestimate
+ * by a rounding error, which is enough to reorder the keys, so the heuristic is scaled
+ * down a little.
+ *
+ * The heuristic is a template parameter, like the ones of aStar, so it's called directly
+ * when computing the keys.
+ */
+template <typename HeuristicFunction>
+class IncrementalSearch : public GridGraphObserver
+{
+public:
+    /**
+     * @brief Creates a planner for the given grid, which must outlive it.
+     */
+    IncrementalSearch(const GridGraph *graph, HeuristicFunction heuristic)
+        : graph(graph),
+          start(Tile{0, 0}),
+          goal(Tile{0, 0}),
+          heuristic(heuristic),
+          initialized(false)
+    {
+        graph->addObserver(this);
+    }
+
+    ~IncrementalSearch()
+    {
+        graph->removeObserver(this);
+    }
+
+    /**
+     * @brief Finds the best path between two tiles, reusing the previous search if it was
+     * run between the same tiles with the same heuristic.
+     * @return The number of tiles expanded.
+     */
+    unsigned long search(Tile start, Tile goal)
+    {
+        if (graph->isOutOfBounds(start) || graph->isOutOfBounds(goal))
+        {
+            initialized = false;
+            return 0;
+        }
+        if (!initialized || !(start == this->start) || !(goal == this->goal))
+        {
+            // Keys depend on the goal, and costs on the start, so nothing can be reused
+            this->start = start;
+            this->goal = goal;
+            initialize();
+        }
+        else
+        {
+            // A tile changing affects the moves into it, and the moves around it which cut
+            // its corner, so only the costs of the tiles next to it can change
+            for (Tile tile : changedTiles)
+            {
+                for (int y = tile.y - 1; y <= tile.y + 1; ++y)
+                {
+                    for (int x = tile.x - 1; x <= tile.x + 1; ++x)
+                    {
+                        if (!graph->isOutOfBounds(Tile{x, y}))
+                        {
+                            updateTile(graph->getNodeIndex(Tile{x, y}));
+                        }
+                    }
+                }
+            }
+        }
+        changedTiles.clear();
+
+        unsigned long expandedNodes = 0;
+        int goalIndex = graph->getNodeIndex(goal);
+        while (cleanTop() && (queue.top().key < computeKey(goalIndex)
+                              || g[goalIndex] != rhs[goalIndex]))
+        {
+            int index = queue.top().index;
+            queue.pop();
+            queued[index] = false;
+            ++expandedNodes;
+
+            Tile tile = graph->getNode(index);
+            if (g[index] > rhs[index])
+            {
+                // Overconsistent, so its cost is final and can lower its successors' costs
+                g[index] = rhs[index];
+                graph->forEachNeighbor(tile, [&](Tile next, double cost) {
+                    int nextIndex = graph->getNodeIndex(next);
+                    if (g[index] + cost < rhs[nextIndex])
+                    {
+                        rhs[nextIndex] = g[index] + cost;
+                        enqueue(nextIndex);
+                    }
+                });
+            }
+            else
+            {
+                // Underconsistent, so its cost went up and everything reached through it
+                // must be reconsidered
+                g[index] = INFINITE_COST;
+                updateTile(index);
+                graph->forEachNeighbor(tile, [&](Tile next, double) {
+                    updateTile(graph->getNodeIndex(next));
+                });
+            }
+        }
+        return expandedNodes;
+    }
+
+    /**
+     * @brief Sets the heuristic of the next searches, which start from scratch, as the
+     * keys of the previous one were computed with the old heuristic.
+     */
+    void setHeuristic(HeuristicFunction heuristic)
+    {
+        this->heuristic = heuristic;
+        initialized = false;
+    }
+
+    /**
+     * @brief Forgets the previous search, so the next one starts from scratch.
+     */
+    void reset()
+    {
+        initialized = false;
+        changedTiles.clear();
+    }
+
+    /**
+     * @return The cost of the path found by the last search, or -1 if there was none.
+     */
+    double getCost() const
+    {
+        if (!initialized)
+        {
+            return -1;
+        }
+        double cost = g[graph->getNodeIndex(goal)];
+        return cost == INFINITE_COST ? -1 : cost;
+    }
+
+    /**
+     * @return The path found by the last search, or an empty path if there's none.
+     */
+    std::vector<Tile> getPath() const
+    {
+        if (getCost() < 0)
+        {
+            return std::vector<Tile>();
+        }
+        // Walk back from the goal through predecessors on a best path, the ones whose cost
+        // plus the move adds up to the cost of the current tile. Costs strictly decrease
+        // along the way, and no path has more steps than there are tiles, so the walk
+        // ends even if the costs are off.
+        std::vector<Tile> path{goal};
+        Tile current = goal;
+        for (int steps = 0; !(current == start); ++steps)
+        {
+            double currentCost = g[graph->getNodeIndex(current)];
+            Tile best = current;
+            double bestError = INFINITE_COST;
+            graph->forEachNeighbor(current, [&](Tile previous, double) {
+                double cost = g[graph->getNodeIndex(previous)];
+                double error = std::abs(cost + graph->getMoveCost(previous, current)
+                                        - currentCost);
+                if (cost < currentCost && error < bestError)
+                {
+                    best = previous;
+                    bestError = error;
+                }
+            });
+            if (best == current || bestError > PATH_TOLERANCE * std::max(1., currentCost)
+                    || steps >= graph->getNodeCount())
+            {
+                return std::vector<Tile>();
+            }
+            current = best;
+            path.push_back(current);
+        }
+        std::reverse(path.begin(), path.end());
+        return path;
+    }
+
+    /**
+     * @return The cost to reach each tile reached so far, including by earlier searches.
+     */
+    std::map<Tile, double> getCosts() const
+    {
+        std::map<Tile, double> costs;
+        if (!initialized)
+        {
+            return costs;
+        }
+        for (int index = 0; index < graph->getNodeCount(); ++index)
+        {
+            if (g[index] != INFINITE_COST)
+            {
+                costs[graph->getNode(index)] = g[index];
+            }
+        }
+        return costs;
+    }
+
+    void tileChanged(Tile tile, double, double) override
+    {
+        // Without a search to repair, the next one starts from scratch anyway
+        if (initialized)
+        {
+            changedTiles.push_back(tile);
+        }
+    }
+
+    void movementChanged() override
+    {
+        // Every move may have changed, so it's cheaper to start over
+        initialized = false;
+    }
+
+private:
+    typedef struct Key
+    {
+        double first, second;
+
+        bool operator<(const Key &other) const
+        {
+            return first < other.first || (first == other.first && second < other.second);
+        }
+
+        bool operator==(const Key &other) const
+        {
+            return first == other.first && second == other.second;
+        }
+    } Key;
+
+    typedef struct Entry
+    {
+        Key key;
+        int index;
+
+        // Reversed so that std::priority_queue pops the lowest key first
+        bool operator<(const Entry &other) const
+        {
+            return other.key < key;
+        }
+    } Entry;
+
+    Key computeKey(int index) const
+    {
+        double cost = std::min(g[index], rhs[index]);
+        return Key{cost + HEURISTIC_SCALE * heuristic(graph->getNode(index), goal), cost};
+    }
+
+    /**
+     * @brief Recomputes the rhs of a tile from its predecessors, and queues it if it's
+     * inconsistent.
+     */
+    void updateTile(int index)
+    {
+        Tile tile = graph->getNode(index);
+        if (!(tile == start))
+        {
+            // Moves between walkable tiles go both ways, so the predecessors of a tile are
+            // its neighbors
+            rhs[index] = INFINITE_COST;
+            if (!graph->isWall(tile))
+            {
+                graph->forEachNeighbor(tile, [&](Tile previous, double) {
+                    rhs[index] = std::min(rhs[index], g[graph->getNodeIndex(previous)]
+                            + graph->getMoveCost(previous, tile));
+                });
+            }
+        }
+        if (g[index] != rhs[index])
+        {
+            enqueue(index);
+        }
+        else
+        {
+            queued[index] = false;
+        }
+    }
+
+    /**
+     * @brief Queues a tile with its current key, replacing the entry it had.
+     */
+    void enqueue(int index)
+    {
+        // The old entry, if any, is left in the queue and skipped when it reaches the top
+        Key key = computeKey(index);
+        queuedKeys[index] = key;
+        queued[index] = true;
+        queue.push(Entry{key, index});
+    }
+
+    /**
+     * @brief Drops the outdated entries at the top of the queue.
+     * @return false if the queue is empty.
+     */
+    bool cleanTop()
+    {
+        while (!queue.empty())
+        {
+            const Entry &top = queue.top();
+            if (queued[top.index] && queuedKeys[top.index] == top.key)
+            {
+                return true;
+            }
+            queue.pop();
+        }
+        return false;
+    }
+
+    /**
+     * @brief Sets every tile as unreached and queues the start.
+     */
+    void initialize()
+    {
+        int nodeCount = graph->getNodeCount();
+        g.assign(nodeCount, INFINITE_COST);
+        rhs.assign(nodeCount, INFINITE_COST);
+        queuedKeys.resize(nodeCount);
+        queued.assign(nodeCount, false);
+        queue = std::priority_queue<Entry>();
+        int startIndex = graph->getNodeIndex(start);
+        rhs[startIndex] = 0;
+        enqueue(startIndex);
+        initialized = true;
+    }
+
+private:
+    static constexpr double INFINITE_COST = std::numeric_limits<double>::infinity();
+    // Relative rounding error allowed between the cost of a tile and the one it's reached
+    // from plus the move
+    static constexpr double PATH_TOLERANCE = 1e-9;
+    // Leaves the heuristic some slack against rounding, see the class description
+    static constexpr double HEURISTIC_SCALE = 1 - 1e-9;
+
+    const GridGraph *graph;
+    Tile start, goal;
+    HeuristicFunction heuristic;
+    bool initialized;
+    std::vector<double> g, rhs;
+    // Key each queued tile was pushed with; entries with any other key are outdated
+    std::vector<Key> queuedKeys;
+    std::vector<bool> queued;
+    std::priority_queue<Entry> queue;
+    std::vector<Tile> changedTiles;  // Since the last search
+};
+
+template <typename HeuristicFunction>
+constexpr double IncrementalSearch<HeuristicFunction>::INFINITE_COST;
+
+template <typename HeuristicFunction>
+constexpr double IncrementalSearch<HeuristicFunction>::PATH_TOLERANCE;
+
+template <typename HeuristicFunction>
+constexpr double IncrementalSearch<HeuristicFunction>::HEURISTIC_SCALE;
+
+#endif // INCREMENTAL_H
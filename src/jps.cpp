@@ -0,0 +1,388 @@
+#include "jps.h"
+#include <cstdlib>
+
+/**
+ * @return The index of the lowest set bit of a non-zero word.
+ */
+static inline int lowestBit(uint64_t word)
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll(word);
+#else
+    int bit = 0;
+    while (!(word & 1))
+    {
+        word >>= 1;
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+/**
+ * @return The index of the highest set bit of a non-zero word.
+ */
+static inline int highestBit(uint64_t word)
+{
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(word);
+#else
+    int bit = 63;
+    while (!(word >> 63))
+    {
+        word <<= 1;
+        --bit;
+    }
+    return bit;
+#endif
+}
+
+/**
+ * @return The 64 bits of a line starting at the given position, which can be negative or
+ * go past the end of the line, in which case the missing bits are set.
+ */
+static inline uint64_t bitsFrom(const uint64_t *line, int lineWords, int position)
+{
+    int word = position >= 0 ? position / 64 : -((63 - position) / 64);
+    int shift = position - word * 64;
+    uint64_t low = (word >= 0 && word < lineWords) ? line[word] : ~uint64_t(0);
+    if (shift == 0)
+    {
+        return low;
+    }
+    uint64_t high = (word + 1 >= 0 && word + 1 < lineWords) ? line[word + 1] : ~uint64_t(0);
+    return (low >> shift) | (high << (64 - shift));
+}
+
+JumpPointSearch::JumpPointSearch(const GridGraph *graph)
+    : graph(graph)
+{
+    update();
+}
+
+void JumpPointSearch::update()
+{
+    if (!graph->isDiagonalAllowed())
+        movement = STRAIGHT;
+    else if (graph->isCornerMovementAllowed())
+        movement = CORNER_MOVEMENT;
+    else
+        movement = DIAGONAL;
+
+    std::pair<int, int> topLeft = graph->getTopLeft();
+    left = topLeft.first;
+    top = topLeft.second;
+    width = graph->getWidth();
+    height = graph->getHeight();
+
+    // Every tile starts blocked, so the padding and the unused bits stay that way
+    rowWords = (width + 2 + 63) / 64;
+    columnWords = (height + 2 + 63) / 64;
+    rows.assign(size_t(rowWords) * (height + 2), ~uint64_t(0));
+    columns.assign(size_t(columnWords) * (width + 2), ~uint64_t(0));
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            if (graph->isWall(Tile{left + x, top + y}))
+            {
+                continue;
+            }
+            rows[size_t(y + 1) * rowWords + (x + 1) / 64] &= ~(uint64_t(1) << ((x + 1) % 64));
+            columns[size_t(x + 1) * columnWords + (y + 1) / 64]
+                    &= ~(uint64_t(1) << ((y + 1) % 64));
+        }
+    }
+}
+
+void JumpPointSearch::updateTile(Tile tile)
+{
+    int column = tile.x - left + 1, row = tile.y - top + 1;
+    uint64_t &rowWord = rows[size_t(row) * rowWords + column / 64];
+    uint64_t &columnWord = columns[size_t(column) * columnWords + row / 64];
+    uint64_t rowBit = uint64_t(1) << (column % 64);
+    uint64_t columnBit = uint64_t(1) << (row % 64);
+    if (graph->isWall(tile))
+    {
+        rowWord |= rowBit;
+        columnWord |= columnBit;
+    }
+    else
+    {
+        rowWord &= ~rowBit;
+        columnWord &= ~columnBit;
+    }
+}
+
+bool JumpPointSearch::canSearch() const
+{
+    return graph->hasUniformCosts();
+}
+
+bool JumpPointSearch::isBlocked(int x, int y) const
+{
+    int column = x - left + 1, row = y - top + 1;
+    if (column < 0 || column > width + 1 || row < 0 || row > height + 1)
+    {
+        return true;
+    }
+    return (rows[size_t(row) * rowWords + column / 64] >> (column % 64)) & 1;
+}
+
+bool JumpPointSearch::canMove(int x, int y, int dx, int dy) const
+{
+    if (isBlocked(x + dx, y + dy))
+    {
+        return false;
+    }
+    if (dx == 0 || dy == 0)
+    {
+        return true;
+    }
+    switch (movement)
+    {
+    case STRAIGHT:
+        return false;
+    case DIAGONAL:
+        // Both tiles on the sides of the diagonal must be walkable
+        return !isBlocked(x + dx, y) && !isBlocked(x, y + dy);
+    default:
+        return true;
+    }
+}
+
+int JumpPointSearch::scanLine(const uint64_t *line,
+                              const uint64_t *side1,
+                              const uint64_t *side2,
+                              int lineWords,
+                              int from,
+                              int dir,
+                              int goal,
+                              bool &blocked) const
+{
+    // With corner movement, a neighbor is forced when a blocked tile on a side line is
+    // followed by a walkable one, as the next tile can then be reached diagonally. Without
+    // it, when a walkable tile on a side line follows a blocked one.
+    bool corner = movement == CORNER_MOVEMENT;
+    // Each chunk covers 64 positions starting at base, with the scan going up from the
+    // first one or down from the last one
+    int base = dir > 0 ? from : from - 63;
+    while (true)
+    {
+        uint64_t own = bitsFrom(line, lineWords, base);
+        uint64_t forced = 0;
+        for (const uint64_t *side : {side1, side2})
+        {
+            uint64_t current = bitsFrom(side, lineWords, base);
+            uint64_t ahead = bitsFrom(side, lineWords, base + dir);
+            uint64_t behind = bitsFrom(side, lineWords, base - dir);
+            forced |= corner ? current & ~ahead : ~current & behind;
+        }
+        uint64_t goalBit = 0;
+        if (goal >= base && goal < base + 64)
+        {
+            goalBit = uint64_t(1) << (goal - base);
+        }
+        uint64_t stops = own | forced | goalBit;
+        if (stops != 0)
+        {
+            int bit = dir > 0 ? lowestBit(stops) : highestBit(stops);
+            blocked = (own >> bit) & 1;
+            return base + bit;
+        }
+        base += 64 * dir;
+    }
+}
+
+bool JumpPointSearch::jumpHorizontal(int x, int y, int dx, Tile goal, Tile &jumpPoint) const
+{
+    int row = y - top + 1;
+    const uint64_t *line = &rows[size_t(row) * rowWords];
+    int goalPosition = goal.y == y ? goal.x - left + 1 : -1;
+    bool blocked;
+    int position = scanLine(line, line - rowWords, line + rowWords, rowWords,
+                            x + dx - left + 1, dx, goalPosition, blocked);
+    if (blocked)
+    {
+        return false;
+    }
+    jumpPoint = Tile{position + left - 1, y};
+    return true;
+}
+
+bool JumpPointSearch::jumpVertical(int x, int y, int dy, Tile goal, Tile &jumpPoint) const
+{
+    int column = x - left + 1;
+    const uint64_t *line = &columns[size_t(column) * columnWords];
+    int goalPosition = goal.x == x ? goal.y - top + 1 : -1;
+    bool blocked;
+    int position = scanLine(line, line - columnWords, line + columnWords, columnWords,
+                            y + dy - top + 1, dy, goalPosition, blocked);
+    int end = position + top - 1;
+    if (movement == STRAIGHT)
+    {
+        // Without diagonals, a tile is also a jump point if a horizontal jump from it
+        // finds one, as that's the only way to turn
+        Tile unused;
+        for (int ny = y + dy; ny != end; ny += dy)
+        {
+            if (jumpHorizontal(x, ny, 1, goal, unused) || jumpHorizontal(x, ny, -1, goal, unused))
+            {
+                jumpPoint = Tile{x, ny};
+                return true;
+            }
+        }
+    }
+    if (blocked)
+    {
+        return false;
+    }
+    jumpPoint = Tile{x, end};
+    return true;
+}
+
+bool JumpPointSearch::jumpDiagonal(int x, int y, int dx, int dy, Tile goal,
+                                   Tile &jumpPoint) const
+{
+    Tile unused;
+    while (canMove(x, y, dx, dy))
+    {
+        x += dx;
+        y += dy;
+        if (x == goal.x && y == goal.y)
+        {
+            jumpPoint = goal;
+            return true;
+        }
+        // With corner movement, a blocked tile behind a side makes the tile past it a
+        // forced neighbor
+        if (movement == CORNER_MOVEMENT
+                && ((!isBlocked(x - dx, y + dy) && isBlocked(x - dx, y))
+                    || (!isBlocked(x + dx, y - dy) && isBlocked(x, y - dy))))
+        {
+            jumpPoint = Tile{x, y};
+            return true;
+        }
+        // A tile is also a jump point if a straight jump from it finds one
+        if (jumpHorizontal(x, y, dx, goal, unused) || jumpVertical(x, y, dy, goal, unused))
+        {
+            jumpPoint = Tile{x, y};
+            return true;
+        }
+    }
+    return false;
+}
+
+bool JumpPointSearch::jump(int x, int y, int dx, int dy, Tile goal, Tile &jumpPoint) const
+{
+    if (dx != 0 && dy != 0)
+    {
+        return jumpDiagonal(x, y, dx, dy, goal, jumpPoint);
+    }
+    // The first move is checked here, as the scans only look at the tiles it reaches
+    if (!canMove(x, y, dx, dy))
+    {
+        return false;
+    }
+    if (dy == 0)
+    {
+        return jumpHorizontal(x, y, dx, goal, jumpPoint);
+    }
+    return jumpVertical(x, y, dy, goal, jumpPoint);
+}
+
+int JumpPointSearch::successors(Tile tile, Tile parent, Tile goal, Tile result[8]) const
+{
+    if (graph->isOutOfBounds(tile))
+    {
+        return 0;
+    }
+    int x = tile.x, y = tile.y;
+    // Directions worth searching, which are all of them for the start tile
+    Tile directions[8];
+    int directionCount = 0;
+    int dx = (tile.x > parent.x) - (tile.x < parent.x);
+    int dy = (tile.y > parent.y) - (tile.y < parent.y);
+    if (dx == 0 && dy == 0)
+    {
+        for (int i = 0; i < 8; ++i)
+        {
+            directions[directionCount++] = GridGraph::MASK_DIRS[i];
+        }
+    }
+    else if (dx != 0 && dy != 0)
+    {
+        // Natural neighbors of a diagonal move
+        directions[directionCount++] = Tile{dx, 0};
+        directions[directionCount++] = Tile{0, dy};
+        directions[directionCount++] = Tile{dx, dy};
+        if (movement == CORNER_MOVEMENT)
+        {
+            if (isBlocked(x - dx, y))
+                directions[directionCount++] = Tile{-dx, dy};
+            if (isBlocked(x, y - dy))
+                directions[directionCount++] = Tile{dx, -dy};
+        }
+    }
+    else
+    {
+        // Natural neighbor of a straight move, and the perpendicular ones
+        int px = dy, py = dx;
+        directions[directionCount++] = Tile{dx, dy};
+        switch (movement)
+        {
+        case STRAIGHT:
+            directions[directionCount++] = Tile{px, py};
+            directions[directionCount++] = Tile{-px, -py};
+            break;
+        case DIAGONAL:
+            directions[directionCount++] = Tile{px, py};
+            directions[directionCount++] = Tile{-px, -py};
+            directions[directionCount++] = Tile{dx + px, dy + py};
+            directions[directionCount++] = Tile{dx - px, dy - py};
+            break;
+        case CORNER_MOVEMENT:
+            // Forced neighbors behind a blocked side
+            if (isBlocked(x + px, y + py))
+                directions[directionCount++] = Tile{dx + px, dy + py};
+            if (isBlocked(x - px, y - py))
+                directions[directionCount++] = Tile{dx - px, dy - py};
+            break;
+        }
+    }
+
+    int count = 0;
+    for (int i = 0; i < directionCount; ++i)
+    {
+        Tile jumpPoint;
+        if (jump(x, y, directions[i].x, directions[i].y, goal, jumpPoint))
+        {
+            result[count++] = jumpPoint;
+        }
+    }
+    return count;
+}
+
+std::vector<Tile> expandJumpPath(const std::vector<Tile> &jumpPoints)
+{
+    std::vector<Tile> path;
+    for (size_t i = 0; i < jumpPoints.size(); ++i)
+    {
+        if (i == 0)
+        {
+            path.push_back(jumpPoints[i]);
+            continue;
+        }
+        // Step along the straight or diagonal line from the previous jump point
+        Tile current = jumpPoints[i - 1];
+        const Tile &next = jumpPoints[i];
+        int dx = (next.x > current.x) - (next.x < current.x);
+        int dy = (next.y > current.y) - (next.y < current.y);
+        while (current != next)
+        {
+            current = Tile{current.x + dx, current.y + dy};
+            path.push_back(current);
+        }
+    }
+    return path;
+}
@@ -0,0 +1,233 @@
+#ifndef JPS_H
+#define JPS_H
+
+#include <cstdint>
+#include <map>
+#include <vector>
+#include "algorithms.hpp"
+#include "gridgraph.h"
+#include "priorityqueues.hpp"
+#include "searchworkspace.hpp"
+
+/**
+ * @brief Jump Point Search successor generator for GridGraphs where every walkable tile
+ * has the same cost.
+ *
+ * Instead of expanding every neighbor, Jump Point Search prunes the neighbors that can
+ * be reached at least as cheaply without going through the current tile, and jumps in a
+ * straight or diagonal line until it finds a tile with a neighbor that can't be pruned,
+ * called a jump point. Only jump points are added to the open list.
+ *
+ * The 4-connected variant and both 8-connected variants, with and without corner
+ * movement, follow the same movement rules as GridGraph, so paths have the same cost as
+ * the ones found by A*.
+ *
+ * Straight jumps are word-level scans over a bitmap of blocked tiles, with one bit per
+ * tile, stored once by rows and once by columns. Both bitmaps are padded with a blocked
+ * line all around the grid, so scans always end without bounds checks.
+ */
+class JumpPointSearch
+{
+public:
+    /**
+     * @brief Creates a successor generator for the given grid, which must outlive it.
+     */
+    explicit JumpPointSearch(const GridGraph *graph);
+
+    virtual ~JumpPointSearch() {}
+
+    /**
+     * @brief Rebuilds the bitmaps and the movement rules from the grid.
+     *
+     * Must be called after changing the walls of the grid or its diagonal and corner
+     * movement settings.
+     */
+    virtual void update();
+
+    /**
+     * @return true if Jump Point Search finds optimal paths on the grid, that is, if every
+     * walkable tile has the same cost.
+     */
+    bool canSearch() const;
+
+    /**
+     * @brief Finds the jump points that follow a tile when reached from its parent.
+     *
+     * If the parent is the tile itself, as for the start tile, every direction is
+     * searched.
+     *
+     * @param result Array where the jump points are stored, with room for 8 of them.
+     * @return The number of jump points found.
+     */
+    int successors(Tile tile, Tile parent, Tile goal, Tile result[8]) const;
+
+protected:
+    enum eMovement {STRAIGHT, DIAGONAL, CORNER_MOVEMENT};
+
+    /**
+     * @brief Updates the bitmaps after a single tile has become a wall or stopped being
+     * one.
+     */
+    void updateTile(Tile tile);
+
+    /**
+     * @return true if the tile is a wall or out of bounds.
+     */
+    bool isBlocked(int x, int y) const;
+
+    /**
+     * @return true if a single move from the tile in the given direction is allowed.
+     */
+    bool canMove(int x, int y, int dx, int dy) const;
+
+    /**
+     * @brief Scans a bitmap line from a position, in the direction given by dir, which is
+     * 1 or -1, until reaching a jump point or a blocked tile.
+     *
+     * The side lines are the ones next to the scanned line, where forced neighbors can
+     * appear. Positions are bit indices in the line, which are the coordinate plus one
+     * because of the padding.
+     *
+     * @param goal Position of the goal in the line, or -1 if it's not on it.
+     * @param blocked Set to true if the scan ended on a blocked tile.
+     * @return The position where the scan ended.
+     */
+    int scanLine(const uint64_t *line,
+                 const uint64_t *side1,
+                 const uint64_t *side2,
+                 int lineWords,
+                 int from,
+                 int dir,
+                 int goal,
+                 bool &blocked) const;
+
+    /**
+     * @brief Jumps from a tile in a straight or diagonal direction.
+     * @return true if a jump point was found, which is stored in jumpPoint.
+     */
+    virtual bool jump(int x, int y, int dx, int dy, Tile goal, Tile &jumpPoint) const;
+
+private:
+    bool jumpHorizontal(int x, int y, int dx, Tile goal, Tile &jumpPoint) const;
+    bool jumpVertical(int x, int y, int dy, Tile goal, Tile &jumpPoint) const;
+    bool jumpDiagonal(int x, int y, int dx, int dy, Tile goal, Tile &jumpPoint) const;
+
+protected:
+    const GridGraph *graph;
+    eMovement movement;
+    int left, top, width, height;
+    // Blocked tiles, one bit per tile with a padding line all around the grid
+    std::vector<uint64_t> rows, columns;
+    int rowWords, columnWords;  // Words per line of each bitmap
+};
+
+/**
+ * Expands a path of jump points into the full path, adding the tiles in the straight or
+ * diagonal lines between each pair of consecutive jump points.
+ */
+std::vector<Tile> expandJumpPath(const std::vector<Tile> &jumpPoints);
+
+/**
+ * Compute the optimal path between two tiles using Jump Point Search with early exit.
+ *
+ * The search is A* over jump points, so the state only holds costs and previous tiles
+ * for jump points, and the path made by them can be expanded with expandJumpPath. If
+ * the grid doesn't have uniform costs, it falls back to plain A*.
+ *
+ * The generator must be up to date with the grid.
+ */
+template <typename State, typename Queue, typename HeuristicFunction>
+unsigned long jumpPointSearch(GridGraph *graph,
+                              const JumpPointSearch &generator,
+                              Tile start,
+                              Tile goal,
+                              State &state,
+                              Queue &nodeQueue,
+                              HeuristicFunction heuristic)
+{
+    if (!generator.canSearch())
+    {
+        return aStar(graph, start, goal, state, nodeQueue, heuristic);
+    }
+    double tileCost = graph->getMaxCost();
+    double diagonalCost = tileCost * graph->getDiagonalCostFactor();
+    nodeQueue.clear();
+    nodeQueue.push(start, heuristic(start, goal));
+    unsigned long expandedNodes = 0;
+    Tile jumpPoints[8];
+
+    state.reset();
+    state.update(start, start, 0);
+
+    while (!nodeQueue.empty())
+    {
+        // Get next node to examine
+        Tile current = nodeQueue.pop();
+        // Skip outdated queue entries of nodes that were already expanded
+        if (state.isClosed(current))
+        {
+            continue;
+        }
+        state.close(current);
+        ++expandedNodes;
+
+        // Early exit condition
+        if (current == goal)
+        {
+            return expandedNodes;
+        }
+
+        // Push the jump points that follow, every move on the way costing the same, and
+        // each jump going either straight or diagonally
+        double currentCost = state.getCost(current);
+        int count = generator.successors(current, state.getPrevious(current), goal,
+                                         jumpPoints);
+        for (int i = 0; i < count; ++i)
+        {
+            Tile next = jumpPoints[i];
+            int dx = std::abs(next.x - current.x), dy = std::abs(next.y - current.y);
+            double cost = currentCost + (dx != 0 && dy != 0 ? dx * diagonalCost
+                                                            : std::max(dx, dy) * tileCost);
+            if (!state.isVisited(next) || cost < state.getCost(next))
+            {
+                state.update(next, current, cost);
+                nodeQueue.push(next, cost + heuristic(next, goal));
+            }
+        }
+    }
+    return expandedNodes;
+}
+
+/**
+ * Compute the optimal path between two tiles using Jump Point Search with early exit,
+ * using a BinaryHeapQueue.
+ */
+template <typename State, typename HeuristicFunction>
+unsigned long jumpPointSearch(GridGraph *graph,
+                              const JumpPointSearch &generator,
+                              Tile start,
+                              Tile goal,
+                              State &state,
+                              HeuristicFunction heuristic)
+{
+    BinaryHeapQueue<Tile> nodeQueue;
+    return jumpPointSearch(graph, generator, start, goal, state, nodeQueue, heuristic);
+}
+
+/**
+ * Compute the optimal path between two tiles using Jump Point Search with early exit.
+ */
+template <typename HeuristicFunction>
+unsigned long jumpPointSearch(GridGraph *graph,
+                              const JumpPointSearch &generator,
+                              Tile start,
+                              Tile goal,
+                              std::map<Tile, Tile> &previous,
+                              std::map<Tile, double> &costToNode,
+                              HeuristicFunction heuristic)
+{
+    MapSearchState<Tile> state(previous, costToNode);
+    return jumpPointSearch(graph, generator, start, goal, state, heuristic);
+}
+
+#endif // JPS_H
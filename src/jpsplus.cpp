@@ -0,0 +1,327 @@
+#include "jpsplus.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+
+// Identifies the files written by JumpPointTable::save, and the version of their layout
+static const char TABLE_MAGIC[4] = {'J', 'P', 'S', '+'};
+static const int32_t TABLE_VERSION = 1;
+
+/**
+ * @brief Header of a saved table, followed by the entries.
+ */
+struct TableHeader
+{
+    char magic[4];
+    int32_t version;
+    int32_t left, top, width, height;
+    int32_t movement;
+    uint64_t wallHash;
+};
+
+JumpPointTable::JumpPointTable(const GridGraph *graph, const std::string &filename)
+    : JumpPointSearch(graph),
+      stale(true),
+      loaded(false)
+{
+    loaded = !filename.empty() && load(filename);
+    if (!loaded)
+    {
+        buildEntries();
+    }
+    graph->addObserver(this);
+}
+
+JumpPointTable::~JumpPointTable()
+{
+    graph->removeObserver(this);
+}
+
+void JumpPointTable::update()
+{
+    JumpPointSearch::update();
+    buildEntries();
+}
+
+bool JumpPointTable::wasLoaded() const
+{
+    return loaded;
+}
+
+std::string JumpPointTable::tableFilename(const std::string &mapFilename)
+{
+    return mapFilename + ".jps";
+}
+
+void JumpPointTable::save(const std::string &filename)
+{
+    if (stale)
+    {
+        buildSecondary();
+    }
+    std::ofstream file(filename, std::ios::binary);
+    if (!file)
+    {
+        throw std::runtime_error("Error writing file");
+    }
+    TableHeader header;
+    std::copy(TABLE_MAGIC, TABLE_MAGIC + 4, header.magic);
+    header.version = TABLE_VERSION;
+    header.left = left;
+    header.top = top;
+    header.width = width;
+    header.height = height;
+    header.movement = movement;
+    header.wallHash = wallHash();
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(entries.data()),
+               entries.size() * sizeof(int32_t));
+    if (!file)
+    {
+        throw std::runtime_error("Error writing file");
+    }
+}
+
+bool JumpPointTable::load(const std::string &filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    TableHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+    {
+        return false;
+    }
+    if (!std::equal(TABLE_MAGIC, TABLE_MAGIC + 4, header.magic)
+            || header.version != TABLE_VERSION
+            || header.left != left || header.top != top
+            || header.width != width || header.height != height
+            || header.movement != movement
+            || header.wallHash != wallHash())
+    {
+        return false;
+    }
+    std::vector<int32_t> saved(size_t(width) * height * 8);
+    if (!file.read(reinterpret_cast<char*>(saved.data()), saved.size() * sizeof(int32_t)))
+    {
+        return false;
+    }
+    entries.swap(saved);
+    stale = false;
+    return true;
+}
+
+void JumpPointTable::tileChanged(Tile tile, double oldCost, double newCost)
+{
+    // Only walls change the jumps
+    if ((oldCost < 0) == (newCost < 0))
+    {
+        return;
+    }
+    updateTile(tile);
+    // Recompute the lines around the tile for the directions kept up to date
+    int fromY = std::max(tile.y - 1, top), toY = std::min(tile.y + 1, top + height - 1);
+    int fromX = std::max(tile.x - 1, left), toX = std::min(tile.x + 1, left + width - 1);
+    build(1, 0, left, left + width - 1, fromY, toY);
+    build(-1, 0, left, left + width - 1, fromY, toY);
+    if (isPrimary(0, 1))
+    {
+        build(0, 1, fromX, toX, top, top + height - 1);
+        build(0, -1, fromX, toX, top, top + height - 1);
+    }
+    stale = true;
+}
+
+void JumpPointTable::movementChanged()
+{
+    update();
+}
+
+bool JumpPointTable::jump(int x, int y, int dx, int dy, Tile goal, Tile &jumpPoint) const
+{
+    int entry = entryAt(x, y, dx, dy);
+    int reach = std::abs(entry);
+    // Moves until the tile where a plain jump would stop because of the goal, if any.
+    // Diagonal jumps stop when reaching the row or column of the goal, as do vertical
+    // jumps without diagonal movement, since a horizontal jump may reach it from there.
+    // Stopping there is harmless even if the goal can't be reached, as the search then
+    // carries on in the same direction.
+    int goalMoves = 0;
+    if (dx != 0 && dy != 0)
+    {
+        int movesX = (goal.x - x) * dx, movesY = (goal.y - y) * dy;
+        if (movesX > 0 && movesY > 0)
+        {
+            goalMoves = std::min(movesX, movesY);
+        }
+    }
+    else if (dy == 0)
+    {
+        goalMoves = goal.y == y ? (goal.x - x) * dx : 0;
+    }
+    else
+    {
+        goalMoves = goal.x == x || movement == STRAIGHT ? (goal.y - y) * dy : 0;
+    }
+
+    if (goalMoves > 0 && goalMoves <= reach)
+    {
+        jumpPoint = Tile{x + goalMoves * dx, y + goalMoves * dy};
+        return true;
+    }
+    if (entry > 0)
+    {
+        jumpPoint = Tile{x + entry * dx, y + entry * dy};
+        return true;
+    }
+    return false;
+}
+
+int JumpPointTable::direction(int dx, int dy)
+{
+    // Position in MASK_DIRS of each move, indexed by (dy + 1) * 3 + dx + 1
+    static const int DIRECTIONS[9] = {5, 1, 7, 2, -1, 0, 6, 3, 4};
+    return DIRECTIONS[(dy + 1) * 3 + dx + 1];
+}
+
+bool JumpPointTable::isPrimary(int dx, int dy) const
+{
+    // Without diagonal movement, vertical jumps also stop on tiles where horizontal jumps
+    // find a jump point
+    return dy == 0 || (dx == 0 && movement != STRAIGHT);
+}
+
+size_t JumpPointTable::entryIndex(int x, int y, int dx, int dy) const
+{
+    return (size_t(y - top) * width + (x - left)) * 8 + direction(dx, dy);
+}
+
+int JumpPointTable::entryAt(int x, int y, int dx, int dy) const
+{
+    if (stale && !isPrimary(dx, dy))
+    {
+        return walk(x, y, dx, dy);
+    }
+    return entries[entryIndex(x, y, dx, dy)];
+}
+
+bool JumpPointTable::isForced(int x, int y, int dx, int dy) const
+{
+    // Same rules as the bitmap scans, for the tiles on both sides of the line
+    bool corner = movement == CORNER_MOVEMENT;
+    for (int side : {1, -1})
+    {
+        int sx = x + dy * side, sy = y + dx * side;
+        bool current = isBlocked(sx, sy);
+        if (corner ? current && !isBlocked(sx + dx, sy + dy)
+                   : !current && isBlocked(sx - dx, sy - dy))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool JumpPointTable::isJumpPoint(int x, int y, int dx, int dy) const
+{
+    if (dx != 0 && dy != 0)
+    {
+        if (movement == CORNER_MOVEMENT
+                && ((!isBlocked(x - dx, y + dy) && isBlocked(x - dx, y))
+                    || (!isBlocked(x + dx, y - dy) && isBlocked(x, y - dy))))
+        {
+            return true;
+        }
+        return entryAt(x, y, dx, 0) > 0 || entryAt(x, y, 0, dy) > 0;
+    }
+    if (isForced(x, y, dx, dy))
+    {
+        return true;
+    }
+    return !isPrimary(dx, dy) && (entryAt(x, y, 1, 0) > 0 || entryAt(x, y, -1, 0) > 0);
+}
+
+int JumpPointTable::computeEntry(int x, int y, int dx, int dy) const
+{
+    if (!canMove(x, y, dx, dy))
+    {
+        return 0;
+    }
+    if (isJumpPoint(x + dx, y + dy, dx, dy))
+    {
+        return 1;
+    }
+    int next = entries[entryIndex(x + dx, y + dy, dx, dy)];
+    return next > 0 ? next + 1 : next - 1;
+}
+
+int JumpPointTable::walk(int x, int y, int dx, int dy) const
+{
+    int moves = 0;
+    while (canMove(x, y, dx, dy))
+    {
+        x += dx;
+        y += dy;
+        ++moves;
+        if (isJumpPoint(x, y, dx, dy))
+        {
+            return moves;
+        }
+    }
+    return -moves;
+}
+
+void JumpPointTable::build(int dx, int dy, int fromX, int toX, int fromY, int toY)
+{
+    // Go against the direction, so the tile one move away is always done first
+    int firstX = dx > 0 ? toX : fromX, lastX = dx > 0 ? fromX : toX;
+    int firstY = dy > 0 ? toY : fromY, lastY = dy > 0 ? fromY : toY;
+    int stepX = dx > 0 ? -1 : 1, stepY = dy > 0 ? -1 : 1;
+    for (int y = firstY; y != lastY + stepY; y += stepY)
+    {
+        for (int x = firstX; x != lastX + stepX; x += stepX)
+        {
+            entries[entryIndex(x, y, dx, dy)] = computeEntry(x, y, dx, dy);
+        }
+    }
+}
+
+void JumpPointTable::buildEntries()
+{
+    entries.assign(size_t(width) * height * 8, 0);
+    for (int i = 0; i < 4; ++i)
+    {
+        const Tile &dir = GridGraph::MASK_DIRS[i];
+        if (isPrimary(dir.x, dir.y))
+        {
+            build(dir.x, dir.y, left, left + width - 1, top, top + height - 1);
+        }
+    }
+    buildSecondary();
+}
+
+void JumpPointTable::buildSecondary()
+{
+    for (int i = 0; i < 8; ++i)
+    {
+        const Tile &dir = GridGraph::MASK_DIRS[i];
+        // Diagonals are only used with diagonal movement
+        if (isPrimary(dir.x, dir.y) || (i >= 4 && movement == STRAIGHT))
+        {
+            continue;
+        }
+        build(dir.x, dir.y, left, left + width - 1, top, top + height - 1);
+    }
+    stale = false;
+}
+
+uint64_t JumpPointTable::wallHash() const
+{
+    // FNV-1a over the words of the row bitmap
+    uint64_t hash = 14695981039346656037ULL;
+    for (uint64_t word : rows)
+    {
+        hash ^= word;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
@@ -0,0 +1,152 @@
+#ifndef JPSPLUS_H
+#define JPSPLUS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "gridgraph.h"
+#include "jps.h"
+
+/**
+ * @brief Jump Point Search successor generator with the jumps precomputed, also known as
+ * JPS+.
+ *
+ * For every tile and each of the 8 directions, the table stores how far the jump from
+ * that tile goes, ignoring the goal: a positive entry is the number of moves to the next
+ * jump point, and any other entry is minus the number of moves that can be made before
+ * reaching a wall. The goal is taken into account during the search by stopping the jump
+ * early when it goes past the goal, or past the row or column of the goal in the cases
+ * where a plain jump would turn towards it there. Online search then never scans the
+ * grid.
+ *
+ * The table observes the grid and is updated locally when a tile becomes a wall or stops
+ * being one. Horizontal jumps only depend on the three rows around them, and vertical
+ * ones on the three columns around them when diagonal movement is allowed, so the lines
+ * around the tile are recomputed right away. The rest of the directions depend on jumps
+ * through every line, so after a change they are walked tile by tile using the up to
+ * date entries, until the table is saved or rebuilt with update().
+ *
+ * A table can be saved next to the CSV file of its map and loaded back, as long as the
+ * walls and movement settings of the grid haven't changed in between.
+ */
+class JumpPointTable : public JumpPointSearch, public GridGraphObserver
+{
+public:
+    /**
+     * @brief Builds the table for the given grid, which must outlive it.
+     *
+     * If a file is given and it holds a table saved for the same walls and movement
+     * settings, the table is read from it instead.
+     */
+    explicit JumpPointTable(const GridGraph *graph,
+                            const std::string &filename = std::string());
+
+    ~JumpPointTable();
+
+    /**
+     * @brief Rebuilds the bitmaps, the movement rules and the whole table from the grid.
+     */
+    void update() override;
+
+    /**
+     * @brief Writes the table to a binary file, bringing it up to date first.
+     * @throws std::runtime_error if the file can't be written.
+     */
+    void save(const std::string &filename);
+
+    /**
+     * @brief Reads the table from a file written by save().
+     * @return false, leaving the table untouched, if the file can't be read or was saved
+     * for a grid with different walls or movement settings.
+     */
+    bool load(const std::string &filename);
+
+    /**
+     * @return true if the table was read from a file by the constructor.
+     */
+    bool wasLoaded() const;
+
+    /**
+     * @return The name of the file where the table of a CSV map is kept.
+     */
+    static std::string tableFilename(const std::string &mapFilename);
+
+    void tileChanged(Tile tile, double oldCost, double newCost) override;
+    void movementChanged() override;
+
+protected:
+    bool jump(int x, int y, int dx, int dy, Tile goal, Tile &jumpPoint) const override;
+
+private:
+    /**
+     * @return The position of a direction in GridGraph::MASK_DIRS.
+     */
+    static int direction(int dx, int dy);
+
+    /**
+     * @return true if the entries for a direction are kept up to date on every change.
+     */
+    bool isPrimary(int dx, int dy) const;
+
+    /**
+     * @return The position of the entry of an in-bounds tile in the table.
+     */
+    size_t entryIndex(int x, int y, int dx, int dy) const;
+
+    /**
+     * @return The entry of an in-bounds tile, walking the grid if it's out of date.
+     */
+    int entryAt(int x, int y, int dx, int dy) const;
+
+    /**
+     * @return true if a straight scan would stop on a walkable tile reached with the
+     * given move because of a forced neighbor.
+     */
+    bool isForced(int x, int y, int dx, int dy) const;
+
+    /**
+     * @return true if a walkable tile reached with the given move is a jump point when
+     * no goal is taken into account.
+     */
+    bool isJumpPoint(int x, int y, int dx, int dy) const;
+
+    /**
+     * @return The entry of a tile computed from the entry of the tile next to it.
+     */
+    int computeEntry(int x, int y, int dx, int dy) const;
+
+    /**
+     * @return The entry of a tile computed by walking from it tile by tile.
+     */
+    int walk(int x, int y, int dx, int dy) const;
+
+    /**
+     * @brief Computes the entries of a direction for every tile in a rectangle, in an
+     * order where the tile next to each one is always computed first.
+     */
+    void build(int dx, int dy, int fromX, int toX, int fromY, int toY);
+
+    /**
+     * @brief Computes every entry of the table.
+     */
+    void buildEntries();
+
+    /**
+     * @brief Computes the entries of the directions which are walked after a change.
+     */
+    void buildSecondary();
+
+    /**
+     * @return A hash of the walls of the grid, used to check saved tables.
+     */
+    uint64_t wallHash() const;
+
+private:
+    // 8 entries per tile, in row-major order and following MASK_DIRS
+    std::vector<int32_t> entries;
+    // Whether the entries that aren't kept up to date on every change are out of date
+    bool stale;
+    bool loaded;
+};
+
+#endif // JPSPLUS_H
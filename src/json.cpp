@@ -0,0 +1,503 @@
+#include "json.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+
+// Containers are only nested this deep when parsing, so the recursion stays bounded
+static const int MAX_DEPTH = 64;
+
+static void skipWhitespace(const std::string &text, size_t &position)
+{
+    while (position < text.size() && (text[position] == ' ' || text[position] == '\t'
+                                      || text[position] == '\n' || text[position] == '\r'))
+    {
+        ++position;
+    }
+}
+
+static std::runtime_error parseError(const std::string &message, size_t position)
+{
+    return std::runtime_error("Invalid JSON at offset " + std::to_string(position) + ": "
+                              + message);
+}
+
+/**
+ * @brief Appends a code point to a string, encoded as UTF-8.
+ */
+static void appendUtf8(std::string &result, unsigned codePoint)
+{
+    if (codePoint < 0x80)
+    {
+        result += char(codePoint);
+    }
+    else if (codePoint < 0x800)
+    {
+        result += char(0xC0 | (codePoint >> 6));
+        result += char(0x80 | (codePoint & 0x3F));
+    }
+    else if (codePoint < 0x10000)
+    {
+        result += char(0xE0 | (codePoint >> 12));
+        result += char(0x80 | ((codePoint >> 6) & 0x3F));
+        result += char(0x80 | (codePoint & 0x3F));
+    }
+    else
+    {
+        result += char(0xF0 | (codePoint >> 18));
+        result += char(0x80 | ((codePoint >> 12) & 0x3F));
+        result += char(0x80 | ((codePoint >> 6) & 0x3F));
+        result += char(0x80 | (codePoint & 0x3F));
+    }
+}
+
+static unsigned parseHex4(const std::string &text, size_t &position)
+{
+    if (position + 4 > text.size())
+    {
+        throw parseError("truncated escape", position);
+    }
+    unsigned value = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        char digit = text[position++];
+        value <<= 4;
+        if (digit >= '0' && digit <= '9')
+            value |= unsigned(digit - '0');
+        else if (digit >= 'a' && digit <= 'f')
+            value |= unsigned(digit - 'a' + 10);
+        else if (digit >= 'A' && digit <= 'F')
+            value |= unsigned(digit - 'A' + 10);
+        else
+            throw parseError("invalid escape", position - 1);
+    }
+    return value;
+}
+
+static std::string parseString(const std::string &text, size_t &position)
+{
+    // The opening quote has already been checked
+    ++position;
+    std::string result;
+    while (position < text.size() && text[position] != '"')
+    {
+        char c = text[position++];
+        if (c != '\\')
+        {
+            result += c;
+            continue;
+        }
+        if (position >= text.size())
+        {
+            break;
+        }
+        char escape = text[position++];
+        switch (escape)
+        {
+        case '"': result += '"'; break;
+        case '\\': result += '\\'; break;
+        case '/': result += '/'; break;
+        case 'b': result += '\b'; break;
+        case 'f': result += '\f'; break;
+        case 'n': result += '\n'; break;
+        case 'r': result += '\r'; break;
+        case 't': result += '\t'; break;
+        case 'u':
+        {
+            unsigned codePoint = parseHex4(text, position);
+            // Characters outside the basic plane come as a pair of surrogates
+            if (codePoint >= 0xD800 && codePoint < 0xDC00
+                    && text.compare(position, 2, "\\u") == 0)
+            {
+                position += 2;
+                unsigned low = parseHex4(text, position);
+                codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+            }
+            appendUtf8(result, codePoint);
+            break;
+        }
+        default:
+            throw parseError("invalid escape", position - 1);
+        }
+    }
+    if (position >= text.size())
+    {
+        throw parseError("unterminated string", position);
+    }
+    ++position;
+    return result;
+}
+
+static JsonValue parseValue(const std::string &text, size_t &position, int depth)
+{
+    if (depth > MAX_DEPTH)
+    {
+        throw parseError("too deeply nested", position);
+    }
+    skipWhitespace(text, position);
+    if (position >= text.size())
+    {
+        throw parseError("unexpected end", position);
+    }
+    char c = text[position];
+    if (c == '{')
+    {
+        JsonValue result = JsonValue::object();
+        ++position;
+        skipWhitespace(text, position);
+        if (position < text.size() && text[position] == '}')
+        {
+            ++position;
+            return result;
+        }
+        while (true)
+        {
+            skipWhitespace(text, position);
+            if (position >= text.size() || text[position] != '"')
+            {
+                throw parseError("expected a key", position);
+            }
+            std::string key = parseString(text, position);
+            skipWhitespace(text, position);
+            if (position >= text.size() || text[position] != ':')
+            {
+                throw parseError("expected ':'", position);
+            }
+            ++position;
+            result.set(key, parseValue(text, position, depth + 1));
+            skipWhitespace(text, position);
+            if (position < text.size() && text[position] == ',')
+            {
+                ++position;
+                continue;
+            }
+            if (position < text.size() && text[position] == '}')
+            {
+                ++position;
+                return result;
+            }
+            throw parseError("expected ',' or '}'", position);
+        }
+    }
+    if (c == '[')
+    {
+        JsonValue result = JsonValue::array();
+        ++position;
+        skipWhitespace(text, position);
+        if (position < text.size() && text[position] == ']')
+        {
+            ++position;
+            return result;
+        }
+        while (true)
+        {
+            result.push(parseValue(text, position, depth + 1));
+            skipWhitespace(text, position);
+            if (position < text.size() && text[position] == ',')
+            {
+                ++position;
+                continue;
+            }
+            if (position < text.size() && text[position] == ']')
+            {
+                ++position;
+                return result;
+            }
+            throw parseError("expected ',' or ']'", position);
+        }
+    }
+    if (c == '"')
+    {
+        return JsonValue(parseString(text, position));
+    }
+    if (text.compare(position, 4, "true") == 0)
+    {
+        position += 4;
+        return JsonValue(true);
+    }
+    if (text.compare(position, 5, "false") == 0)
+    {
+        position += 5;
+        return JsonValue(false);
+    }
+    if (text.compare(position, 4, "null") == 0)
+    {
+        position += 4;
+        return JsonValue();
+    }
+    const char *begin = text.c_str() + position;
+    char *end;
+    double number = std::strtod(begin, &end);
+    if (end == begin)
+    {
+        throw parseError("unexpected character", position);
+    }
+    position += size_t(end - begin);
+    return JsonValue(number);
+}
+
+static void writeString(std::ostream &stream, const std::string &string)
+{
+    stream << '"';
+    for (char c : string)
+    {
+        switch (c)
+        {
+        case '"': stream << "\\\""; break;
+        case '\\': stream << "\\\\"; break;
+        case '\n': stream << "\\n"; break;
+        case '\r': stream << "\\r"; break;
+        case '\t': stream << "\\t"; break;
+        default:
+            if ((unsigned char)c < 0x20)
+            {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", unsigned(c));
+                stream << escaped;
+            }
+            else
+            {
+                stream << c;
+            }
+        }
+    }
+    stream << '"';
+}
+
+static void writeNumber(std::ostream &stream, double number)
+{
+    // JSON has no infinities nor NaN
+    if (!std::isfinite(number))
+    {
+        stream << "null";
+        return;
+    }
+    // Most values read back the same with 15 digits, which are easier to read, and every
+    // one does with max_digits10
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.15g", number);
+    if (std::strtod(text, nullptr) != number)
+    {
+        std::snprintf(text, sizeof(text), "%.*g", std::numeric_limits<double>::max_digits10,
+                      number);
+    }
+    stream << text;
+}
+
+JsonValue::JsonValue()
+    : type(NUL),
+      boolean(false),
+      number(0)
+{
+}
+
+JsonValue::JsonValue(bool boolean)
+    : type(BOOLEAN),
+      boolean(boolean),
+      number(0)
+{
+}
+
+JsonValue::JsonValue(const char *string)
+    : JsonValue(std::string(string))
+{
+}
+
+JsonValue::JsonValue(const std::string &string)
+    : type(STRING),
+      boolean(false),
+      number(0),
+      string(string)
+{
+}
+
+JsonValue JsonValue::array()
+{
+    JsonValue result;
+    result.type = ARRAY;
+    return result;
+}
+
+JsonValue JsonValue::object()
+{
+    JsonValue result;
+    result.type = OBJECT;
+    return result;
+}
+
+JsonValue JsonValue::parse(const std::string &text)
+{
+    size_t position = 0;
+    JsonValue result = parseValue(text, position, 0);
+    skipWhitespace(text, position);
+    if (position != text.size())
+    {
+        throw parseError("unexpected text after the document", position);
+    }
+    return result;
+}
+
+JsonValue::eType JsonValue::getType() const
+{
+    return type;
+}
+
+bool JsonValue::isNull() const
+{
+    return type == NUL;
+}
+
+void JsonValue::expect(eType expected) const
+{
+    static const char *names[] = {"null", "a boolean", "a number", "a string", "an array",
+                                  "an object"};
+    if (type != expected)
+    {
+        throw std::runtime_error(std::string("Expected ") + names[expected] + " in JSON, got "
+                                 + names[type]);
+    }
+}
+
+bool JsonValue::asBool() const
+{
+    expect(BOOLEAN);
+    return boolean;
+}
+
+double JsonValue::asNumber() const
+{
+    // Infinities and NaN are written as null
+    if (type == NUL)
+    {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    expect(NUMBER);
+    return number;
+}
+
+const std::string &JsonValue::asString() const
+{
+    expect(STRING);
+    return string;
+}
+
+size_t JsonValue::size() const
+{
+    return type == ARRAY ? elements.size() : members.size();
+}
+
+void JsonValue::push(const JsonValue &value)
+{
+    expect(ARRAY);
+    elements.push_back(value);
+}
+
+const JsonValue &JsonValue::operator[](size_t index) const
+{
+    expect(ARRAY);
+    return elements.at(index);
+}
+
+void JsonValue::set(const std::string &key, const JsonValue &value)
+{
+    expect(OBJECT);
+    for (auto &member : members)
+    {
+        if (member.first == key)
+        {
+            member.second = value;
+            return;
+        }
+    }
+    members.push_back(std::make_pair(key, value));
+}
+
+bool JsonValue::has(const std::string &key) const
+{
+    for (const auto &member : members)
+    {
+        if (member.first == key)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+const JsonValue &JsonValue::operator[](const std::string &key) const
+{
+    expect(OBJECT);
+    for (const auto &member : members)
+    {
+        if (member.first == key)
+        {
+            return member.second;
+        }
+    }
+    throw std::runtime_error("Missing JSON member " + key);
+}
+
+void JsonValue::write(std::ostream &stream, int indentation) const
+{
+    const std::string inner(size_t(indentation + 2), ' ');
+    switch (type)
+    {
+    case NUL:
+        stream << "null";
+        break;
+    case BOOLEAN:
+        stream << (boolean ? "true" : "false");
+        break;
+    case NUMBER:
+        writeNumber(stream, number);
+        break;
+    case STRING:
+        writeString(stream, string);
+        break;
+    case ARRAY:
+    {
+        // Arrays of containers get a line for each element, the rest a single line
+        bool nested = false;
+        for (const JsonValue &element : elements)
+        {
+            nested = nested || element.type == ARRAY || element.type == OBJECT;
+        }
+        stream << '[';
+        for (size_t i = 0; i < elements.size(); ++i)
+        {
+            stream << (i > 0 ? "," : "");
+            if (nested)
+            {
+                stream << '\n' << inner;
+            }
+            else if (i > 0)
+            {
+                stream << ' ';
+            }
+            elements[i].write(stream, indentation + 2);
+        }
+        if (nested)
+        {
+            stream << '\n' << std::string(size_t(indentation), ' ');
+        }
+        stream << ']';
+        break;
+    }
+    case OBJECT:
+        stream << '{';
+        for (size_t i = 0; i < members.size(); ++i)
+        {
+            stream << (i > 0 ? "," : "") << '\n' << inner;
+            writeString(stream, members[i].first);
+            stream << ": ";
+            members[i].second.write(stream, indentation + 2);
+        }
+        if (!members.empty())
+        {
+            stream << '\n' << std::string(size_t(indentation), ' ');
+        }
+        stream << '}';
+        break;
+    }
+}
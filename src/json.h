@@ -0,0 +1,117 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief A JSON document, or a part of it, which can be built, written and parsed.
+ *
+ * Numbers are kept as doubles, and the members of an object keep the order they were
+ * added in.
+ */
+class JsonValue
+{
+public:
+    enum eType {NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT};
+
+public:
+    JsonValue();
+    JsonValue(bool boolean);
+    JsonValue(const char *string);
+    JsonValue(const std::string &string);
+
+    template <typename Number,
+              typename = typename std::enable_if<std::is_arithmetic<Number>::value>::type>
+    JsonValue(Number number)
+        : type(NUMBER),
+          boolean(false),
+          number(double(number))
+    {
+    }
+
+    static JsonValue array();
+    static JsonValue object();
+
+    /**
+     * @return An array with every value of a list.
+     */
+    template <typename T>
+    static JsonValue array(const std::vector<T> &values)
+    {
+        JsonValue result = array();
+        for (const T &value : values)
+        {
+            result.push(JsonValue(value));
+        }
+        return result;
+    }
+
+    /**
+     * @brief Parses a JSON document.
+     * @throws std::runtime_error if the text isn't valid JSON.
+     */
+    static JsonValue parse(const std::string &text);
+
+    eType getType() const;
+
+    bool isNull() const;
+
+    /**
+     * @throws std::runtime_error if the value isn't of the type asked for.
+     */
+    bool asBool() const;
+    double asNumber() const;
+    const std::string &asString() const;
+
+    /**
+     * @return The number of elements of an array or members of an object.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Adds an element at the end of an array.
+     */
+    void push(const JsonValue &value);
+
+    /**
+     * @return The element of an array at the given position.
+     * @throws std::out_of_range if there's no such element.
+     */
+    const JsonValue &operator[](size_t index) const;
+
+    /**
+     * @brief Sets a member of an object, adding it at the end if it's new.
+     */
+    void set(const std::string &key, const JsonValue &value);
+
+    bool has(const std::string &key) const;
+
+    /**
+     * @return The member of an object with the given key.
+     * @throws std::runtime_error if there's no such member.
+     */
+    const JsonValue &operator[](const std::string &key) const;
+
+    /**
+     * @brief Writes the value as JSON, with each member of an object on a line of its own
+     * and the arrays of plain values on a single line.
+     */
+    void write(std::ostream &stream, int indentation = 0) const;
+
+private:
+    void expect(eType expected) const;
+
+private:
+    eType type;
+    bool boolean;
+    double number;
+    std::string string;
+    std::vector<JsonValue> elements;
+    std::vector<std::pair<std::string, JsonValue>> members;
+};
+
+#endif // JSON_H
@@ -0,0 +1,463 @@
+#ifndef LANDMARKS_H
+#define LANDMARKS_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "deltastepping.hpp"
+#include "priorityqueues.hpp"
+#include "searchworkspace.hpp"
+
+/**
+ * @brief Distances between every node of a graph and a few landmarks, used as the
+ * heuristic of A* in ALT searches (A*, Landmarks and Triangle inequality).
+ *
+ * For a landmark L, the triangle inequality gives d(v, t) >= d(L, t) - d(L, v) and
+ * d(v, t) >= d(v, L) - d(t, L), so the highest of these bounds over all the landmarks is
+ * an admissible heuristic for any graph, and a much tighter one than straight line
+ * distances on road networks when the landmarks are behind the goal.
+ *
+ * Landmarks are chosen with the farthest strategy: each one is the node farthest from
+ * the ones chosen before, starting from the node farthest from an arbitrary one. The
+ * distances from each landmark are found with a delta-stepping search on all the
+ * threads, and the ones to the landmarks with one-to-all Dijkstra searches on the
+ * reverse graph, one per thread.
+ *
+ * Distances are kept as floats, with the ones of each node next to each other so a
+ * lookup reads a single cache line, and infinity for the nodes which can't reach or be
+ * reached by a landmark. The bounds are lowered by the rounding error of the floats, so
+ * they stay admissible.
+ *
+ * A table can be saved next to the file of its graph and loaded back, as long as the
+ * graph hasn't changed. The graph and its reverse must provide getNodeCount(),
+ * getNodeIndex(node), getNode(index) and forEachNeighbor(node, visit).
+ */
+template <typename Graph, typename ReverseGraph>
+class LandmarkTable
+{
+public:
+    typedef typename Graph::Node Node;
+
+public:
+    /**
+     * @brief Builds a table for the given graph and its reverse, which must outlive it.
+     *
+     * If a file is given and it holds a table saved for the same graph and landmark
+     * count, the table is loaded from it instead of being built. Building runs on the
+     * given number of threads, or on as many as the hardware runs at once if it's 0.
+     */
+    LandmarkTable(const Graph *graph, const ReverseGraph *reverse, int landmarkCount,
+                  const std::string &filename = "", int threadCount = 0)
+        : graph(graph),
+          reverse(reverse),
+          nodeCount(graph->getNodeCount()),
+          landmarkCount(landmarkCount),
+          threadCount(threadCount),
+          maxDistance(0),
+          loaded(false)
+    {
+        if (landmarkCount <= 0)
+        {
+            throw std::invalid_argument("At least one landmark is needed");
+        }
+        if (this->threadCount <= 0)
+        {
+            this->threadCount = std::max(1, int(std::thread::hardware_concurrency()));
+        }
+        loaded = !filename.empty() && load(filename);
+        if (!loaded)
+        {
+            build();
+        }
+    }
+
+    /**
+     * @return true if the table was read from a file instead of being built.
+     */
+    bool wasLoaded() const
+    {
+        return loaded;
+    }
+
+    /**
+     * @return The name of the file where the table of a graph read from the given file
+     * is kept.
+     */
+    static std::string tableFilename(const std::string &graphFilename)
+    {
+        return graphFilename + ".alt";
+    }
+
+    /**
+     * @brief Writes the table to a file.
+     * @throws std::runtime_error if the file can't be written.
+     */
+    void save(const std::string &filename) const
+    {
+        std::ofstream file(filename, std::ios::binary);
+        if (!file)
+        {
+            throw std::runtime_error("Error writing file");
+        }
+        TableHeader header;
+        std::copy(TABLE_MAGIC, TABLE_MAGIC + 4, header.magic);
+        header.version = TABLE_VERSION;
+        header.nodeCount = nodeCount;
+        header.landmarkCount = landmarkCount;
+        header.graphHash = graphHash();
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(landmarks.data()),
+                   landmarks.size() * sizeof(int32_t));
+        file.write(reinterpret_cast<const char*>(distances.data()),
+                   distances.size() * sizeof(float));
+        if (!file)
+        {
+            throw std::runtime_error("Error writing file");
+        }
+    }
+
+    /**
+     * @brief Reads the table from a file written by save().
+     * @return false, leaving the table untouched, if the file can't be read or was saved
+     * for a different graph or landmark count.
+     */
+    bool load(const std::string &filename)
+    {
+        std::ifstream file(filename, std::ios::binary);
+        TableHeader header;
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+        {
+            return false;
+        }
+        if (!std::equal(TABLE_MAGIC, TABLE_MAGIC + 4, header.magic)
+                || header.version != TABLE_VERSION
+                || header.nodeCount != nodeCount
+                || header.landmarkCount != landmarkCount
+                || header.graphHash != graphHash())
+        {
+            return false;
+        }
+        std::vector<int32_t> savedLandmarks(landmarkCount);
+        std::vector<float> savedDistances(size_t(nodeCount) * landmarkCount * 2);
+        if (!file.read(reinterpret_cast<char*>(savedLandmarks.data()),
+                       savedLandmarks.size() * sizeof(int32_t))
+                || !file.read(reinterpret_cast<char*>(savedDistances.data()),
+                              savedDistances.size() * sizeof(float)))
+        {
+            return false;
+        }
+        landmarks.assign(savedLandmarks.begin(), savedLandmarks.end());
+        distances.swap(savedDistances);
+        updateMaxDistance();
+        return true;
+    }
+
+    /**
+     * @return A lower bound of the cost of going from one node to another.
+     */
+    double lowerBound(const Node &from, const Node &to) const
+    {
+        const float *fromRow = row(graph->getNodeIndex(from));
+        const float *toRow = row(graph->getNodeIndex(to));
+        const float infinity = std::numeric_limits<float>::infinity();
+        float bound = 0;
+        for (int i = 0; i < landmarkCount; ++i)
+        {
+            // Landmarks which can't reach or be reached by either node give no bound
+            float reachFrom = fromRow[i], reachTo = toRow[i];
+            if (reachFrom != infinity && reachTo != infinity)
+            {
+                bound = std::max(bound, reachTo - reachFrom);
+            }
+            float leaveFrom = fromRow[landmarkCount + i], leaveTo = toRow[landmarkCount + i];
+            if (leaveFrom != infinity && leaveTo != infinity)
+            {
+                bound = std::max(bound, leaveFrom - leaveTo);
+            }
+        }
+        return std::max(0., double(bound) - roundingError);
+    }
+
+    /**
+     * @return The landmarks, in the order they were chosen.
+     */
+    std::vector<Node> getLandmarks() const
+    {
+        std::vector<Node> result;
+        for (int landmark : landmarks)
+        {
+            result.push_back(graph->getNode(landmark));
+        }
+        return result;
+    }
+
+    /**
+     * @return The memory used by the distances, in bytes.
+     */
+    size_t getMemoryUsage() const
+    {
+        return distances.size() * sizeof(float) + landmarks.size() * sizeof(int);
+    }
+
+private:
+    /**
+     * @brief Header of a saved table, followed by the landmarks and the distances.
+     */
+    typedef struct TableHeader
+    {
+        char magic[4];
+        int32_t version;
+        int32_t nodeCount, landmarkCount;
+        uint64_t graphHash;
+    } TableHeader;
+
+    // Identifies the files written by save, and the version of their layout
+    static constexpr char TABLE_MAGIC[4] = {'A', 'L', 'T', '1'};
+    static const int32_t TABLE_VERSION = 1;
+
+    /**
+     * @return The distances of a node: the ones from each landmark and then the ones to
+     * each landmark.
+     */
+    float *row(int index)
+    {
+        return &distances[size_t(index) * landmarkCount * 2];
+    }
+
+    const float *row(int index) const
+    {
+        return &distances[size_t(index) * landmarkCount * 2];
+    }
+
+    /**
+     * @brief Runs Dijkstra from a node to every other one, calling record(index, cost)
+     * for every node reached.
+     */
+    template <typename SearchGraph, typename Record>
+    static void searchAll(const SearchGraph *searchGraph, int sourceIndex,
+                          SearchWorkspace<SearchGraph> &workspace,
+                          IndexedHeapQueue<SearchGraph> &queue, Record record)
+    {
+        typedef typename SearchGraph::Node SearchNode;
+        SearchNode source = searchGraph->getNode(sourceIndex);
+        workspace.reset();
+        workspace.update(source, source, 0);
+        queue.clear();
+        queue.push(source, 0);
+        while (!queue.empty())
+        {
+            SearchNode current = queue.pop();
+            if (workspace.isClosed(current))
+            {
+                continue;
+            }
+            workspace.close(current);
+            double currentCost = workspace.getCost(current);
+            record(searchGraph->getNodeIndex(current), currentCost);
+            searchGraph->forEachNeighbor(current, [&](SearchNode next, double edgeCost) {
+                double cost = currentCost + edgeCost;
+                if (!workspace.isVisited(next) || cost < workspace.getCost(next))
+                {
+                    workspace.update(next, current, cost);
+                    queue.push(next, cost);
+                }
+            });
+        }
+    }
+
+    /**
+     * @brief Runs f(item, workspace, queue) for every item from 0 to count - 1 on all the
+     * threads, each with its own workspace and queue.
+     */
+    template <typename SearchGraph, typename Function>
+    void parallelFor(const SearchGraph *searchGraph, int count, Function f)
+    {
+        std::atomic<int> next(0);
+        auto work = [&]() {
+            SearchWorkspace<SearchGraph> workspace(searchGraph);
+            IndexedHeapQueue<SearchGraph> queue(searchGraph);
+            for (int item = next++; item < count; item = next++)
+            {
+                f(item, workspace, queue);
+            }
+        };
+        std::vector<std::thread> threads;
+        for (int i = 1; i < std::min(threadCount, count); ++i)
+        {
+            threads.emplace_back(work);
+        }
+        work();
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    /**
+     * @brief Chooses the landmarks and finds the distances from and to each of them.
+     */
+    void build()
+    {
+        const float infinity = std::numeric_limits<float>::infinity();
+        distances.assign(size_t(nodeCount) * landmarkCount * 2, infinity);
+        landmarks.clear();
+        if (nodeCount == 0)
+        {
+            updateMaxDistance();
+            return;
+        }
+
+        // Choosing each landmark needs the distances from the ones before, so the
+        // searches from the landmarks run one after the other, each on all the threads
+        DeltaStepping<Graph> engine(graph, threadCount);
+        auto searchFrom = [&](int source, std::function<void(int, double)> record) {
+            engine.run(graph->getNode(source));
+            for (int index = 0; index < nodeCount; ++index)
+            {
+                Node node = graph->getNode(index);
+                if (engine.isReached(node))
+                {
+                    record(index, engine.getCost(node));
+                }
+            }
+        };
+        // The first landmark is the node farthest from one with edges, so that it's
+        // reached by some edge and not just the node the search started from
+        int seed = 0;
+        while (seed < nodeCount - 1 && !hasNeighbors(seed))
+        {
+            ++seed;
+        }
+        int farthest = seed;
+        double farthestCost = 0;
+        searchFrom(seed, [&](int index, double cost) {
+            if (cost > farthestCost)
+            {
+                farthest = index;
+                farthestCost = cost;
+            }
+        });
+        // Distance from the closest landmark chosen so far to every node
+        std::vector<float> closest(nodeCount, infinity);
+        for (int i = 0; i < landmarkCount; ++i)
+        {
+            landmarks.push_back(farthest);
+            searchFrom(farthest, [&](int index, double cost) {
+                row(index)[i] = float(cost);
+                closest[index] = std::min(closest[index], float(cost));
+            });
+            // The next landmark is the node farthest from all the chosen ones. If every
+            // reachable node is already a landmark, the last one is repeated.
+            float farthestDistance = 0;
+            for (int index = 0; index < nodeCount; ++index)
+            {
+                if (closest[index] != infinity && closest[index] > farthestDistance)
+                {
+                    farthest = index;
+                    farthestDistance = closest[index];
+                }
+            }
+        }
+
+        // The searches to the landmarks are independent
+        parallelFor(reverse, landmarkCount, [&](int i, SearchWorkspace<ReverseGraph> &workspace,
+                                               IndexedHeapQueue<ReverseGraph> &queue) {
+            searchAll(reverse, landmarks[i], workspace, queue, [&](int index, double cost) {
+                row(index)[landmarkCount + i] = float(cost);
+            });
+        });
+        updateMaxDistance();
+    }
+
+    bool hasNeighbors(int index) const
+    {
+        bool result = false;
+        graph->forEachNeighbor(graph->getNode(index), [&result](Node, double) {
+            result = true;
+        });
+        return result;
+    }
+
+    /**
+     * @brief Finds the longest distance in the table, and with it the highest error a
+     * bound can have from rounding the distances to floats.
+     */
+    void updateMaxDistance()
+    {
+        maxDistance = 0;
+        for (float distance : distances)
+        {
+            if (distance != std::numeric_limits<float>::infinity())
+            {
+                maxDistance = std::max(maxDistance, double(distance));
+            }
+        }
+        // Each of the two distances of a bound is off by half a unit in the last place,
+        // doubled to cover the rounding of the costs added up by the searches
+        roundingError = 2 * maxDistance * std::numeric_limits<float>::epsilon();
+    }
+
+    /**
+     * @return A hash of the edges of the graph, used to check saved tables.
+     */
+    uint64_t graphHash() const
+    {
+        // FNV-1a over the targets and costs of the edges of every node
+        uint64_t hash = 14695981039346656037ULL;
+        auto mix = [&hash](uint64_t word) {
+            hash ^= word;
+            hash *= 1099511628211ULL;
+        };
+        for (int index = 0; index < nodeCount; ++index)
+        {
+            graph->forEachNeighbor(graph->getNode(index), [&](Node next, double cost) {
+                mix(uint64_t(graph->getNodeIndex(next)));
+                float weight = float(cost);
+                uint32_t bits;
+                std::copy(reinterpret_cast<const char*>(&weight),
+                          reinterpret_cast<const char*>(&weight) + sizeof(bits),
+                          reinterpret_cast<char*>(&bits));
+                mix(bits);
+            });
+            mix(~uint64_t(0));
+        }
+        return hash;
+    }
+
+private:
+    const Graph *graph;
+    const ReverseGraph *reverse;
+    int nodeCount, landmarkCount, threadCount;
+    std::vector<int> landmarks;  // Node indices
+    // 2 * landmarkCount distances per node, in the order of the node indices
+    std::vector<float> distances;
+    double maxDistance, roundingError;
+    bool loaded;
+};
+
+template <typename Graph, typename ReverseGraph>
+constexpr char LandmarkTable<Graph, ReverseGraph>::TABLE_MAGIC[4];
+
+/**
+ * @brief Lower bound of the distance between two nodes looked up in a LandmarkTable, to
+ * be used as the heuristic of A*.
+ */
+template <typename Graph, typename ReverseGraph>
+struct LandmarkDistance
+{
+    const LandmarkTable<Graph, ReverseGraph> *table;
+
+    double operator()(const typename Graph::Node &a, const typename Graph::Node &b) const
+    {
+        return table->lowerBound(a, b);
+    }
+};
+
+#endif // LANDMARKS_H
@@ -34,14 +34,73 @@ int main(int argc, char *argv[])
             try
             {
                 // Make sure we have the right amount of arguments
-                if (argc != 4)
+                if (argc < 4)
                 {
                     throw std::runtime_error("Incorrect number of arguments.");
                 }
                 std::string filename = argv[2];
                 int count = std::stoi(argv[3]);
                 Benchmark benchmark(filename);
+                int warmup = 0, repetitions = 1;
+                for (int i = 4; i < argc; ++i)
+                {
+                    std::string flag = argv[i];
+                    if (flag == "-p")
+                    {
+                        benchmark.setParallelBidirectional(true);
+                        continue;
+                    }
+                    if (flag == "-c")
+                    {
+                        benchmark.setPerfCounters(true);
+                        continue;
+                    }
+                    // The rest of the flags take a value
+                    if (i + 1 >= argc)
+                    {
+                        throw std::runtime_error("Missing value for " + flag + ".");
+                    }
+                    if (flag == "--algorithms")
+                    {
+                        benchmark.setAlgorithms(argv[++i]);
+                        continue;
+                    }
+                    if (flag == "--compare")
+                    {
+                        benchmark.setBaseline(argv[++i]);
+                        continue;
+                    }
+                    int value = std::stoi(argv[++i]);
+                    if (flag == "-w")
+                    {
+                        warmup = value;
+                    }
+                    else if (flag == "-r")
+                    {
+                        repetitions = value;
+                    }
+                    else if (flag == "-t")
+                    {
+                        benchmark.setThreadCount(value);
+                    }
+                    else if (flag == "-s")
+                    {
+                        benchmark.setSeed(unsigned(value));
+                    }
+                    else
+                    {
+                        throw std::runtime_error("Unknown option " + flag + ".");
+                    }
+                }
+                benchmark.setRepetitions(warmup, repetitions);
                 benchmark.run(count);
+                // So scripts can stop on regressions
+                if (benchmark.getRegressionCount() > 0)
+                {
+                    std::cout << benchmark.getRegressionCount()
+                              << " regressions found comparing with the baseline" << std::endl;
+                    return -3;
+                }
             }
             catch (std::exception &ex)
             {
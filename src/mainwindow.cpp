@@ -5,6 +5,7 @@
 #include <QFileDialog>
 #include "helpdialog.h"
 #include "newmapdialog.h"
+#include "searchengines.h"
 #include "tilemapscene.h"
 #include "utils.h"
 
@@ -23,11 +24,11 @@ MainWindow::MainWindow(QWidget *parent) :
     ui->cbTileType->addItem("Forest", FOREST_COLOR);
     ui->cbTileType->addItem("Water", WATER_COLOR);
     ui->cbTileType->addItem("Custom cost", CUSTOM_WEIGHT_COLOR);
-    // Populate algorithm list
-    ui->cbAlgorithm->addItem("A*");
-    ui->cbAlgorithm->addItem("Dijkstra");
-    ui->cbAlgorithm->addItem("BFS");
-    ui->cbAlgorithm->addItem("Greedy Best-first search");
+    // Populate algorithm list with the ones that can follow the edits to the map
+    for (const std::string &title : gridAlgorithms().getTitles(true))
+    {
+        ui->cbAlgorithm->addItem(QString::fromStdString(title));
+    }
     // Populate heuristic list
     ui->cbHeuristic->addItem("Manhattan distance");
     ui->cbHeuristic->addItem("Euclidean distance");
@@ -84,7 +85,7 @@ void MainWindow::updateSelectedTileType()
 
 void MainWindow::updateSelectedAlgorithm()
 {
-    tilemap->setAlgorithm(ui->cbAlgorithm->currentIndex());
+    tilemap->setAlgorithm(ui->cbAlgorithm->currentText().toStdString());
     tilemap->setHeuristic(ui->cbHeuristic->currentIndex());
 }
 
@@ -115,11 +116,11 @@ void MainWindow::on_cbTileType_currentIndexChanged(int index)
 
 void MainWindow::on_cbAlgorithm_currentIndexChanged(int index)
 {
-    tilemap->setAlgorithm(index);
+    std::string title = ui->cbAlgorithm->itemText(index).toStdString();
+    tilemap->setAlgorithm(title);
     // If the currently selected algorithm doesn't use an heuristic,
     // disable the heuristic combo box
-    // TODO: Use better approach instead of depending on the index
-    ui->cbHeuristic->setEnabled(index == 0 || index == 3);
+    ui->cbHeuristic->setEnabled(gridAlgorithms().usesHeuristic(title));
 }
 
 void MainWindow::on_cbHeuristic_currentIndexChanged(int index)
@@ -0,0 +1,149 @@
+#include "movingai.h"
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+/**
+ * @return The directory part of a path, with its trailing slash, or an empty string.
+ */
+static std::string directoryOf(const std::string &path)
+{
+    size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? "" : path.substr(0, slash + 1);
+}
+
+GridGraph* loadMovingAIMap(const std::string &filename)
+{
+    std::ifstream file(filename);
+    if (!file)
+    {
+        throw std::runtime_error("Error reading map file " + filename);
+    }
+
+    // The header is a list of "key value" lines ending with "map"
+    int width = -1, height = -1;
+    std::string key;
+    while (file >> key && key != "map")
+    {
+        if (key == "type")
+        {
+            std::string type;
+            file >> type;
+            if (type != "octile")
+            {
+                throw std::runtime_error("Unsupported map type " + type);
+            }
+        }
+        else if (key == "height")
+        {
+            file >> height;
+        }
+        else if (key == "width")
+        {
+            file >> width;
+        }
+        else
+        {
+            throw std::runtime_error("Unknown map header field " + key);
+        }
+    }
+    if (key != "map" || width <= 0 || height <= 0)
+    {
+        throw std::runtime_error("Invalid map header in " + filename);
+    }
+
+    // Maps only have walls and floor, so use the compact storage
+    GridGraph *graph = new GridGraph(0, 0, width, height, GridGraph::COMPACT);
+    graph->setDiagonalAllowed(true);
+    graph->setCornerMovementAllowed(false);
+    graph->setDiagonalCostFactor(std::sqrt(2));
+    std::string line;
+    std::getline(file, line);  // Rest of the "map" line
+    for (int y = 0; y < height; ++y)
+    {
+        if (!std::getline(file, line) || int(line.size()) < width)
+        {
+            delete graph;
+            throw std::runtime_error("Map " + filename + " is missing tiles");
+        }
+        for (int x = 0; x < width; ++x)
+        {
+            char terrain = line[x];
+            if (terrain != '.' && terrain != 'G' && terrain != 'S')
+            {
+                graph->setCost(Tile{x, y}, -1);
+            }
+        }
+    }
+    return graph;
+}
+
+std::vector<Scenario> loadMovingAIScenarios(const std::string &filename)
+{
+    std::ifstream file(filename);
+    if (!file)
+    {
+        throw std::runtime_error("Error reading scenario file " + filename);
+    }
+    std::string line;
+    std::getline(file, line);
+    if (line.compare(0, 8, "version ") != 0)
+    {
+        throw std::runtime_error("Missing version in scenario file " + filename);
+    }
+
+    // Each line is: bucket map width height startX startY goalX goalY optimalLength
+    std::vector<Scenario> scenarios;
+    while (std::getline(file, line))
+    {
+        if (line.find_first_not_of(" \t\r") == std::string::npos)
+        {
+            continue;
+        }
+        std::istringstream stream(line);
+        Scenario scenario;
+        if (!(stream >> scenario.bucket >> scenario.mapFilename >> scenario.mapWidth
+              >> scenario.mapHeight >> scenario.start.x >> scenario.start.y
+              >> scenario.goal.x >> scenario.goal.y >> scenario.optimalLength))
+        {
+            throw std::runtime_error("Invalid scenario line: " + line);
+        }
+        scenarios.push_back(scenario);
+    }
+    return scenarios;
+}
+
+void checkScenario(const Scenario &scenario, const GridGraph *map)
+{
+    if (scenario.mapWidth != map->getWidth() || scenario.mapHeight != map->getHeight())
+    {
+        throw std::runtime_error("Scenario made for a " + std::to_string(scenario.mapWidth)
+                                 + "x" + std::to_string(scenario.mapHeight) + " map, but "
+                                 + scenario.mapFilename + " is "
+                                 + std::to_string(map->getWidth()) + "x"
+                                 + std::to_string(map->getHeight()));
+    }
+    for (Tile tile : {scenario.start, scenario.goal})
+    {
+        if (map->isOutOfBounds(tile) || map->isWall(tile))
+        {
+            throw std::runtime_error("Scenario tile (" + std::to_string(tile.x) + ", "
+                                     + std::to_string(tile.y) + ") is out of "
+                                     + scenario.mapFilename + " or a wall");
+        }
+    }
+}
+
+std::string findScenarioMap(const std::string &scenarioFilename, const Scenario &scenario)
+{
+    std::string directory = directoryOf(scenarioFilename);
+    std::string path = directory + scenario.mapFilename;
+    if (std::ifstream(path))
+    {
+        return path;
+    }
+    size_t slash = scenario.mapFilename.find_last_of("/\\");
+    return directory + scenario.mapFilename.substr(slash == std::string::npos ? 0
+                                                                              : slash + 1);
+}
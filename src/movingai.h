@@ -0,0 +1,53 @@
+#ifndef MOVINGAI_H
+#define MOVINGAI_H
+
+#include <string>
+#include <vector>
+#include "gridgraph.h"
+
+/**
+ * @brief A problem of a MovingAI scenario file, with the length of its optimal path.
+ */
+typedef struct Scenario
+{
+    int bucket;
+    std::string mapFilename;  // As written in the scenario file
+    int mapWidth, mapHeight;  // Of the map the scenario was made for
+    Tile start, goal;
+    double optimalLength;
+} Scenario;
+
+/**
+ * @brief Loads a map in the MovingAI .map format.
+ *
+ * The top-left tile of the map is (0, 0), like in the scenarios. Only the '.', 'G' and
+ * 'S' terrains are walkable, and the rest are walls. Moves follow the octile rules of the
+ * benchmarks: diagonal moves are allowed, cost sqrt(2), and can't cut corners.
+ *
+ * @throws std::runtime_error if the file can't be read or isn't a valid map.
+ */
+GridGraph* loadMovingAIMap(const std::string &filename);
+
+/**
+ * @brief Loads the problems of a scenario file in the MovingAI .scen format, in the
+ * order they appear in, which is sorted by bucket.
+ *
+ * @throws std::runtime_error if the file can't be read or isn't a valid scenario.
+ */
+std::vector<Scenario> loadMovingAIScenarios(const std::string &filename);
+
+/**
+ * @brief Checks that a problem of a scenario can be run on a map: that the scenario was
+ * made for a map of its size, and that its start and goal are walkable tiles of it.
+ *
+ * @throws std::runtime_error if it can't.
+ */
+void checkScenario(const Scenario &scenario, const GridGraph *map);
+
+/**
+ * @return The file of the map used by a scenario, which is looked up next to the
+ * scenario file, first by the path written in it and then by its name alone.
+ */
+std::string findScenarioMap(const std::string &scenarioFilename, const Scenario &scenario);
+
+#endif // MOVINGAI_H
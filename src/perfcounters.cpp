@@ -0,0 +1,144 @@
+#include "perfcounters.h"
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+/**
+ * @brief Opens a counting event of the calling thread, on any processor, stopped.
+ * @return Its file descriptor, or -1 if the kernel refused it.
+ */
+static int openEvent(uint32_t type, uint64_t config)
+{
+    perf_event_attr attributes;
+    std::memset(&attributes, 0, sizeof(attributes));
+    attributes.size = sizeof(attributes);
+    attributes.type = type;
+    attributes.config = config;
+    attributes.disabled = 1;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    // Tells how long the event actually counted, if it had to share a hardware counter
+    attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return int(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+}
+#endif
+
+PerfCounters::PerfCounters()
+{
+    descriptors.fill(-1);
+#if defined(__linux__)
+    const uint64_t l1Misses = PERF_COUNT_HW_CACHE_L1D
+            | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+            | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    descriptors[CYCLES] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    descriptors[INSTRUCTIONS] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    descriptors[L1D_MISSES] = openEvent(PERF_TYPE_HW_CACHE, l1Misses);
+    descriptors[LLC_MISSES] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    descriptors[BRANCH_MISSES] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    for (int counter = 0; counter < COUNTER_COUNT; ++counter)
+    {
+        if (descriptors[counter] < 0 && error.empty())
+        {
+            error = std::string(getName(eCounter(counter))) + ": " + std::strerror(errno);
+        }
+    }
+#else
+    error = "performance counters are only supported on Linux";
+#endif
+}
+
+PerfCounters::~PerfCounters()
+{
+#if defined(__linux__)
+    for (int descriptor : descriptors)
+    {
+        if (descriptor >= 0)
+        {
+            close(descriptor);
+        }
+    }
+#endif
+}
+
+bool PerfCounters::isAvailable(eCounter counter) const
+{
+    return descriptors[counter] >= 0;
+}
+
+bool PerfCounters::isAnyAvailable() const
+{
+    for (int descriptor : descriptors)
+    {
+        if (descriptor >= 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string PerfCounters::getError() const
+{
+    return error;
+}
+
+void PerfCounters::start()
+{
+#if defined(__linux__)
+    for (int descriptor : descriptors)
+    {
+        if (descriptor >= 0)
+        {
+            ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+            ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+}
+
+void PerfCounters::stop()
+{
+#if defined(__linux__)
+    for (int descriptor : descriptors)
+    {
+        if (descriptor >= 0)
+        {
+            ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+#endif
+}
+
+PerfCounters::Values PerfCounters::read() const
+{
+    Values values;
+    values.fill(-1);
+#if defined(__linux__)
+    for (int counter = 0; counter < COUNTER_COUNT; ++counter)
+    {
+        // The value, then the time enabled and the time running
+        uint64_t data[3];
+        if (descriptors[counter] < 0
+                || ::read(descriptors[counter], data, sizeof(data)) != sizeof(data))
+        {
+            continue;
+        }
+        values[counter] = data[2] > 0 ? double(data[0]) * data[1] / data[2] : 0;
+    }
+#endif
+    return values;
+}
+
+const char *PerfCounters::getName(eCounter counter)
+{
+    static const char *names[COUNTER_COUNT] = {"Cycles", "Instructions", "L1dMisses",
+                                               "LLCMisses", "BranchMisses"};
+    return names[counter];
+}
@@ -0,0 +1,71 @@
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+#include <array>
+#include <string>
+
+/**
+ * @brief Hardware performance counters of the calling thread, read with perf_event_open.
+ *
+ * Each event is opened on its own, so the ones the kernel or the processor don't allow
+ * are left out and the rest still count. Only user space is counted, and only on the
+ * thread which opened the events, so the threads started by a search aren't. On systems
+ * other than Linux, no event is available.
+ */
+class PerfCounters
+{
+public:
+    enum eCounter {CYCLES, INSTRUCTIONS, L1D_MISSES, LLC_MISSES, BRANCH_MISSES,
+                   COUNTER_COUNT};
+
+    // Value of each counter, or -1 if it isn't available
+    typedef std::array<double, COUNTER_COUNT> Values;
+
+public:
+    /**
+     * @brief Opens the events of the counters, which start stopped.
+     */
+    PerfCounters();
+
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters &operator=(const PerfCounters&) = delete;
+
+    bool isAvailable(eCounter counter) const;
+
+    /**
+     * @return true if at least one of the counters is available.
+     */
+    bool isAnyAvailable() const;
+
+    /**
+     * @return Why the first counter which isn't available couldn't be opened, or an empty
+     * string if all of them are.
+     */
+    std::string getError() const;
+
+    /**
+     * @brief Resets the counters to 0 and starts them.
+     */
+    void start();
+
+    void stop();
+
+    /**
+     * @return What the counters counted between the last start and stop, scaled up if
+     * the kernel had to share the hardware counters with other events meanwhile.
+     */
+    Values read() const;
+
+    /**
+     * @return The name of a counter, as used in the CSV columns, like "Cycles".
+     */
+    static const char *getName(eCounter counter);
+
+private:
+    std::array<int, COUNTER_COUNT> descriptors;  // -1 if the event couldn't be opened
+    std::string error;
+};
+
+#endif // PERFCOUNTERS_H
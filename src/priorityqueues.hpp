@@ -0,0 +1,418 @@
+#ifndef PRIORITYQUEUES_H
+#define PRIORITYQUEUES_H
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Operation counters of a priority queue, reset every time the queue is cleared.
+ */
+typedef struct QueueStats
+{
+    unsigned long pushes, pops, decreaseKeys;
+} QueueStats;
+
+/*
+ * Priority queues used by dijkstra and aStar all have the same interface:
+ *
+ *     void clear();
+ *     bool empty() const;
+ *     void push(const Node &node, double priority);
+ *     Node pop();
+ *     double topPriority() const;
+ *     const QueueStats &getStats() const;
+ *
+ * push either inserts the node or, if the queue supports it and the node is already in
+ * the queue with a higher priority, lowers its priority. pop removes and returns the node
+ * with the lowest priority, and topPriority returns that priority without removing it.
+ */
+
+/**
+ * @brief Binary heap which inserts a new entry every time a node is pushed.
+ *
+ * It doesn't need to know anything about the graph, but outdated entries stay in the
+ * queue until popped, so the caller has to skip them.
+ */
+template <typename Node>
+class BinaryHeapQueue
+{
+public:
+    BinaryHeapQueue()
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        entries = Heap();
+        stats = QueueStats{0, 0, 0};
+    }
+
+    bool empty() const
+    {
+        return entries.empty();
+    }
+
+    void push(const Node &node, double priority)
+    {
+        entries.emplace(priority, node);
+        ++stats.pushes;
+    }
+
+    Node pop()
+    {
+        Node node = entries.top().second;
+        entries.pop();
+        ++stats.pops;
+        return node;
+    }
+
+    double topPriority() const
+    {
+        return entries.top().first;
+    }
+
+    const QueueStats &getStats() const
+    {
+        return stats;
+    }
+
+private:
+    typedef std::pair<double, Node> queuePair;
+    typedef std::priority_queue<queuePair, std::vector<queuePair>,
+            std::greater<queuePair>> Heap;
+
+    Heap entries;
+    QueueStats stats;
+};
+
+/**
+ * @brief d-ary heap which keeps track of the position of every node, so each node is in
+ * the queue at most once and its priority can be lowered in place.
+ *
+ * Works on graphs that number their nodes, like SearchWorkspace. The arity defaults to 4,
+ * which makes the heap shallower than a binary one while keeping the children of a node
+ * in the same cache line.
+ */
+template <typename Graph, int Arity = 4>
+class IndexedHeapQueue
+{
+public:
+    typedef typename Graph::Node Node;
+
+public:
+    /**
+     * @brief Creates an empty queue for nodes of the given graph, which must outlive it.
+     */
+    explicit IndexedHeapQueue(const Graph *graph)
+        : graph(graph),
+          positions(graph->getNodeCount(), NOT_IN_HEAP),
+          stats{0, 0, 0}
+    {
+        static_assert(Arity >= 2, "A heap needs at least two children per node");
+    }
+
+    /**
+     * @brief Removes every node, in time proportional to the nodes still in the queue.
+     */
+    void clear()
+    {
+        for (const Entry &entry : heap)
+        {
+            positions[entry.index] = NOT_IN_HEAP;
+        }
+        heap.clear();
+        stats = QueueStats{0, 0, 0};
+    }
+
+    bool empty() const
+    {
+        return heap.empty();
+    }
+
+    /**
+     * @return The memory used by the heap and the positions of the nodes, in bytes. The
+     * heap keeps the room it needed for the largest search so far.
+     */
+    size_t getMemoryUsage() const
+    {
+        return heap.capacity() * sizeof(Entry) + positions.capacity() * sizeof(int);
+    }
+
+    void push(const Node &node, double priority)
+    {
+        int index = graph->getNodeIndex(node);
+        int position = positions[index];
+        if (position == NOT_IN_HEAP)
+        {
+            heap.push_back(Entry{priority, index});
+            siftUp(int(heap.size()) - 1);
+            ++stats.pushes;
+        }
+        else if (priority < heap[position].priority)
+        {
+            heap[position].priority = priority;
+            siftUp(position);
+            ++stats.decreaseKeys;
+        }
+    }
+
+    Node pop()
+    {
+        int index = heap.front().index;
+        positions[index] = NOT_IN_HEAP;
+        Entry last = heap.back();
+        heap.pop_back();
+        if (!heap.empty())
+        {
+            place(last, 0);
+            siftDown(0);
+        }
+        ++stats.pops;
+        return graph->getNode(index);
+    }
+
+    double topPriority() const
+    {
+        return heap.front().priority;
+    }
+
+    const QueueStats &getStats() const
+    {
+        return stats;
+    }
+
+private:
+    typedef struct Entry
+    {
+        double priority;
+        int index;
+    } Entry;
+
+    enum {NOT_IN_HEAP = -1};
+
+    void place(const Entry &entry, int position)
+    {
+        heap[position] = entry;
+        positions[entry.index] = position;
+    }
+
+    void siftUp(int position)
+    {
+        Entry entry = heap[position];
+        while (position > 0)
+        {
+            int parent = (position - 1) / Arity;
+            if (!(entry.priority < heap[parent].priority))
+            {
+                break;
+            }
+            place(heap[parent], position);
+            position = parent;
+        }
+        place(entry, position);
+    }
+
+    void siftDown(int position)
+    {
+        Entry entry = heap[position];
+        int size = int(heap.size());
+        while (true)
+        {
+            // Find the child with the lowest priority
+            int first = position * Arity + 1;
+            if (first >= size)
+            {
+                break;
+            }
+            int best = first;
+            int last = std::min(first + Arity, size);
+            for (int child = first + 1; child < last; ++child)
+            {
+                if (heap[child].priority < heap[best].priority)
+                {
+                    best = child;
+                }
+            }
+            if (!(heap[best].priority < entry.priority))
+            {
+                break;
+            }
+            place(heap[best], position);
+            position = best;
+        }
+        place(entry, position);
+    }
+
+private:
+    const Graph *graph;
+    std::vector<Entry> heap;
+    std::vector<int> positions;  // Position of each node in the heap, if it's in it
+    QueueStats stats;
+};
+
+/**
+ * @brief Monotone bucket queue for integral priorities, as used by Dial's algorithm.
+ *
+ * Nodes are kept in a circular array of buckets, one per priority, so pushing and popping
+ * take constant time, plus a scan over the empty buckets that separate two priorities.
+ * It only works if priorities are non-negative integers, are never lower than the last
+ * popped one, and never exceed it by more than the spread given on construction. That is
+ * the case for dijkstra on graphs with integral edge costs up to the spread, and for aStar
+ * if the heuristic is integral too and changes by at most one per move, like the
+ * Manhattan distance on a 4-connected grid, in which case the spread must be one more.
+ *
+ * Like BinaryHeapQueue, outdated entries stay in the queue until popped.
+ */
+template <typename Node>
+class BucketQueue
+{
+public:
+    /**
+     * @brief Creates an empty queue for priorities which never exceed the lowest one in
+     * the queue by more than maxSpread.
+     * @throws std::invalid_argument if maxSpread is negative.
+     */
+    explicit BucketQueue(int maxSpread)
+        : buckets(getBucketCount(maxSpread))
+    {
+        clear();
+    }
+
+    /**
+     * @brief Removes every node, in time proportional to the number of buckets.
+     */
+    void clear()
+    {
+        for (std::vector<Node> &bucket : buckets)
+        {
+            bucket.clear();
+        }
+        size = 0;
+        current = -1;
+        stats = QueueStats{0, 0, 0};
+    }
+
+    bool empty() const
+    {
+        return size == 0;
+    }
+
+    int getMaxSpread() const
+    {
+        return int(buckets.size()) - 1;
+    }
+
+    /**
+     * @brief Makes the queue hold priorities up to maxSpread over the lowest one. The
+     * buckets are kept if there are enough, unless there are more than twice as many as
+     * needed, as clearing takes time proportional to them. If they change, the queue is
+     * emptied.
+     * @throws std::invalid_argument if maxSpread is negative.
+     */
+    void reserveSpread(int maxSpread)
+    {
+        size_t count = getBucketCount(maxSpread);
+        if (buckets.size() < count || buckets.size() > 2 * count)
+        {
+            buckets.resize(count);
+            clear();
+        }
+    }
+
+    /**
+     * @return The memory used by the buckets, in bytes. Each bucket keeps the room it
+     * needed for the largest search so far.
+     */
+    size_t getMemoryUsage() const
+    {
+        size_t bytes = buckets.capacity() * sizeof(std::vector<Node>);
+        for (const std::vector<Node> &bucket : buckets)
+        {
+            bytes += bucket.capacity() * sizeof(Node);
+        }
+        return bytes;
+    }
+
+    /**
+     * @throws std::invalid_argument if the priority isn't an integer in the range the
+     * queue can hold.
+     */
+    void push(const Node &node, double priority)
+    {
+        long key = long(priority);
+        if (double(key) != priority || key < 0)
+        {
+            throw std::invalid_argument("Bucket queue priorities must be non-negative integers");
+        }
+        if (current < 0)
+        {
+            // First push since the queue was cleared
+            current = key;
+        }
+        if (key < current || key - current >= long(buckets.size()))
+        {
+            throw std::invalid_argument("Priority out of the range of the bucket queue");
+        }
+        buckets[key % buckets.size()].push_back(node);
+        ++size;
+        ++stats.pushes;
+    }
+
+    Node pop()
+    {
+        // Advance to the next non-empty bucket, which holds the lowest priority
+        std::vector<Node> *bucket = &buckets[current % buckets.size()];
+        while (bucket->empty())
+        {
+            ++current;
+            bucket = &buckets[current % buckets.size()];
+        }
+        Node node = bucket->back();
+        bucket->pop_back();
+        --size;
+        ++stats.pops;
+        return node;
+    }
+
+    double topPriority() const
+    {
+        long priority = current;
+        while (buckets[priority % buckets.size()].empty())
+        {
+            ++priority;
+        }
+        return double(priority);
+    }
+
+    const QueueStats &getStats() const
+    {
+        return stats;
+    }
+
+private:
+    /**
+     * @return The buckets needed for the given spread, checked before they're allocated.
+     */
+    static size_t getBucketCount(int maxSpread)
+    {
+        if (maxSpread < 0)
+        {
+            throw std::invalid_argument("The spread of a bucket queue can't be negative");
+        }
+        return size_t(maxSpread) + 1;
+    }
+
+private:
+    std::vector<std::vector<Node>> buckets;
+    size_t size;
+    long current;  // Priority where the next pop starts looking, or -1 if nothing was pushed
+    QueueStats stats;
+};
+
+#endif // PRIORITYQUEUES_H
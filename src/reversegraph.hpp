@@ -0,0 +1,69 @@
+#ifndef REVERSEGRAPH_H
+#define REVERSEGRAPH_H
+
+#include <vector>
+#include "gridgraph.h"
+
+/**
+ * @brief Read-only view of a GridGraph with every edge reversed.
+ *
+ * Moving to a tile costs the cost of that tile, so in the reversed graph going from a
+ * tile to one of its neighbors costs the cost of the tile being left. The neighbors are
+ * the same ones as in the grid, since movement between walkable tiles is symmetric.
+ *
+ * Tiles are numbered like in the grid, so workspaces and queues can be shared between
+ * both directions. CSRGraph and SimpleGraph have no such view, as their edges are
+ * arbitrary, and build a reversed copy instead.
+ */
+class ReverseGridGraph : public Graph<Tile>
+{
+public:
+    /**
+     * @brief Creates a view of the given grid, which must outlive it.
+     */
+    explicit ReverseGridGraph(const GridGraph *graph) : Graph<Tile>(), graph(graph) {}
+
+    /**
+     * @return The tiles which can reach the given tile in a single move.
+     */
+    std::vector<Tile> neighbors(Tile tile)
+    {
+        std::vector<Tile> result;
+        forEachNeighbor(tile, [&result](Tile next, double) {
+            result.push_back(next);
+        });
+        return result;
+    }
+
+    /**
+     * @brief Calls visit(neighbor, cost) for every tile which can reach the given tile in
+     * a single move, where cost is the cost of that move.
+     */
+    template <typename Visitor>
+    void forEachNeighbor(Tile tile, Visitor visit) const
+    {
+        graph->forEachNeighbor(tile, [&](Tile next, double) {
+            visit(next, graph->getMoveCost(next, tile));
+        });
+    }
+
+    int getNodeCount() const
+    {
+        return graph->getNodeCount();
+    }
+
+    int getNodeIndex(Tile tile) const
+    {
+        return graph->getNodeIndex(tile);
+    }
+
+    Tile getNode(int nodeIndex) const
+    {
+        return graph->getNode(nodeIndex);
+    }
+
+private:
+    const GridGraph *graph;
+};
+
+#endif // REVERSEGRAPH_H
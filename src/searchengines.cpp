@@ -0,0 +1,975 @@
+#include "searchengines.h"
+#include <iostream>
+#include <sstream>
+#include "algorithms.hpp"
+#include "bidirectional.hpp"
+#include "incremental.hpp"
+#include "jps.h"
+
+// Landmarks of the ALT searches. Each one takes two floats per node, so the grid, which
+// has many more nodes than the road networks, gets fewer.
+static const int GRID_LANDMARK_COUNT = 8;
+static const int ROAD_LANDMARK_COUNT = 16;
+
+/**
+ * @return The cost of moving from a node to a neighbor.
+ */
+static double edgeCost(const GridGraph *graph, Tile from, Tile to)
+{
+    return graph->getMoveCost(from, to);
+}
+
+static double edgeCost(const GeolocationGraph *graph, int from, int to)
+{
+    return graph->getCost(to, from);
+}
+
+/**
+ * @return The cost to reach each node of a path, adding up its edges in order.
+ */
+template <typename Graph>
+std::map<typename Graph::Node, double> pathCosts(const Graph *graph,
+                                                 const std::vector<typename Graph::Node> &path)
+{
+    std::map<typename Graph::Node, double> costs;
+    double cost = 0;
+    for (size_t i = 0; i < path.size(); ++i)
+    {
+        if (i > 0)
+        {
+            cost += edgeCost(graph, path[i - 1], path[i]);
+        }
+        costs[path[i]] = cost;
+    }
+    return costs;
+}
+
+/**
+ * @return The bucket queue A* with a heuristic can use, if any. Its priorities are
+ * integral for Dijkstra, which needs a bucket per tile cost, and for the Manhattan
+ * distance on a 4-connected grid, which changes by one on every move and so needs one
+ * more. Other heuristics aren't integral, or aren't consistent on the grid.
+ */
+static BucketQueue<Tile> *bucketQueueOf(GridSearchContext &context, ZeroDistance)
+{
+    return context.getBucketQueue(0);
+}
+
+static BucketQueue<Tile> *bucketQueueOf(GridSearchContext &context, ManhattanDistance)
+{
+    return context.getGraph()->isDiagonalAllowed() ? nullptr : context.getBucketQueue(1);
+}
+
+template <typename HeuristicFunction>
+static BucketQueue<Tile> *bucketQueueOf(GridSearchContext &, HeuristicFunction)
+{
+    return nullptr;
+}
+
+template <typename HeuristicFunction>
+static BucketQueue<int> *bucketQueueOf(RoadSearchContext &, HeuristicFunction)
+{
+    return nullptr;
+}
+
+/**
+ * @brief Base of the engines which search with the workspace of the context, whose
+ * results are only valid until another engine of the context runs.
+ */
+template <typename Context>
+class WorkspaceEngine : public SearchEngine<typename Context::Graph>
+{
+public:
+    typedef typename Context::Graph Graph;
+    typedef typename Graph::Node Node;
+
+public:
+    explicit WorkspaceEngine(Context &context)
+        : context(context),
+          start(),
+          goal()
+    {
+    }
+
+    double getCost() const override
+    {
+        const SearchWorkspace<Graph> &workspace = context.getWorkspace();
+        return workspace.isVisited(goal) ? workspace.getCost(goal) : -1;
+    }
+
+    std::vector<Node> getPath() const override
+    {
+        if (getCost() < 0)
+        {
+            return std::vector<Node>();
+        }
+        return reconstructPath(start, goal, context.getWorkspace());
+    }
+
+    std::map<Node, double> getCosts() const override
+    {
+        const SearchWorkspace<Graph> &workspace = context.getWorkspace();
+        const Graph *graph = context.getGraph();
+        std::map<Node, double> costs;
+        for (int index = 0; index < graph->getNodeCount(); ++index)
+        {
+            Node node = graph->getNode(index);
+            if (workspace.isVisited(node))
+            {
+                costs[node] = workspace.getCost(node);
+            }
+        }
+        return costs;
+    }
+
+protected:
+    Context &context;
+    Node start, goal;
+};
+
+/**
+ * @brief Dijkstra, or A* with a heuristic, on a bucket queue if the costs allow it.
+ */
+template <typename Context, typename HeuristicFunction>
+class AStarEngine : public WorkspaceEngine<Context>
+{
+public:
+    typedef typename Context::Graph Graph;
+    typedef typename Graph::Node Node;
+
+public:
+    AStarEngine(Context &context, HeuristicFunction heuristic)
+        : WorkspaceEngine<Context>(context),
+          heuristic(heuristic),
+          stats(nullptr)
+    {
+    }
+
+    unsigned long search(Node start, Node goal) override
+    {
+        this->start = start;
+        this->goal = goal;
+        Graph *graph = this->context.getGraph();
+        SearchWorkspace<Graph> &workspace = this->context.getWorkspace();
+        auto *buckets = bucketQueueOf(this->context, heuristic);
+        if (buckets)
+        {
+            stats = &buckets->getStats();
+            return aStar(graph, start, goal, workspace, *buckets, heuristic);
+        }
+        IndexedHeapQueue<Graph> &queue = this->context.getQueue();
+        stats = &queue.getStats();
+        return aStar(graph, start, goal, workspace, queue, heuristic);
+    }
+
+    const QueueStats *getQueueStats() const override
+    {
+        return stats;
+    }
+
+private:
+    HeuristicFunction heuristic;
+    const QueueStats *stats;
+};
+
+template <typename Context>
+class BreadthFirstEngine : public WorkspaceEngine<Context>
+{
+public:
+    typedef typename Context::Graph::Node Node;
+
+public:
+    explicit BreadthFirstEngine(Context &context)
+        : WorkspaceEngine<Context>(context)
+    {
+    }
+
+    unsigned long search(Node start, Node goal) override
+    {
+        this->start = start;
+        this->goal = goal;
+        return bfs(this->context.getGraph(), start, goal, this->context.getWorkspace());
+    }
+};
+
+template <typename Context, typename HeuristicFunction>
+class GreedyEngine : public WorkspaceEngine<Context>
+{
+public:
+    typedef typename Context::Graph::Node Node;
+
+public:
+    GreedyEngine(Context &context, HeuristicFunction heuristic)
+        : WorkspaceEngine<Context>(context),
+          heuristic(heuristic)
+    {
+    }
+
+    unsigned long search(Node start, Node goal) override
+    {
+        this->start = start;
+        this->goal = goal;
+        return greedyBestFirstSearch(this->context.getGraph(), start, goal,
+                                     this->context.getWorkspace(), heuristic);
+    }
+
+private:
+    HeuristicFunction heuristic;
+};
+
+/**
+ * @brief A* with the landmark distances of the context.
+ */
+template <typename Context>
+class LandmarkEngine : public WorkspaceEngine<Context>
+{
+public:
+    typedef typename Context::Graph Graph;
+    typedef typename Context::ReverseGraph ReverseGraph;
+    typedef typename Graph::Node Node;
+
+public:
+    explicit LandmarkEngine(Context &context)
+        : WorkspaceEngine<Context>(context),
+          landmarks(context.getLandmarks())
+    {
+    }
+
+    unsigned long search(Node start, Node goal) override
+    {
+        this->start = start;
+        this->goal = goal;
+        IndexedHeapQueue<Graph> &queue = this->context.getQueue();
+        stats = &queue.getStats();
+        return aStar(this->context.getGraph(), start, goal, this->context.getWorkspace(),
+                     queue, LandmarkDistance<Graph, ReverseGraph>{landmarks});
+    }
+
+    const QueueStats *getQueueStats() const override
+    {
+        return stats;
+    }
+
+    size_t getMemoryUsage() const override
+    {
+        return landmarks->getMemoryUsage();
+    }
+
+private:
+    const LandmarkTable<Graph, ReverseGraph> *landmarks;
+    const QueueStats *stats = nullptr;
+};
+
+/**
+ * @brief Bidirectional Dijkstra, or bidirectional A* with a heuristic, with workspaces of
+ * its own.
+ */
+template <typename Context, typename HeuristicFunction>
+class BidirectionalEngine : public SearchEngine<typename Context::Graph>
+{
+public:
+    typedef typename Context::Graph Graph;
+    typedef typename Context::ReverseGraph ReverseGraph;
+    typedef typename Graph::Node Node;
+
+public:
+    BidirectionalEngine(Context &context, HeuristicFunction heuristic)
+        : graph(context.getGraph()),
+          bidirectional(context.getGraph(), context.getReverseGraph()),
+          heuristic(heuristic)
+    {
+        bidirectional.setParallel(context.isParallelBidirectional());
+    }
+
+    unsigned long search(Node start, Node goal) override
+    {
+        return bidirectional.aStar(start, goal, heuristic);
+    }
+
+    double getCost() const override
+    {
+        return bidirectional.getCost();
+    }
+
+    std::vector<Node> getPath() const override
+    {
+        return getCost() < 0 ? std::vector<Node>() : bidirectional.getPath();
+    }
+
+    std::map<Node, double> getCosts() const override
+    {
+        return pathCosts(graph, getPath());
+    }
+
+private:
+    const Graph *graph;
+    BidirectionalSearch<Graph, ReverseGraph> bidirectional;
+    HeuristicFunction heuristic;
+};
+
+/**
+ * @brief Jump Point Search, with the JPS+ table of the context or with plain jumps.
+ *
+ * Plain jumps scan a bitmap of the walls, which is brought up to date before the first
+ * search after the grid changes.
+ */
+template <typename HeuristicFunction>
+class JumpPointEngine : public WorkspaceEngine<GridSearchContext>, public GridGraphObserver
+{
+public:
+    JumpPointEngine(GridSearchContext &context, HeuristicFunction heuristic, bool precomputed)
+        : WorkspaceEngine<GridSearchContext>(context),
+          heuristic(heuristic),
+          table(precomputed ? context.getJumpPointTable() : nullptr),
+          generator(context.getGraph()),
+          stale(false)
+    {
+        context.getGraph()->addObserver(this);
+    }
+
+    ~JumpPointEngine()
+    {
+        context.getGraph()->removeObserver(this);
+    }
+
+    unsigned long search(Tile start, Tile goal) override
+    {
+        this->start = start;
+        this->goal = goal;
+        if (!table && stale)
+        {
+            generator.update();
+            stale = false;
+        }
+        IndexedHeapQueue<GridGraph> &queue = context.getQueue();
+        stats = &queue.getStats();
+        if (table)
+        {
+            return jumpPointSearch(context.getGraph(), *table, start, goal,
+                                   context.getWorkspace(), queue, heuristic);
+        }
+        return jumpPointSearch(context.getGraph(), generator, start, goal,
+                               context.getWorkspace(), queue, heuristic);
+    }
+
+    /**
+     * @brief The search only keeps the jump points, so the path is expanded.
+     */
+    std::vector<Tile> getPath() const override
+    {
+        std::vector<Tile> path = WorkspaceEngine<GridSearchContext>::getPath();
+        return path.empty() ? path : expandJumpPath(path);
+    }
+
+    const QueueStats *getQueueStats() const override
+    {
+        return stats;
+    }
+
+    std::string describe() override
+    {
+        const JumpPointSearch *jumps = table ? table : &generator;
+        return jumps->canSearch() ? "" : "the grid doesn't have uniform costs, so it runs A*";
+    }
+
+    void tileChanged(Tile, double oldCost, double newCost) override
+    {
+        stale = stale || (oldCost < 0) != (newCost < 0);
+    }
+
+    void movementChanged() override
+    {
+        stale = true;
+    }
+
+private:
+    HeuristicFunction heuristic;
+    JumpPointTable *table;  // Only for JPS+
+    JumpPointSearch generator;
+    bool stale;
+    const QueueStats *stats = nullptr;
+};
+
+/**
+ * @brief HPA* with the abstract graph of the context, including the refinement of the
+ * whole path.
+ */
+template <typename HeuristicFunction>
+class HierarchicalEngine : public SearchEngine<GridGraph>
+{
+public:
+    HierarchicalEngine(GridSearchContext &context, HeuristicFunction heuristic)
+        : graph(context.getGraph()),
+          hierarchical(context.getHierarchicalSearch()),
+          heuristic(heuristic)
+    {
+    }
+
+    unsigned long search(Tile start, Tile goal) override
+    {
+        unsigned long expandedNodes = hierarchical->aStar(start, goal, heuristic);
+        path.clear();
+        if (hierarchical->getCost() >= 0)
+        {
+            path = hierarchical->getPath();
+        }
+        return expandedNodes;
+    }
+
+    double getCost() const override
+    {
+        return hierarchical->getCost();
+    }
+
+    std::vector<Tile> getPath() const override
+    {
+        return path;
+    }
+
+    std::map<Tile, double> getCosts() const override
+    {
+        return pathCosts(graph, path);
+    }
+
+    std::string describe() override
+    {
+        return std::to_string(hierarchical->getEntranceCount()) + " entrances";
+    }
+
+private:
+    const GridGraph *graph;
+    HierarchicalSearch *hierarchical;
+    HeuristicFunction heuristic;
+    std::vector<Tile> path;
+};
+
+/**
+ * @return true if no move on the grid costs less than a heuristic can drop over it, which
+ * is by straightStep on a straight move and by diagonalStep on a diagonal one. Moves cost
+ * at least the lowest tile cost, times the diagonal cost factor if they're diagonal.
+ */
+static bool movesCostAtLeast(const GridGraph *graph, double straightStep,
+                             double diagonalStep)
+{
+    double minCost = graph->getMinCost();
+    if (graph->isDiagonalAllowed()
+            && minCost * graph->getDiagonalCostFactor() < diagonalStep)
+    {
+        return false;
+    }
+    return minCost >= straightStep;
+}
+
+/**
+ * @return true if a heuristic is consistent on the grid with its current costs and
+ * movement settings. Heuristics not listed here aren't trusted to be.
+ */
+static bool isConsistentOn(const GridGraph *graph, ManhattanDistance)
+{
+    return movesCostAtLeast(graph, 1, 2);
+}
+
+static bool isConsistentOn(const GridGraph *graph, EuclideanDistance)
+{
+    return movesCostAtLeast(graph, 1, std::sqrt(2));
+}
+
+static bool isConsistentOn(const GridGraph *graph, ChebyshevDistance)
+{
+    return movesCostAtLeast(graph, 1, 1);
+}
+
+static bool isConsistentOn(const GridGraph *graph, OctileDistance)
+{
+    return movesCostAtLeast(graph, 1, std::sqrt(2));
+}
+
+template <typename HeuristicFunction>
+static bool isConsistentOn(const GridGraph *, HeuristicFunction)
+{
+    return false;
+}
+
+/**
+ * @brief LPA*, which repairs its last search after the grid changes, as long as the
+ * start and goal stay the same.
+ *
+ * LPA* only finds the best path with a consistent heuristic, and repairs can even leave
+ * it with a cost below the best one otherwise. While the heuristic isn't consistent for
+ * the costs and movement settings of the grid, the searches run without one instead.
+ */
+template <typename HeuristicFunction>
+class IncrementalEngine : public SearchEngine<GridGraph>
+{
+public:
+    IncrementalEngine(GridSearchContext &context, HeuristicFunction heuristic)
+        : graph(context.getGraph()),
+          heuristic(heuristic),
+          informed(graph, heuristic),
+          uninformed(graph, ZeroDistance()),
+          useHeuristic(true)
+    {
+    }
+
+    unsigned long search(Tile start, Tile goal) override
+    {
+        bool consistent = isConsistentOn(graph, heuristic);
+        if (consistent != useHeuristic)
+        {
+            // The search of the other planner is outdated now
+            useHeuristic = consistent;
+            informed.reset();
+            uninformed.reset();
+        }
+        return useHeuristic ? informed.search(start, goal) : uninformed.search(start, goal);
+    }
+
+    double getCost() const override
+    {
+        return useHeuristic ? informed.getCost() : uninformed.getCost();
+    }
+
+    std::vector<Tile> getPath() const override
+    {
+        return useHeuristic ? informed.getPath() : uninformed.getPath();
+    }
+
+    std::map<Tile, double> getCosts() const override
+    {
+        return useHeuristic ? informed.getCosts() : uninformed.getCosts();
+    }
+
+private:
+    const GridGraph *graph;
+    HeuristicFunction heuristic;
+    IncrementalSearch<HeuristicFunction> informed;
+    IncrementalSearch<ZeroDistance> uninformed;
+    bool useHeuristic;  // Whether the last search ran with the heuristic
+};
+
+/**
+ * @brief Contraction Hierarchies query with the hierarchy of the context, including the
+ * unpacking of the path.
+ *
+ * The cost is added up along the unpacked path, in the same order as the other searches
+ * do, so it matches theirs exactly.
+ */
+class ContractionEngine : public SearchEngine<GeolocationGraph>
+{
+public:
+    explicit ContractionEngine(RoadSearchContext &context)
+        : graph(context.getGraph()),
+          hierarchy(context.getContractionHierarchy()),
+          cost(-1)
+    {
+    }
+
+    unsigned long search(int start, int goal) override
+    {
+        unsigned long expandedNodes = hierarchy->query(start, goal);
+        path.clear();
+        cost = -1;
+        if (hierarchy->getCost() >= 0)
+        {
+            path = hierarchy->getPath();
+            cost = 0;
+            for (size_t i = 1; i < path.size(); ++i)
+            {
+                cost += graph->getCost(path[i], path[i - 1]);
+            }
+        }
+        return expandedNodes;
+    }
+
+    double getCost() const override
+    {
+        return cost;
+    }
+
+    std::vector<int> getPath() const override
+    {
+        return path;
+    }
+
+    std::map<int, double> getCosts() const override
+    {
+        return pathCosts(graph, path);
+    }
+
+    size_t getMemoryUsage() const override
+    {
+        return hierarchy->getMemoryUsage();
+    }
+
+    std::string describe() override
+    {
+        return std::to_string(hierarchy->getShortcutCount()) + " shortcuts";
+    }
+
+private:
+    const GeolocationGraph *graph;
+    ContractionHierarchy *hierarchy;
+    double cost;
+    std::vector<int> path;
+};
+
+template <typename HeuristicFunction>
+using GridAStarEngine = AStarEngine<GridSearchContext, HeuristicFunction>;
+
+template <typename HeuristicFunction>
+using GridGreedyEngine = GreedyEngine<GridSearchContext, HeuristicFunction>;
+
+template <typename HeuristicFunction>
+using GridBidirectionalEngine = BidirectionalEngine<GridSearchContext, HeuristicFunction>;
+
+template <typename HeuristicFunction>
+class GridJumpPointEngine : public JumpPointEngine<HeuristicFunction>
+{
+public:
+    GridJumpPointEngine(GridSearchContext &context, HeuristicFunction heuristic)
+        : JumpPointEngine<HeuristicFunction>(context, heuristic, false)
+    {
+    }
+};
+
+template <typename HeuristicFunction>
+class GridJumpPointTableEngine : public JumpPointEngine<HeuristicFunction>
+{
+public:
+    GridJumpPointTableEngine(GridSearchContext &context, HeuristicFunction heuristic)
+        : JumpPointEngine<HeuristicFunction>(context, heuristic, true)
+    {
+    }
+};
+
+template <typename HeuristicFunction>
+using RoadAStarEngine = AStarEngine<RoadSearchContext, HeuristicFunction>;
+
+template <typename HeuristicFunction>
+using RoadGreedyEngine = GreedyEngine<RoadSearchContext, HeuristicFunction>;
+
+template <typename HeuristicFunction>
+using RoadBidirectionalEngine = BidirectionalEngine<RoadSearchContext, HeuristicFunction>;
+
+/**
+ * @brief Registers an algorithm once for each heuristic of the grid, as name-heuristic.
+ */
+template <template <typename> class Engine>
+static void addWithGridHeuristics(AlgorithmRegistry<GridSearchContext> &registry,
+                                  const std::string &name, const std::string &title,
+                                  bool exact, bool interactive)
+{
+    typedef SearchEngine<GridGraph> *Created;
+    registry.add(name + "-manhattan", title, "manhattan", exact, interactive,
+                 [](GridSearchContext &context) -> Created {
+        return new Engine<ManhattanDistance>(context, ManhattanDistance());
+    });
+    registry.add(name + "-euclidean", title, "euclidean", exact, interactive,
+                 [](GridSearchContext &context) -> Created {
+        return new Engine<EuclideanDistance>(context, EuclideanDistance());
+    });
+    registry.add(name + "-chebyshev", title, "chebyshev", exact, interactive,
+                 [](GridSearchContext &context) -> Created {
+        return new Engine<ChebyshevDistance>(context, ChebyshevDistance());
+    });
+    registry.add(name + "-octile", title, "octile", exact, interactive,
+                 [](GridSearchContext &context) -> Created {
+        return new Engine<OctileDistance>(context, OctileDistance());
+    });
+}
+
+/**
+ * @brief Registers an algorithm once for each heuristic of the road networks, as
+ * name-heuristic.
+ */
+template <template <typename> class Engine>
+static void addWithRoadHeuristics(AlgorithmRegistry<RoadSearchContext> &registry,
+                                  const std::string &name, const std::string &title,
+                                  bool exact)
+{
+    typedef SearchEngine<GeolocationGraph> *Created;
+    registry.add(name + "-linear", title, "linear", exact, false,
+                 [](RoadSearchContext &context) -> Created {
+        return new Engine<LinearDistance3D>(
+                    context, LinearDistance3D{context.getGeolocations()});
+    });
+    registry.add(name + "-haversine", title, "haversine", exact, false,
+                 [](RoadSearchContext &context) -> Created {
+        return new Engine<HaversineDistance>(
+                    context, HaversineDistance{context.getGeolocations()});
+    });
+}
+
+/**
+ * @brief Registers the built-in algorithms of the grid, in the order they are offered.
+ */
+static AlgorithmRegistry<GridSearchContext> createGridAlgorithms()
+{
+    typedef SearchEngine<GridGraph> *Created;
+    AlgorithmRegistry<GridSearchContext> registry;
+    addWithGridHeuristics<GridAStarEngine>(registry, "astar", "A*", true, true);
+    registry.add("dijkstra", "Dijkstra", "", true, true, [](GridSearchContext &context) -> Created {
+        return new AStarEngine<GridSearchContext, ZeroDistance>(context, ZeroDistance());
+    });
+    registry.add("bfs", "BFS", "", false, true, [](GridSearchContext &context) -> Created {
+        return new BreadthFirstEngine<GridSearchContext>(context);
+    });
+    addWithGridHeuristics<GridGreedyEngine>(registry, "greedy", "Greedy Best-first search",
+                                            false, true);
+    addWithGridHeuristics<GridJumpPointEngine>(registry, "jps", "Jump Point Search",
+                                               true, true);
+    addWithGridHeuristics<GridJumpPointTableEngine>(registry, "jpsplus",
+                                                    "Jump Point Search+", true, true);
+    addWithGridHeuristics<HierarchicalEngine>(registry, "hpa", "HPA*", false, true);
+    addWithGridHeuristics<IncrementalEngine>(registry, "lpa", "LPA*", true, true);
+    registry.add("bidijkstra", "Bidirectional Dijkstra", "", true, true,
+                 [](GridSearchContext &context) -> Created {
+        return new BidirectionalEngine<GridSearchContext, ZeroDistance>(context,
+                                                                        ZeroDistance());
+    });
+    addWithGridHeuristics<GridBidirectionalEngine>(registry, "biastar", "Bidirectional A*",
+                                                   true, true);
+    registry.add("alt", "ALT", "", true, false, [](GridSearchContext &context) -> Created {
+        return new LandmarkEngine<GridSearchContext>(context);
+    });
+    return registry;
+}
+
+/**
+ * @brief Registers the built-in algorithms of the road networks.
+ */
+static AlgorithmRegistry<RoadSearchContext> createRoadAlgorithms()
+{
+    typedef SearchEngine<GeolocationGraph> *Created;
+    AlgorithmRegistry<RoadSearchContext> registry;
+    registry.add("dijkstra", "Dijkstra", "", true, false, [](RoadSearchContext &context) -> Created {
+        return new AStarEngine<RoadSearchContext, ZeroDistance>(context, ZeroDistance());
+    });
+    addWithRoadHeuristics<RoadAStarEngine>(registry, "astar", "A*", true);
+    addWithRoadHeuristics<RoadGreedyEngine>(registry, "greedy", "Greedy Best-first search",
+                                            false);
+    registry.add("bidijkstra", "Bidirectional Dijkstra", "", true, false,
+                 [](RoadSearchContext &context) -> Created {
+        return new BidirectionalEngine<RoadSearchContext, ZeroDistance>(context,
+                                                                        ZeroDistance());
+    });
+    addWithRoadHeuristics<RoadBidirectionalEngine>(registry, "biastar", "Bidirectional A*",
+                                                   true);
+    registry.add("ch", "Contraction Hierarchies", "", true, false,
+                 [](RoadSearchContext &context) -> Created {
+        return new ContractionEngine(context);
+    });
+    registry.add("alt", "ALT", "", true, false, [](RoadSearchContext &context) -> Created {
+        return new LandmarkEngine<RoadSearchContext>(context);
+    });
+    return registry;
+}
+
+const AlgorithmRegistry<GridSearchContext> &gridAlgorithms()
+{
+    static const AlgorithmRegistry<GridSearchContext> registry = createGridAlgorithms();
+    return registry;
+}
+
+const AlgorithmRegistry<RoadSearchContext> &roadAlgorithms()
+{
+    static const AlgorithmRegistry<RoadSearchContext> registry = createRoadAlgorithms();
+    return registry;
+}
+
+GridSearchContext::GridSearchContext(GridGraph *graph, const std::string &filename)
+    : graph(graph),
+      filename(filename),
+      reverseGraph(graph),
+      workspace(graph),
+      queue(graph),
+      bucketQueue(nullptr),
+      jumpPointTable(nullptr),
+      hierarchical(nullptr),
+      landmarks(nullptr),
+      parallelBidirectional(false)
+{
+}
+
+GridSearchContext::~GridSearchContext()
+{
+    delete bucketQueue;
+    delete jumpPointTable;
+    delete hierarchical;
+    delete landmarks;
+}
+
+GridGraph *GridSearchContext::getGraph() const
+{
+    return graph;
+}
+
+const ReverseGridGraph *GridSearchContext::getReverseGraph() const
+{
+    return &reverseGraph;
+}
+
+SearchWorkspace<GridGraph> &GridSearchContext::getWorkspace()
+{
+    return workspace;
+}
+
+IndexedHeapQueue<GridGraph> &GridSearchContext::getQueue()
+{
+    return queue;
+}
+
+BucketQueue<Tile> *GridSearchContext::getBucketQueue(int extraSpread)
+{
+    if (!canUseBucketQueue(graph))
+    {
+        return nullptr;
+    }
+    int maxSpread = int(graph->getMaxCost()) + extraSpread;
+    if (!bucketQueue)
+    {
+        bucketQueue = new BucketQueue<Tile>(maxSpread);
+    }
+    else
+    {
+        bucketQueue->reserveSpread(maxSpread);
+    }
+    return bucketQueue;
+}
+
+JumpPointTable *GridSearchContext::getJumpPointTable()
+{
+    if (!jumpPointTable)
+    {
+        std::string tableFilename = filename.empty() ? ""
+                                                     : JumpPointTable::tableFilename(filename);
+        jumpPointTable = new JumpPointTable(graph, tableFilename);
+        if (!tableFilename.empty() && !jumpPointTable->wasLoaded())
+        {
+            std::cout << "Saving JPS+ table to " << tableFilename << std::endl;
+            jumpPointTable->save(tableFilename);
+        }
+    }
+    return jumpPointTable;
+}
+
+HierarchicalSearch *GridSearchContext::getHierarchicalSearch()
+{
+    if (!hierarchical)
+    {
+        hierarchical = new HierarchicalSearch(graph);
+    }
+    return hierarchical;
+}
+
+LandmarkTable<GridGraph, ReverseGridGraph> *GridSearchContext::getLandmarks()
+{
+    typedef LandmarkTable<GridGraph, ReverseGridGraph> Table;
+    if (!landmarks)
+    {
+        std::string tableFilename = filename.empty() ? "" : Table::tableFilename(filename);
+        landmarks = new Table(graph, &reverseGraph, GRID_LANDMARK_COUNT, tableFilename);
+        if (!tableFilename.empty() && !landmarks->wasLoaded())
+        {
+            std::cout << "Saving ALT landmarks to " << tableFilename << std::endl;
+            landmarks->save(tableFilename);
+        }
+    }
+    return landmarks;
+}
+
+void GridSearchContext::setParallelBidirectional(bool enabled)
+{
+    parallelBidirectional = enabled;
+}
+
+bool GridSearchContext::isParallelBidirectional() const
+{
+    return parallelBidirectional;
+}
+
+RoadSearchContext::RoadSearchContext(GeolocationGraph *graph,
+                                     const GeolocationTable *geolocations,
+                                     const std::string &filename)
+    : graph(graph),
+      geolocations(geolocations),
+      filename(filename),
+      reverseGraph(graph->reversed()),
+      workspace(graph),
+      queue(graph),
+      hierarchy(nullptr),
+      landmarks(nullptr),
+      parallelBidirectional(false)
+{
+}
+
+RoadSearchContext::~RoadSearchContext()
+{
+    delete hierarchy;
+    delete landmarks;
+}
+
+GeolocationGraph *RoadSearchContext::getGraph() const
+{
+    return graph;
+}
+
+const GeolocationGraph *RoadSearchContext::getReverseGraph() const
+{
+    return &reverseGraph;
+}
+
+const GeolocationTable *RoadSearchContext::getGeolocations() const
+{
+    return geolocations;
+}
+
+SearchWorkspace<GeolocationGraph> &RoadSearchContext::getWorkspace()
+{
+    return workspace;
+}
+
+IndexedHeapQueue<GeolocationGraph> &RoadSearchContext::getQueue()
+{
+    return queue;
+}
+
+ContractionHierarchy *RoadSearchContext::getContractionHierarchy()
+{
+    if (!hierarchy)
+    {
+        hierarchy = new ContractionHierarchy(graph);
+    }
+    return hierarchy;
+}
+
+bool RoadSearchContext::hasContractionHierarchy() const
+{
+    return hierarchy != nullptr;
+}
+
+LandmarkTable<GeolocationGraph, GeolocationGraph> *RoadSearchContext::getLandmarks()
+{
+    typedef LandmarkTable<GeolocationGraph, GeolocationGraph> Table;
+    if (!landmarks)
+    {
+        std::string tableFilename = filename.empty() ? "" : Table::tableFilename(filename);
+        landmarks = new Table(graph, &reverseGraph, ROAD_LANDMARK_COUNT, tableFilename);
+        if (!tableFilename.empty() && !landmarks->wasLoaded())
+        {
+            std::cout << "Saving ALT landmarks to " << tableFilename << std::endl;
+            landmarks->save(tableFilename);
+        }
+    }
+    return landmarks;
+}
+
+void RoadSearchContext::setParallelBidirectional(bool enabled)
+{
+    parallelBidirectional = enabled;
+}
+
+bool RoadSearchContext::isParallelBidirectional() const
+{
+    return parallelBidirectional;
+}
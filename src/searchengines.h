@@ -0,0 +1,152 @@
+#ifndef SEARCHENGINES_H
+#define SEARCHENGINES_H
+
+#include <string>
+#include "algorithmregistry.hpp"
+#include "geolocationgraph.h"
+#include "gridgraph.h"
+#include "contraction.h"
+#include "hierarchical.h"
+#include "jpsplus.h"
+#include "landmarks.hpp"
+#include "priorityqueues.hpp"
+#include "reversegraph.hpp"
+#include "searchworkspace.hpp"
+
+/**
+ * @brief What the engines searching a grid share: the graph, the state of the searches,
+ * and the preprocessing used by several of them, which is built the first time it's
+ * needed.
+ *
+ * The JPS+ table and the landmarks are kept next to the file the grid was loaded from,
+ * if any, and only built when missing or outdated.
+ */
+class GridSearchContext
+{
+public:
+    typedef GridGraph Graph;
+    typedef ReverseGridGraph ReverseGraph;
+
+public:
+    /**
+     * @brief Prepares the searches on a graph, which must outlive the context.
+     * @param filename File the grid was loaded from, or an empty string to not keep the
+     * preprocessing in files.
+     */
+    explicit GridSearchContext(GridGraph *graph, const std::string &filename = "");
+
+    ~GridSearchContext();
+
+    GridGraph *getGraph() const;
+
+    const ReverseGridGraph *getReverseGraph() const;
+
+    SearchWorkspace<GridGraph> &getWorkspace();
+
+    IndexedHeapQueue<GridGraph> &getQueue();
+
+    /**
+     * @return A bucket queue for priorities up to the highest tile cost plus extraSpread
+     * over the lowest one, or nullptr if the costs of the grid aren't integral or are too
+     * high for one. The queue is shared by the searches, and kept while it's wide enough.
+     */
+    BucketQueue<Tile> *getBucketQueue(int extraSpread);
+
+    JumpPointTable *getJumpPointTable();
+
+    HierarchicalSearch *getHierarchicalSearch();
+
+    /**
+     * @brief The landmarks don't follow the changes to the grid.
+     */
+    LandmarkTable<GridGraph, ReverseGridGraph> *getLandmarks();
+
+    /**
+     * @brief Sets whether the bidirectional searches created from now on run each of
+     * their sides on a thread of its own.
+     */
+    void setParallelBidirectional(bool enabled);
+
+    bool isParallelBidirectional() const;
+
+private:
+    GridGraph *graph;
+    std::string filename;
+    ReverseGridGraph reverseGraph;
+    SearchWorkspace<GridGraph> workspace;
+    IndexedHeapQueue<GridGraph> queue;
+    BucketQueue<Tile> *bucketQueue;
+    JumpPointTable *jumpPointTable;
+    HierarchicalSearch *hierarchical;
+    LandmarkTable<GridGraph, ReverseGridGraph> *landmarks;
+    bool parallelBidirectional;
+};
+
+/**
+ * @brief What the engines searching a road network share, like GridSearchContext.
+ */
+class RoadSearchContext
+{
+public:
+    typedef GeolocationGraph Graph;
+    typedef GeolocationGraph ReverseGraph;
+
+public:
+    /**
+     * @brief Prepares the searches on a graph, and the table of the coordinates of its
+     * nodes, which must outlive the context.
+     * @param filename File the landmarks are kept next to, or an empty string to not
+     * keep them.
+     */
+    RoadSearchContext(GeolocationGraph *graph, const GeolocationTable *geolocations,
+                      const std::string &filename = "");
+
+    ~RoadSearchContext();
+
+    GeolocationGraph *getGraph() const;
+
+    const GeolocationGraph *getReverseGraph() const;
+
+    const GeolocationTable *getGeolocations() const;
+
+    SearchWorkspace<GeolocationGraph> &getWorkspace();
+
+    IndexedHeapQueue<GeolocationGraph> &getQueue();
+
+    ContractionHierarchy *getContractionHierarchy();
+
+    /**
+     * @return true if the contraction hierarchy has already been built.
+     */
+    bool hasContractionHierarchy() const;
+
+    LandmarkTable<GeolocationGraph, GeolocationGraph> *getLandmarks();
+
+    void setParallelBidirectional(bool enabled);
+
+    bool isParallelBidirectional() const;
+
+private:
+    GeolocationGraph *graph;
+    const GeolocationTable *geolocations;
+    std::string filename;
+    GeolocationGraph reverseGraph;
+    SearchWorkspace<GeolocationGraph> workspace;
+    IndexedHeapQueue<GeolocationGraph> queue;
+    ContractionHierarchy *hierarchy;
+    LandmarkTable<GeolocationGraph, GeolocationGraph> *landmarks;
+    bool parallelBidirectional;
+};
+
+/**
+ * @return The algorithms which can search a grid. New engines are registered here.
+ */
+const AlgorithmRegistry<GridSearchContext> &gridAlgorithms();
+
+/**
+ * @return The algorithms which can search a road network. New engines are registered
+ * here.
+ */
+const AlgorithmRegistry<RoadSearchContext> &roadAlgorithms();
+
+#endif // SEARCHENGINES_H
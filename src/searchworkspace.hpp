@@ -0,0 +1,209 @@
+#ifndef SEARCHWORKSPACE_H
+#define SEARCHWORKSPACE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <vector>
+
+/**
+ * @brief Search state kept in the previous/costToNode maps given by the caller.
+ *
+ * This is the state used by the map based versions of the algorithms. Closed nodes are
+ * tracked in a set of its own, since the caller's maps don't have room for them.
+ */
+template <typename Node>
+class MapSearchState
+{
+public:
+    MapSearchState(std::map<Node, Node> &previous, std::map<Node, double> &costToNode)
+        : previous(previous),
+          costToNode(costToNode)
+    {
+    }
+
+    /**
+     * @return true if the node has been reached by the search.
+     */
+    bool isVisited(const Node &node) const
+    {
+        return previous.find(node) != previous.end();
+    }
+
+    /**
+     * @return The cost of the best path found so far to a visited node.
+     */
+    double getCost(const Node &node) const
+    {
+        return costToNode.find(node)->second;
+    }
+
+    /**
+     * @return The node that comes before a visited node in the best path found so far.
+     */
+    Node getPrevious(const Node &node) const
+    {
+        return previous.find(node)->second;
+    }
+
+    /**
+     * @brief Prepares the state for a new search.
+     *
+     * The caller's maps are left untouched, only the closed set is cleared.
+     */
+    void reset()
+    {
+        closed.clear();
+    }
+
+    /**
+     * @brief Records a new best path to a node, reopening it if it was closed.
+     */
+    void update(const Node &node, const Node &from, double cost)
+    {
+        previous[node] = from;
+        costToNode[node] = cost;
+        closed.erase(node);
+    }
+
+    /**
+     * @brief Marks a node as expanded.
+     */
+    void close(const Node &node)
+    {
+        closed.insert(node);
+    }
+
+    /**
+     * @return true if the node has been expanded and not reopened since.
+     */
+    bool isClosed(const Node &node) const
+    {
+        return closed.find(node) != closed.end();
+    }
+
+private:
+    std::map<Node, Node> &previous;
+    std::map<Node, double> &costToNode;
+    std::set<Node> closed;
+};
+
+/**
+ * @brief Reusable search state for graphs whose nodes can be numbered from 0 to N-1.
+ *
+ * Parent, cost and closed information is kept in flat arrays sized to the graph, which
+ * are allocated once and shared by every search run with the workspace. Each entry is
+ * stamped with the generation of the search that wrote it, so starting a new search
+ * only needs to bump the generation instead of clearing the arrays.
+ *
+ * The graph must provide getNodeCount(), getNodeIndex(node) and getNode(index).
+ */
+template <typename Graph>
+class SearchWorkspace
+{
+public:
+    typedef typename Graph::Node Node;
+
+public:
+    /**
+     * @brief Creates a workspace for searches on the given graph.
+     *
+     * The graph must outlive the workspace, and its node count must not change.
+     */
+    explicit SearchWorkspace(const Graph *graph)
+        : graph(graph),
+          parents(graph->getNodeCount()),
+          costs(graph->getNodeCount()),
+          visitedStamps(graph->getNodeCount(), 0),
+          closedStamps(graph->getNodeCount(), 0),
+          generation(1)
+    {
+    }
+
+    /**
+     * @brief Forgets the previous search in constant time.
+     */
+    void reset()
+    {
+        ++generation;
+        if (generation == 0)
+        {
+            // The stamps wrapped around, so old stamps could look current again
+            std::fill(visitedStamps.begin(), visitedStamps.end(), 0);
+            std::fill(closedStamps.begin(), closedStamps.end(), 0);
+            generation = 1;
+        }
+    }
+
+    // The accessors below behave like the ones in MapSearchState
+
+    bool isVisited(const Node &node) const
+    {
+        return visitedStamps[graph->getNodeIndex(node)] == generation;
+    }
+
+    double getCost(const Node &node) const
+    {
+        return costs[graph->getNodeIndex(node)];
+    }
+
+    Node getPrevious(const Node &node) const
+    {
+        return graph->getNode(parents[graph->getNodeIndex(node)]);
+    }
+
+    void update(const Node &node, const Node &from, double cost)
+    {
+        int index = graph->getNodeIndex(node);
+        parents[index] = graph->getNodeIndex(from);
+        costs[index] = cost;
+        visitedStamps[index] = generation;
+        closedStamps[index] = 0;
+    }
+
+    void close(const Node &node)
+    {
+        closedStamps[graph->getNodeIndex(node)] = generation;
+    }
+
+    bool isClosed(const Node &node) const
+    {
+        return closedStamps[graph->getNodeIndex(node)] == generation;
+    }
+
+    /**
+     * @return The number of nodes the workspace has room for, which is the node count of
+     * the graph when the workspace was created.
+     */
+    int getNodeCount() const
+    {
+        return int(costs.size());
+    }
+
+    /**
+     * @return The memory used by the arrays of the workspace, in bytes.
+     */
+    size_t getMemoryUsage() const
+    {
+        return parents.capacity() * sizeof(int) + costs.capacity() * sizeof(double)
+                + (visitedStamps.capacity() + closedStamps.capacity()) * sizeof(uint32_t);
+    }
+
+    /**
+     * @return The graph this workspace was created for.
+     */
+    const Graph *getGraph() const
+    {
+        return graph;
+    }
+
+private:
+    const Graph *graph;
+    std::vector<int> parents;  // Index of the previous node
+    std::vector<double> costs;
+    std::vector<uint32_t> visitedStamps, closedStamps;
+    uint32_t generation;
+};
+
+#endif // SEARCHWORKSPACE_H
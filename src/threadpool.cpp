@@ -0,0 +1,155 @@
+#include "threadpool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(int threadCount)
+    : threadCount(threadCount),
+      task(nullptr),
+      generation(0),
+      busyThreads(0),
+      stopping(false)
+{
+    if (this->threadCount <= 0)
+    {
+        this->threadCount = std::max(1, int(std::thread::hardware_concurrency()));
+    }
+    for (int i = 0; i < this->threadCount; ++i)
+    {
+        queues.push_back(new Queue);
+    }
+    for (int i = 1; i < this->threadCount; ++i)
+    {
+        threads.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+    for (Queue *queue : queues)
+    {
+        delete queue;
+    }
+}
+
+int ThreadPool::getThreadCount() const
+{
+    return threadCount;
+}
+
+void ThreadPool::run(int count, const std::function<void(int, int)> &task)
+{
+    if (count <= 0)
+    {
+        return;
+    }
+    // Give each thread a run of consecutive items
+    for (int i = 0; i < threadCount; ++i)
+    {
+        std::lock_guard<std::mutex> lock(queues[i]->mutex);
+        int begin = int(long(count) * i / threadCount);
+        int end = int(long(count) * (i + 1) / threadCount);
+        for (int item = begin; item < end; ++item)
+        {
+            queues[i]->items.push_back(item);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->task = &task;
+        error = nullptr;
+        busyThreads = threadCount - 1;
+        ++generation;
+    }
+    wakeCondition.notify_all();
+    work(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    doneCondition.wait(lock, [this]() { return busyThreads == 0; });
+    this->task = nullptr;
+    if (error)
+    {
+        std::exception_ptr thrown = error;
+        error = nullptr;
+        std::rethrow_exception(thrown);
+    }
+}
+
+void ThreadPool::workerLoop(int thread)
+{
+    unsigned seenGeneration = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeCondition.wait(lock, [&]() {
+                return stopping || generation != seenGeneration;
+            });
+            if (stopping)
+            {
+                return;
+            }
+            seenGeneration = generation;
+        }
+        work(thread);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busyThreads == 0)
+        {
+            doneCondition.notify_all();
+        }
+    }
+}
+
+void ThreadPool::work(int thread)
+{
+    int item;
+    while (takeItem(thread, item))
+    {
+        try
+        {
+            (*task)(item, thread);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error)
+            {
+                error = std::current_exception();
+            }
+        }
+    }
+}
+
+bool ThreadPool::takeItem(int thread, int &item)
+{
+    {
+        Queue &own = *queues[thread];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.items.empty())
+        {
+            item = own.items.back();
+            own.items.pop_back();
+            return true;
+        }
+    }
+    // Steal from the other threads, starting with the next one so thieves spread out
+    for (int i = 1; i < threadCount; ++i)
+    {
+        Queue &victim = *queues[(thread + i) % threadCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.items.empty())
+        {
+            item = victim.items.front();
+            victim.items.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
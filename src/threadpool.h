@@ -0,0 +1,79 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Pool of threads which share the items of a batch by work stealing.
+ *
+ * The items of a batch are split into equal runs, one for each thread. A thread takes
+ * items from the back of its own run, and once it's done steals from the front of the
+ * others', so threads which get the long items don't hold back the rest. The threads are
+ * started once and wait between batches, and the thread starting a batch works on it
+ * too.
+ */
+class ThreadPool
+{
+public:
+    /**
+     * @brief Starts the given number of threads, or as many as the hardware runs at once
+     * if it's 0, counting the one running the batches.
+     */
+    explicit ThreadPool(int threadCount = 0);
+
+    ~ThreadPool();
+
+    int getThreadCount() const;
+
+    /**
+     * @brief Runs task(item, thread) for every item from 0 to count - 1, and waits for
+     * all of them to finish.
+     *
+     * The thread is a number from 0 to getThreadCount() - 1, so each thread can keep its
+     * own state. If a task throws, the rest of the batch still runs, and then the first
+     * exception is rethrown.
+     */
+    void run(int count, const std::function<void(int, int)> &task);
+
+private:
+    typedef struct Queue
+    {
+        std::mutex mutex;
+        std::deque<int> items;
+    } Queue;
+
+    void workerLoop(int thread);
+
+    /**
+     * @brief Runs the items of the current batch until there are none left.
+     */
+    void work(int thread);
+
+    /**
+     * @brief Takes an item from the thread's own queue, or steals one from another.
+     * @return false if every queue is empty.
+     */
+    bool takeItem(int thread, int &item);
+
+private:
+    int threadCount;
+    std::vector<std::thread> threads;  // All but the first
+    std::vector<Queue*> queues;  // One for each thread
+
+    // State of the current batch, guarded by the mutex
+    std::mutex mutex;
+    std::condition_variable wakeCondition, doneCondition;
+    const std::function<void(int, int)> *task;
+    unsigned generation;
+    int busyThreads;
+    bool stopping;
+    std::exception_ptr error;
+};
+
+#endif // THREADPOOL_H
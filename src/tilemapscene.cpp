@@ -3,11 +3,13 @@
 #include <QPainter>
 #include <QDebug>
 #include <QGraphicsPixmapItem>
-#include "algorithms.hpp"
 #include "csvencoder.h"
 #include "graph.h"
 #include "utils.h"
 
+// Names of the heuristics in the grid algorithm registry, in the order of eHeuristic
+static const char *HEURISTIC_NAMES[] = {"manhattan", "euclidean", "chebyshev", "octile"};
+
 /**
  * @brief Rounds the value to the nearest multiple of step
  */
@@ -62,7 +64,9 @@ TilemapScene::TilemapScene(QObject *parent, int width, int height)
       paintingLine(false),
       paintingRect(false),
       graph(nullptr),
-      selectedAlgorithm(A_STAR),
+      context(nullptr),
+      engine(nullptr),
+      selectedAlgorithm("A*"),
       selectedHeuristic(MANHATTAN),
       showCost(false),
       showGrid(true),
@@ -81,6 +85,8 @@ TilemapScene::~TilemapScene()
 {
     clearPath();
     clearText();
+    delete engine;
+    delete context;
     delete graph;
     delete startPixmap;
     delete goalPixmap;
@@ -137,70 +143,52 @@ void TilemapScene::movePixmapToTile(QGraphicsPixmapItem *item, Tile tile)
     item->setPos(pos);
 }
 
-void TilemapScene::setAlgorithm(int index)
+void TilemapScene::setAlgorithm(const std::string &title)
 {
-    selectedAlgorithm = static_cast<eAlgorithm>(index);
+    selectedAlgorithm = title;
+    updateEngine();
     recomputePath();
 }
 
 void TilemapScene::setHeuristic(int index)
 {
     selectedHeuristic = static_cast<eHeuristic>(index);
+    // The engines are built for a single heuristic
+    updateEngine();
     recomputePath();
 }
 
+void TilemapScene::updateEngine()
+{
+    const AlgorithmRegistry<GridSearchContext>::Entry *entry =
+            gridAlgorithms().find(selectedAlgorithm, HEURISTIC_NAMES[selectedHeuristic]);
+    delete engine;
+    engine = entry ? entry->create(*context) : nullptr;
+}
+
 void TilemapScene::recomputePath()
 {
     clearText();
     clearPath();
-    std::map<Tile, Tile> previous;
-    std::map<Tile, double> costToNode;
-
-    // Use pertinent heuristic function
-    Heuristic<Tile> heuristic;
-    switch (selectedHeuristic)
-    {
-    case MANHATTAN:
-        heuristic = manhattanDistance;
-        break;
-    case EUCLIDEAN:
-        heuristic = euclideanDistance;
-        break;
-    case CHEBYSHEV:
-        heuristic = chebyshevDistance;
-        break;
-    case OCTILE:
-        heuristic = octileDistance;
-        break;
-    }
-
-    // Use pertinent algorithm
-    switch (selectedAlgorithm)
-    {
-    case A_STAR:
-        aStar(graph, startTile, goalTile, previous, costToNode, heuristic);
-        break;
-    case DIJKSTRA:
-        dijkstra(graph, startTile, goalTile, previous, costToNode);
-        break;
-    case BFS:
-        bfs(graph, startTile, goalTile, previous, costToNode);
-        break;
-    case GREEDY_BEST_FIRST:
-        greedyBestFirstSearch(graph, startTile, goalTile, previous, costToNode, heuristic);
-        break;
+    if (!engine)
+    {
+        return;
     }
 
+    // Some engines, like LPA*, only redo the part of their last search affected by the
+    // edits since then
+    engine->search(startTile, goalTile);
+
     // Only paint the path if a solution exists
-    if (previous.find(goalTile) != previous.end())
+    if (engine->getCost() >= 0)
     {
-        std::vector<Tile> path = reconstructPath(startTile, goalTile, previous);
-        paintPath(path);
+        paintPath(engine->getPath());
     }
 
     // If the option is checked, paint tile costs
     if (showCost)
     {
+        std::map<Tile, double> costToNode = engine->getCosts();
         paintTileCosts(costToNode);
     }
 }
@@ -270,6 +258,20 @@ void TilemapScene::saveGraphToFile(std::string filename)
 {
     CSVEncoder encoder(filename);
     encoder.saveGridGraph(graph, startTile, goalTile);
+    try
+    {
+        context->getJumpPointTable()->save(JumpPointTable::tableFilename(filename));
+    }
+    catch (const std::exception &ex)
+    {
+        showErrorMessage("Error saving the JPS+ table.");
+    }
+}
+
+void TilemapScene::loadJumpPointTable(std::string filename)
+{
+    // The table built for the graph is kept if the saved one is missing or outdated
+    context->getJumpPointTable()->load(JumpPointTable::tableFilename(filename));
 }
 
 QPoint TilemapScene::getStartPointPosition()
@@ -502,6 +504,8 @@ void TilemapScene::clearText()
 
 void TilemapScene::init()
 {
+    delete engine;
+    delete context;
     delete graph;
     int left = -width / 2,
             top = -height / 2;
@@ -515,6 +519,9 @@ void TilemapScene::init()
         --top;
     }
     graph = new GridGraph(left, top, width, height);
+    context = new GridSearchContext(graph);
+    engine = nullptr;
+    updateEngine();
     setUpEndpoints();
 
     // Compute initial path
@@ -523,8 +530,13 @@ void TilemapScene::init()
 
 void TilemapScene::init(GridGraph *newGraph, Tile &start, Tile &goal)
 {
+    delete engine;
+    delete context;
     delete graph;
     graph = newGraph;
+    context = new GridSearchContext(graph);
+    engine = nullptr;
+    updateEngine();
     // The map may have weights, so we need to paint the tiles accordingly
     repaintScene();
     setUpEndpoints(start, goal);
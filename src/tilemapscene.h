@@ -4,6 +4,7 @@
 #include <QGraphicsScene>
 #include <QGraphicsSceneMouseEvent>
 #include "gridgraph.h"
+#include "searchengines.h"
 
 const int GRID_SIZE = 30;
 const QColor GRID_COLOR = QColor(200, 200, 255, 255);
@@ -23,7 +24,6 @@ const QColor PATH_COLOR = QColor(250, 240, 65, 255);
 class TilemapScene : public QGraphicsScene
 {
 public:
-    enum eAlgorithm {A_STAR, DIJKSTRA, BFS, GREEDY_BEST_FIRST};
     enum eHeuristic {MANHATTAN, EUCLIDEAN, CHEBYSHEV, OCTILE};
     enum ePaintMode {PENCIL, BUCKET, LINE, RECT};
 
@@ -61,10 +61,9 @@ public:
 
     /**
      * @brief Sets the currently active algorithm to be used for the path computation.
-     * @param index Index of the algorithm combo box in the main window, which maps to
-     * an algorithm via the Algorithm enum.
+     * @param title Title of the algorithm in the grid algorithm registry.
      */
-    void setAlgorithm(int index);
+    void setAlgorithm(const std::string &title);
 
     /**
      * @brief Sets the currently active heuristic, for the algorithms that use one.
@@ -114,8 +113,17 @@ public:
      */
     void setPaintMode(ePaintMode mode);
 
+    /**
+     * @brief Saves the graph to a CSV file, and its JPS+ table next to it.
+     */
     void saveGraphToFile(std::string filename);
 
+    /**
+     * @brief Replaces the JPS+ table with the one saved next to the given CSV file, if it
+     * was saved for the current walls and movement settings.
+     */
+    void loadJumpPointTable(std::string filename);
+
     QPoint getStartPointPosition();
 
 private slots:
@@ -158,6 +166,11 @@ private:
      */
     void recomputePath();
 
+    /**
+     * @brief Replaces the engine with the one of the selected algorithm and heuristic.
+     */
+    void updateEngine();
+
     /**
      * @brief Paints a path given as a list of tiles using the color defined by a
      * constant.
@@ -247,10 +260,12 @@ private:
     QColor selectedColor;
     double selectedWeight;
     GridGraph *graph;
+    GridSearchContext *context;  // Its preprocessing is kept up to date while painting
+    SearchEngine<GridGraph> *engine;
     Tile startTile, goalTile, previousPosition;
     QGraphicsPixmapItem *startPixmap, *goalPixmap, *grabbedPixmap;
     std::vector<QGraphicsLineItem*> pathLines;
-    eAlgorithm selectedAlgorithm;
+    std::string selectedAlgorithm;
     eHeuristic selectedHeuristic;
     std::vector<QGraphicsSimpleTextItem*> tileTexts;
     bool showCost, showGrid;
@@ -63,6 +63,7 @@ void TilemapView::loadGraphFromFile(std::string filename)
     Tile start = encoder.getStartTile();
     Tile goal = encoder.getGoalTile();
     init(newGraph, start, goal);
+    tilemap->loadJumpPointTable(filename);
 }
 
 void TilemapView::mousePressEvent(QMouseEvent *ev)
@@ -3,6 +3,21 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include "searchengines.h"
+
+/**
+ * @brief Prints the names of the algorithms of a registry, comma-separated.
+ */
+template <typename Context>
+static void printAlgorithmNames(const AlgorithmRegistry<Context> &registry)
+{
+    std::vector<std::string> names;
+    for (const auto &entry : registry.getEntries())
+    {
+        names.push_back(entry.name);
+    }
+    std::cout << joinParts(names, ",") << std::endl;
+}
 
 void showErrorMessage(std::string msg)
 {
@@ -21,7 +36,20 @@ void printUsage()
     std::cout << "Usage:" << std::endl;
     std::cout << "pathfinding [command] [option]" << std::endl;
     std::cout << "Available commands:" << std::endl;
-    std::cout << "-b FILENAME COUNT\t\tRun randomized benchmark using the graph and coordinates from DIMACS COUNT times." << std::endl;
+    std::cout << "-b FILENAME COUNT [-p] [-c] [-w N] [-r N] [-t N] [-s N] [--algorithms LIST] [--compare BASELINE]\tRun randomized benchmark using the graph and coordinates from DIMACS COUNT times." << std::endl;
+    std::cout << "\t\t\t\tIf FILENAME is a MovingAI .scen file, run up to COUNT of its problems from each bucket instead (all if 0)." << std::endl;
+    std::cout << "\t\t\t\tWith -p, bidirectional searches run each side on its own thread." << std::endl;
+    std::cout << "\t\t\t\tWith -c, the hardware performance counters of each search are recorded too, if the kernel allows them." << std::endl;
+    std::cout << "\t\t\t\tWith -w and -r, each search runs N untimed times, then N timed times (1 by default)." << std::endl;
+    std::cout << "\t\t\t\tWith -t, batches of queries run on N threads (all cores by default)." << std::endl;
+    std::cout << "\t\t\t\tWith -s, the random start and goal nodes are picked with seed N (the same one by default)." << std::endl;
+    std::cout << "\t\t\t\tWith --algorithms, only the comma-separated algorithms in LIST run, in its order." << std::endl;
+    std::cout << "\t\t\t\tThe results are written to benchmark.json. With --compare, they're compared with the ones in BASELINE, written by an earlier run," << std::endl;
+    std::cout << "\t\t\t\tand the exit code is -3 if any algorithm got significantly slower, expands more nodes or finds different distances." << std::endl;
+    std::cout << "Grid algorithms: ";
+    printAlgorithmNames(gridAlgorithms());
+    std::cout << "Road network algorithms: ";
+    printAlgorithmNames(roadAlgorithms());
 }
 
 std::vector<std::string> splitLine(std::string line, std::string delimiter)
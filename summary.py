@@ -1,51 +1,46 @@
 import argparse
 import numpy as np
-from benchplot import get_data
+from benchplot import get_columns, get_data, get_groups
 
 
-def compute_total(data, column):
-    nodes_columns = ['f' + str(n) for n in range(1, 12, 3)]
+def compute_total(data, column, label):
     result = np.sum(data[column])
-    if column in nodes_columns:
-        print(f"Total nodes: {result}")
-    else:
-        print(f"Total time: {result}")
+    print(f"Total {label}: {result}")
 
 
-def compute_success(data, column):
-    # Compare distance to Dijkstra's distance which is in field 0
-    success_array = data[column] == data['f0']
+def compute_success(data, column, reference):
+    # Compare distance to the reference distance, Dijkstra's if it ran
+    success_array = data[column] == data[reference]
     success = np.sum(success_array)
     print(f"Times succeeded: {success}")
 
 
-def run_summary(data):
-    # Dijkstra
-    print("Dijkstra\n----------")
-    compute_total(data, 'f1')
-    compute_total(data, 'f2')
-    compute_success(data, 'f0')
-    print()
-
-    # A*
-    print("A*\n----------")
-    compute_total(data, 'f4')
-    compute_total(data, 'f5')
-    compute_success(data, 'f3')
-    print()
-
-    # A*(alt)
-    print("A*(alt)\n----------")
-    compute_total(data, 'f7')
-    compute_total(data, 'f8')
-    compute_success(data, 'f6')
-    print()
-
-    # Greedy
-    print("Greedy\n----------")
-    compute_total(data, 'f10')
-    compute_total(data, 'f11')
-    compute_success(data, 'f9')
+def run_summary(data, columns):
+    # Every algorithm has a column group named after it, like dijkstraDist, dijkstraNodes,
+    # dijkstraTime, dijkstraAllocations and dijkstraPeakBytes, followed by its performance
+    # counters if they were recorded
+    reference = 'f' + str(columns.index('dijkstraDist')) if 'dijkstraDist' in columns else 'f0'
+    groups = get_groups(columns)
+    for i, (name, first) in enumerate(groups):
+        if i > 0:
+            print()
+        last = groups[i + 1][1] if i + 1 < len(groups) else len(columns)
+        summarize_algorithm(data, columns, name, first, last, reference)
+
+
+def summarize_algorithm(data, columns, name, first, last, reference):
+    print(f"{name}\n----------")
+    compute_total(data, 'f' + str(first + 1), "nodes")
+    compute_total(data, 'f' + str(first + 2), "time")
+    compute_success(data, 'f' + str(first), reference)
+    # Heap allocations and peak heap usage of the searches
+    print(f"Mean allocations per query: {np.mean(data['f' + str(first + 3)])}")
+    print(f"Mean peak bytes per query: {np.mean(data['f' + str(first + 4)])}")
+    # Mean of each performance counter, skipping the ones which weren't available
+    for column in range(first + 5, last):
+        values = data['f' + str(column)]
+        if np.all(values >= 0):
+            print(f"Mean {columns[column][len(name):]}: {np.mean(values)}")
 
 
 def main():
@@ -53,8 +48,7 @@ def main():
     parser.add_argument('-f', type=str, help="Filename with the benchmark data", required=True)
     args = parser.parse_args()
 
-    data = get_data(args.f)
-    run_summary(data)
+    run_summary(get_data(args.f), get_columns(args.f))
 
 
 if __name__ == "__main__":